@@ -228,6 +228,20 @@ uint8_t oldval;
     return (uint8_t) oldval;
 }
 
+#  if defined(__x86_64__)
+//Compare-and-swap 128 bits (cmpxchg16b); target must be 16-byte aligned
+static inline unsigned __int128 cas_uint128(volatile unsigned __int128* target,
+                                            unsigned __int128 o, unsigned __int128 n) {
+  uint64_t lo = (uint64_t) o, hi = (uint64_t) (o >> 64);
+  __asm__ __volatile__("lock; cmpxchg16b %0"
+        : "+m" (*target), "+a" (lo), "+d" (hi)
+        : "b" ((uint64_t) n), "c" ((uint64_t) (n >> 64))
+        : "memory", "cc");
+
+  return ((unsigned __int128) hi << 64) | lo;
+}
+#  endif
+
 //atomic operations interface
 //Compare-and-swap
 #  define CAS_PTR(a,b,c) __sync_val_compare_and_swap(a,b,c)
@@ -235,6 +249,9 @@ uint8_t oldval;
 #  define CAS_U16(a,b,c) __sync_val_compare_and_swap(a,b,c)
 #  define CAS_U32(a,b,c) __sync_val_compare_and_swap(a,b,c)
 #  define CAS_U64(a,b,c) __sync_val_compare_and_swap(a,b,c)
+#  if defined(__x86_64__)
+#    define CAS_U128(a,b,c) cas_uint128(a,b,c)
+#  endif
 //Swap
 #  define SWAP_PTR(a,b) swap_pointer(a,b)
 #  define SWAP_U8(a,b) swap_uint8(a,b)
@@ -0,0 +1,59 @@
+/*
+ *   File: bandwidth.h
+ *   Description: streaming kernels of the BANDWIDTH event
+ *   bandwidth.h is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _BANDWIDTH_H_
+#define _BANDWIDTH_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#define BW_CHUNK_ALIGN 4096	/* every core streams over a page-aligned chunk */
+
+typedef enum
+  {
+    BW_READ,
+    BW_WRITE,
+    BW_RMW,
+    BW_COPY,			/* first half of the chunk to the second half */
+    BW_NT_WRITE,		/* non-temporal (streaming) stores */
+    BW_NUM_KERNELS,
+  } bw_kernel_t;
+
+extern const char* bw_kernel_des[];
+
+/* one pass over bytes (a multiple of 128) at buf; returns a checksum so that */
+/* the loads cannot be optimized away */
+typedef uint64_t (*bw_fn_t)(void* buf, size_t bytes);
+
+/* picks the widest implementation the cpu supports; *isa names it */
+bw_fn_t bw_select(const bw_kernel_t kernel, const char** isa);
+/* bytes read plus bytes written by one pass over bytes */
+size_t bw_bytes_moved(const bw_kernel_t kernel, const size_t bytes);
+int bw_parse_kernel(const char* arg);
+
+#endif	/* _BANDWIDTH_H_ */
@@ -38,7 +38,9 @@
 #  include <sys/procset.h>
 #endif /* __sparc */
 
-#define NUM_BARRIERS 16
+#define BARRIER_SET 16		/* the barriers of one group of threads */
+#define BARRIER_SETS 8		/* groups that synchronize independently (--concurrent) */
+#define NUM_BARRIERS (BARRIER_SET * BARRIER_SETS)
 #define BARRIER_MEM_FILE "/barrier_mem"
 
 #ifndef ALIGNED
@@ -60,6 +62,7 @@ typedef ALIGNED(64) struct barrier
 } barrier_t;
 
 
+int color_all(int id);
 void barriers_init(const uint32_t num_procs);
 void barrier_init(const uint32_t barrier_num, const uint64_t participants, int (*color)(int), const uint32_t);
 void barrier_wait(const uint32_t barrier_num, const uint32_t id, const uint32_t total_cores);
@@ -67,6 +67,14 @@ extern cpu_set_t cpus;
 #include "common.h"
 #include "pfd.h"
 #include "barrier.h"
+#include "locks.h"
+#include "bandwidth.h"
+#include "ring.h"
+#include "topology.h"
+#include "lockfree.h"
+#include "sweep.h"
+#include "report.h"
+#include "cpu_features.h"
 
 typedef struct cache_line
 {
@@ -117,6 +125,28 @@ typedef enum
     PROFILER,
     PAUSE,
     NOP,
+    CAS_THROUGHPUT,
+    FAI_THROUGHPUT,
+    SWAP_THROUGHPUT,
+    TAS_THROUGHPUT,
+    LOCK_UNCONTENDED,
+    LOCK_HANDOFF,
+    LOCK_THROUGHPUT,
+    PINGPONG,
+    FALSE_SHARING,
+    BANDWIDTH,
+    MLP,
+    LITMUS_SB,			/* store buffering */
+    LITMUS_MP,			/* message passing */
+    LITMUS_LB,			/* load buffering */
+    LITMUS_IRIW,		/* independent reads of independent writes */
+    TLB_SWEEP,
+    RING,
+    BROADCAST,
+    ATOMIC_MATRIX,
+    FETCH_OP,
+    SMT_INTERFERENCE,
+    LOCKFREE,
     NUM_EVENTS,			/* placeholder for printing the num of events */
   } moesi_type_t;
 
@@ -156,14 +186,35 @@ const char* moesi_type_des[] =
     "PROFILER",
     "PAUSE",
     "NOP",
+    "CAS_THROUGHPUT",
+    "FAI_THROUGHPUT",
+    "SWAP_THROUGHPUT",
+    "TAS_THROUGHPUT",
+    "LOCK_UNCONTENDED",
+    "LOCK_HANDOFF",
+    "LOCK_THROUGHPUT",
+    "PINGPONG",
+    "FALSE_SHARING",
+    "BANDWIDTH",
+    "MLP",
+    "LITMUS_SB",
+    "LITMUS_MP",
+    "LITMUS_LB",
+    "LITMUS_IRIW",
+    "TLB_SWEEP",
+    "RING",
+    "BROADCAST",
+    "ATOMIC_MATRIX",
+    "FETCH_OP",
+    "SMT_INTERFERENCE",
+    "LOCKFREE",
   };
 
 
 #define DEFAULT_CORES       2
 #define DEFAULT_REPS        10000
 #define DEFAULT_TEST        0
-static uint32_t default_cores[] = {0,1,2};
-#define DEFAULT_CORES_ARRAY default_cores
+#define DEFAULT_CORES_ARRAY NULL	/* the first allowed cpus, see assign_default_cores_array */
 #define DEFAULT_CORE_OTHERS 0
 #define DEFAULT_FLUSH       0
 #define DEFAULT_VERBOSE     0
@@ -173,25 +224,246 @@ static uint32_t default_cores[] = {0,1,2};
 #define DEFAULT_LFENCE       0
 #define DEFAULT_SFENCE       0
 #define DEFAULT_AO_SUCCESS  0
+#define DEFAULT_DURATION    1000 /* ms, for the fixed-duration events */
+#define DEFAULT_LINES       1
+#define DEFAULT_SCALE       0
+#define DEFAULT_LOCK        LOCK_TAS
+#define DEFAULT_CS_LENGTH   0
+#define LOCK_HANDOFF_DELAY  2000 /* cycles the releasing core waits so that the other is already spinning */
+#define DEFAULT_SEPARATE    0
+#define DEFAULT_PAUSE       0
+#define PINGPONG_WARMUP     128	/* untimed round trips before the measurements */
+#define PINGPONG_LINE_FLAGS 16	/* flags that fit in one line without --separate-lines */
+#define DEFAULT_RING        RING_SPSC
+#define DEFAULT_PAYLOAD     16	/* bytes per message, including the 8-byte timestamp */
+#define DEFAULT_BATCH       16	/* messages per index update of SPSC_BATCH */
+#define BROADCAST_DELAY     2000 /* cycles the writer waits so that the readers are already spinning */
+#define LITMUS_MAX_DELAY    64	/* LITMUS_*: PAUSEs a thread waits at most after the go flag */
+
+typedef enum
+  {
+    FOP_FAI,			/* native fetch-and-increment */
+    FOP_CAS_FAI,		/* fetch-and-increment as a CAS retry loop */
+    FOP_CAS_MAX,		/* atomic max as a CAS retry loop */
+    FOP_CAS_BACKOFF,		/* reload + CAS with exponential backoff after a failure */
+    FOP_NUM_KINDS,
+  } fop_kind_t;
+
+const char* fop_kind_des[] =
+  {
+    "native FAI",
+    "CAS-loop FAI",
+    "CAS-loop max",
+    "CAS with backoff",
+  };
+
+typedef enum
+  {
+    SMT_IDLE,			/* the sibling sleeps */
+    SMT_PAUSE,			/* spins with PAUSE */
+    SMT_SPIN,			/* spins without PAUSE */
+    SMT_MEMORY,			/* chases a random chain over --mem-size */
+    SMT_ALU,			/* dependent multiplies */
+    SMT_NUM_LOADS,
+  } smt_load_t;
+
+const char* smt_load_des[] =
+  {
+    "idle",
+    "PAUSE spin",
+    "busy spin",
+    "memory-bound",
+    "ALU-bound",
+  };
+
+#define DEFAULT_SMT_PAIR    0
+#define DEFAULT_LF_STRUCT   LF_TREIBER
+#define DEFAULT_UPDATE_RATIO 50	/* % pushes / enqueues / increments in LOCKFREE */
+#define SMT_PROBE_BYTES     (16 * 1024) /* the pointer-chase probe stays in L1 */
+#define SMT_PROBE_OPS       256
+#define SMT_WARMUP          100000 /* cycles for the sibling's load to ramp up */
+
+typedef enum
+  {
+    MATRIX_OFF,
+    MATRIX_CSV,
+    MATRIX_JSON,
+  } matrix_format_t;
+
+#define DEFAULT_MATRIX      MATRIX_OFF
+
+typedef enum
+  {
+    PLACE_NONE,			/* -x, or the first allowed cpus */
+    PLACE_PAIR,			/* --pair: two cores with the given relation */
+    PLACE_SPREAD,		/* --spread: the domains of a level in turn */
+    PLACE_COMPACT,		/* --compact: as close together as possible */
+  } placement_t;
+
+const char* placement_des[] =
+  {
+    "cores_array",
+    "pair",
+    "spread",
+    "compact",
+  };
+
+/* --pair, by topo_relation_t */
+const char* pair_des[] =
+  {
+    "same-cpu",
+    "smt",
+    "same-l2",
+    "same-l3",
+    "same-socket",
+    "cross-socket",
+  };
+
+#define DEFAULT_PLACEMENT   PLACE_NONE
+#define MATRIX_BARRIER      1	/* the one barrier B0-B14 leave free: all the workers of --matrix */
+#define MATRIX_Z95          1.96 /* 95% confidence interval of a cell's mean */
+#define MATRIX_IDLE_US      50	/* poll interval of the workers outside the measured pair */
+#define DEFAULT_CONCURRENT  1
+#define MATRIX_VERIFY_SHARE 10	/* --concurrent: 1 in 10 cells is measured again in isolation */
+#define MATRIX_T_CRIT       3.0	/* |Welch t| above which a cell counts as shifted */
+#define SWEEP_MAX_WORKERS   256	/* --sweep: pinned threads, a cpu once per use in one configuration */
+#define DEFAULT_TARGET_CI   0	/* %, 0: every cell runs --repetitions */
+#define DEFAULT_BUDGET      0	/* s, 0: no limit */
+#define ADAPT_MAX_BATCHES   64	/* --target-ci: batches of --repetitions per cell at most */
+#define DEFAULT_FORMAT      REPORT_TEXT
+#define REPORT_NUM_QS       4	/* the percentiles of a --format record */
+
+typedef enum
+  {
+    FS_SAME_LINE,		/* word i of one line */
+    FS_TWO_LINES,		/* cores alternate between two adjacent lines */
+    FS_PADDED_LINE,		/* one line (64 bytes) per core */
+    FS_PADDED_PAIR,		/* one adjacent-line pair (128 bytes) per core */
+    FS_NUM_LAYOUTS,
+  } fs_layout_t;
+
+const char* fs_layout_des[] =
+  {
+    "same line",
+    "two lines",
+    "padded to 64 bytes",
+    "padded to 128 bytes",
+  };
+
+#define DEFAULT_FS_LAYOUT   FS_SAME_LINE
+#define DEFAULT_BW_KERNEL   BW_READ
+#define DEFAULT_SWEEP_MEM   0
+#define SWEEP_MIN_SIZE      (4 * 1024)
+#define SWEEP_LOADS         1024 /* dependent loads per sample of --sweep-mem */
+#define SWEEP_WARMUP_LOADS  (4 * 1024 * 1024)
+#define SWEEP_PLATEAU_JUMP  1.25 /* a point > 1.25x the plateau start leaves the plateau */
+#define SWEEP_PLATEAU_FLAT  1.10 /* two consecutive points within 1.10x start a new one */
+#define DEFAULT_CHAINS      16
+#define DEFAULT_WIDTH       0	/* bits; 0 = the event's own width (32, 8 for TAS) */
+#define DEFAULT_OFFSET      0
+
+typedef enum
+  {
+    HINT_NONE,
+    HINT_PREFETCHT0,		/* before the timed load / store */
+    HINT_PREFETCHW,		/* before the timed load / store */
+    HINT_CLDEMOTE,		/* after every store */
+    HINT_NUM_TYPES,
+  } hint_type_t;
+
+const char* hint_type_des[] =
+  {
+    "none",
+    "prefetcht0",
+    "prefetchw",
+    "cldemote",
+  };
+
+typedef enum
+  {
+    FLUSH_CLFLUSH,
+    FLUSH_CLFLUSHOPT,
+    FLUSH_CLWB,			/* write back, the line may stay cached */
+    FLUSH_NUM_TYPES,
+  } flush_type_t;
+
+const char* flush_type_des[] =
+  {
+    "clflush",
+    "clflushopt",
+    "clwb",
+  };
+
+typedef enum
+  {
+    STORE_WORD,			/* one 32-bit word: read-for-ownership */
+    STORE_AVX,			/* two 32-byte vmovdqa */
+    STORE_AVX512,		/* one 64-byte vmovdqa64 */
+    STORE_MOVNTI,		/* eight 8-byte non-temporal stores */
+    STORE_MOVNTDQ,		/* four 16-byte non-temporal stores */
+    STORE_NUM_KINDS,
+  } store_kind_t;
+
+const char* store_kind_des[] =
+  {
+    "word",
+    "AVX",
+    "AVX-512",
+    "movnti",
+    "movntdq",
+  };
+
+#define DEFAULT_STORE_KIND    STORE_WORD
+
+typedef enum
+  {
+    CHAIN_RANDOM,		/* random over the whole buffer */
+    CHAIN_IN_PAGE,		/* random within a page, then on to the next page */
+    CHAIN_PAGE_STRIDE,		/* one random line per page, pages in order */
+    CHAIN_PAGE_RANDOM,		/* one random line per page, pages in random order */
+    CHAIN_NUM_MODES,
+  } chain_mode_t;
+
+const char* chain_mode_des[] =
+  {
+    "random",
+    "in-page",
+    "page-stride",
+    "page-random",
+  };
+
+#define DEFAULT_CHAIN_MODE    CHAIN_RANDOM
+#define PAGE_SIZE_4K          (4 * 1024UL)
+#define PAGE_SIZE_2M          (2 * 1024 * 1024UL)
+#define PAGE_SIZE_1G          (1024 * 1024 * 1024UL)
+#define DEFAULT_PAGE_SIZE     PAGE_SIZE_4K
+#define TLB_DELTA_MIN         2.0 /* cycles of 4K over huge pages that count as TLB misses */
+#define DEFAULT_HINT          HINT_NONE
+#define DEFAULT_HINT_DISTANCE 0	/* cycles between the prefetch and the timed access */
+#define DEFAULT_FLUSH_INSN    FLUSH_CLFLUSH
+#define MLP_MAX_CHAINS      64
+#define MLP_STEPS           256	/* steps of every chain per sample of MLP */
+#define MLP_KNEE            1.10 /* chains beyond the first m within 1.10x of the best latency do not help */
 
 
 #define CACHE_LINE_MEM_FILE "/cache_line"
 
-#define B0 _mm_mfence(); barrier_wait(0, ID, test_cores); _mm_mfence();
-#define B1 _mm_mfence(); barrier_wait(2, ID, test_cores); _mm_mfence();
-#define B2 _mm_mfence(); barrier_wait(3, ID, test_cores); _mm_mfence();
-#define B3 _mm_mfence(); barrier_wait(4, ID, test_cores); _mm_mfence();
-#define B4 _mm_mfence(); barrier_wait(5, ID, test_cores); _mm_mfence();
-#define B5 _mm_mfence(); barrier_wait(6, ID, test_cores); _mm_mfence();
-#define B6 _mm_mfence(); barrier_wait(7, ID, test_cores); _mm_mfence();
-#define B7 _mm_mfence(); barrier_wait(8, ID, test_cores); _mm_mfence();
-#define B8 _mm_mfence(); barrier_wait(9, ID, test_cores); _mm_mfence();
-#define B9 _mm_mfence(); barrier_wait(10, ID, test_cores); _mm_mfence();
-#define B10 _mm_mfence(); barrier_wait(11, ID, test_cores); _mm_mfence();
-#define B11 _mm_mfence(); barrier_wait(12, ID, test_cores); _mm_mfence();
-#define B12 _mm_mfence(); barrier_wait(13, ID, test_cores); _mm_mfence();
-#define B13 _mm_mfence(); barrier_wait(14, ID, test_cores); _mm_mfence();
-#define B14 _mm_mfence(); barrier_wait(15, ID, test_cores); _mm_mfence();
+#define B0 _mm_mfence(); barrier_wait(barrier_base + 0, ID, test_cores); _mm_mfence();
+#define B1 _mm_mfence(); barrier_wait(barrier_base + 2, ID, test_cores); _mm_mfence();
+#define B2 _mm_mfence(); barrier_wait(barrier_base + 3, ID, test_cores); _mm_mfence();
+#define B3 _mm_mfence(); barrier_wait(barrier_base + 4, ID, test_cores); _mm_mfence();
+#define B4 _mm_mfence(); barrier_wait(barrier_base + 5, ID, test_cores); _mm_mfence();
+#define B5 _mm_mfence(); barrier_wait(barrier_base + 6, ID, test_cores); _mm_mfence();
+#define B6 _mm_mfence(); barrier_wait(barrier_base + 7, ID, test_cores); _mm_mfence();
+#define B7 _mm_mfence(); barrier_wait(barrier_base + 8, ID, test_cores); _mm_mfence();
+#define B8 _mm_mfence(); barrier_wait(barrier_base + 9, ID, test_cores); _mm_mfence();
+#define B9 _mm_mfence(); barrier_wait(barrier_base + 10, ID, test_cores); _mm_mfence();
+#define B10 _mm_mfence(); barrier_wait(barrier_base + 11, ID, test_cores); _mm_mfence();
+#define B11 _mm_mfence(); barrier_wait(barrier_base + 12, ID, test_cores); _mm_mfence();
+#define B12 _mm_mfence(); barrier_wait(barrier_base + 13, ID, test_cores); _mm_mfence();
+#define B13 _mm_mfence(); barrier_wait(barrier_base + 14, ID, test_cores); _mm_mfence();
+#define B14 _mm_mfence(); barrier_wait(barrier_base + 15, ID, test_cores); _mm_mfence();
+#define BM _mm_mfence(); barrier_wait(MATRIX_BARRIER, ID, matrix_workers); _mm_mfence();
 
 #define XSTR(s)                         STR(s)
 #define STR(s)                          #s
@@ -237,31 +509,13 @@ set_cpu(int cpu)
   printf("Requested cpu: %d, now running on cpu: %d\n",cpu, sched_getcpu());
 #endif
 
-#ifdef OPTERON
-  uint32_t numa_node = cpu/6;
-  numa_set_preferred(numa_node);  
-#elif defined(XEON)
-  uint32_t numa_node = 0;
-  if (cpu == 0)
-    {
-      numa_node = 4;
-    }
-  else if (cpu <= 40)
-    {
-      numa_node = (cpu - 1) / 10;
-    }
-  else
-    {
-      numa_node = cpu / 10;
-    }
-  numa_set_preferred(numa_node);  
-#elif defined(PLATFORM_NUMA)
-  printf("* You need to define how cores correspond to mem nodes in ccbench.h\n");
-#endif 
-  
+#if !defined(__sparc__) && !defined(__tile__)
+  /* the node of the cpu, from the topology discovered at startup */
+  topo_prefer_node(cpu);
+#endif
 }
 
-inline void 
+static inline void 
 wait_cycles(volatile uint64_t cycles)
 {
   /* cycles >>= 1; */
@@ -0,0 +1,83 @@
+/*
+ *   File: cpu_features.h
+ *   Description: runtime CPUID checks and wrappers of the optional cache-control instructions
+ *   cpu_features.h is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _CPU_FEATURES_H_
+#define _CPU_FEATURES_H_
+
+#include <inttypes.h>
+#include "atomic_ops.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <cpuid.h>
+
+static inline uint32_t
+cpu_feature(uint32_t leaf, uint32_t subleaf, uint32_t reg, uint32_t bit)
+{
+  uint32_t r[4] = { 0, 0, 0, 0 };
+  if (!__get_cpuid_count(leaf, subleaf, &r[0], &r[1], &r[2], &r[3]))
+    {
+      return 0;
+    }
+  return (r[reg] >> bit) & 1;
+}
+
+#  define CPU_EAX 0
+#  define CPU_EBX 1
+#  define CPU_ECX 2
+#  define CPU_EDX 3
+
+#  define cpu_has_prefetchw()  cpu_feature(0x80000001, 0, CPU_ECX, 8)
+#  define cpu_has_clflushopt() cpu_feature(7, 0, CPU_EBX, 23)
+#  define cpu_has_clwb()       cpu_feature(7, 0, CPU_EBX, 24)
+#  define cpu_has_cldemote()   cpu_feature(7, 0, CPU_ECX, 25)
+/* AVX needs the OS to save the registers too, which __builtin_cpu_supports checks */
+#  define cpu_has_avx()        (__builtin_cpu_init(), __builtin_cpu_supports("avx"))
+#  define cpu_has_avx512f()    (__builtin_cpu_init(), __builtin_cpu_supports("avx512f"))
+
+#  define PREFETCHT0(x) asm volatile("prefetcht0 %0" :: "m" (*(volatile char*) (x)))
+#  define CLFLUSHOPT(x) asm volatile("clflushopt %0" : "+m" (*(volatile char*) (x)))
+#  define CLWB(x)       asm volatile("clwb %0" : "+m" (*(volatile char*) (x)))
+#  define CLDEMOTE(x)   asm volatile("cldemote %0" : "+m" (*(volatile char*) (x)))
+
+#else  /* !x86 */
+
+#  define cpu_has_prefetchw()  1
+#  define cpu_has_clflushopt() 0
+#  define cpu_has_clwb()       0
+#  define cpu_has_cldemote()   0
+#  define cpu_has_avx()        0
+#  define cpu_has_avx512f()    0
+
+#  define PREFETCHT0(x) __builtin_prefetch((const void*) (x), 0, 3)
+#  define CLFLUSHOPT(x) _mm_clflush(x)
+#  define CLWB(x)       _mm_clflush(x)
+#  define CLDEMOTE(x)
+
+#endif	/* x86 */
+
+#endif	/* _CPU_FEATURES_H_ */
@@ -0,0 +1,314 @@
+/*
+ *   File: lockfree.h
+ *   Description: lock-free stacks, queue and counters of the LOCKFREE event
+ *   lockfree.h is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _LOCKFREE_H_
+#define _LOCKFREE_H_
+
+#include <inttypes.h>
+#include "common.h"
+#include "atomic_ops.h"
+#include "barrier.h"
+
+#define LF_NODES_PER_THREAD 4096
+#define LF_SHARD_SPACING    16	/* 64-bit words between two shards: 128 bytes */
+
+typedef enum
+  {
+    LF_TREIBER,			/* Treiber stack, plain pointer CAS (ABA-prone) */
+    LF_TREIBER_TAGGED,		/* Treiber stack, pointer + tag with cmpxchg16b */
+    LF_MS_QUEUE,		/* Michael-Scott queue with counted pointers */
+    LF_COUNTER,			/* one FAI counter */
+    LF_SHARDED_COUNTER,		/* one FAI counter per thread, reads sum them */
+    LF_NUM_STRUCTS,
+  } lf_struct_t;
+
+extern const char* lf_struct_des[];
+
+/* next and next_tag form the counted pointer of the queue; the stacks only */
+/* use next (the tag of the tagged stack is in its top) */
+typedef struct lf_node
+{
+  struct lf_node* volatile next;
+  volatile uint64_t next_tag;
+  uint64_t value;
+  struct lf_node* free;		/* the free list of the thread that owns it now */
+} ALIGNED(16) lf_node_t;
+
+typedef struct lf
+{
+  lf_struct_t kind;
+  uint32_t num_shards;
+  volatile uint64_t* shards;
+  lf_node_t* nodes;
+  ALIGNED(64) volatile uint64_t top[2];	/* stacks: pointer, tag */
+  ALIGNED(64) volatile uint64_t head[2]; /* queue: counted pointers */
+  ALIGNED(64) volatile uint64_t tail[2];
+  ALIGNED(64) volatile uint64_t counter;
+} lf_t;
+
+/* the per-thread part: its free nodes, shard and CAS counts */
+typedef struct lf_local
+{
+  lf_node_t* free;
+  uint32_t id;
+  uint64_t cas;
+  uint64_t cas_failed;
+} lf_local_t;
+
+lf_t* lf_new(const lf_struct_t kind, const uint32_t num_threads);
+void lf_local_init(lf_t* lf, lf_local_t* local, const uint32_t id);
+int lf_parse_struct(const char* arg);
+/* nodes in the stack or queue, at most limit (a corrupted stack may be a cycle) */
+uint64_t lf_size(lf_t* lf, const uint64_t limit);
+
+#if defined(CAS_U128)
+typedef unsigned __int128 lf_tagged_t;
+#  define LF_PTR(t)       ((lf_node_t*) (uintptr_t) (uint64_t) (t))
+#  define LF_TAG(t)       ((uint64_t) ((t) >> 64))
+#  define LF_MAKE(p, tag) (((lf_tagged_t) (tag) << 64) | (uint64_t) (uintptr_t) (p))
+#  define LF_AT(a)        ((volatile lf_tagged_t*) (a))
+#endif
+
+static inline int
+lf_cas_ptr(lf_local_t* local, volatile uint64_t* a, lf_node_t* o, lf_node_t* n)
+{
+  local->cas++;
+  if (CAS_PTR((lf_node_t* volatile*) a, o, n) == o)
+    {
+      return 1;
+    }
+  local->cas_failed++;
+  return 0;
+}
+
+#if defined(CAS_U128)
+static inline int
+lf_cas_tagged(lf_local_t* local, volatile void* a, lf_tagged_t o, lf_tagged_t n)
+{
+  local->cas++;
+  if (CAS_U128(LF_AT(a), o, n) == o)
+    {
+      return 1;
+    }
+  local->cas_failed++;
+  return 0;
+}
+
+/* two plain loads; the CAS that follows catches a torn value */
+static inline lf_tagged_t
+lf_load_tagged(volatile void* a)
+{
+  volatile uint64_t* w = (volatile uint64_t*) a;
+  uint64_t tag = w[1];
+  uint64_t ptr = w[0];
+  return LF_MAKE(ptr, tag);
+}
+#endif
+
+static inline void
+lf_free(lf_local_t* local, lf_node_t* n)
+{
+  n->free = local->free;
+  local->free = n;
+}
+
+/* push / enqueue / increment; returns 0 if the thread has no free node */
+static inline int
+lf_update(lf_t* lf, lf_local_t* local, uint64_t value)
+{
+  lf_node_t* n = local->free;
+  switch (lf->kind)
+    {
+    case LF_COUNTER:
+      FAI_U64(&lf->counter);
+      return 1;
+    case LF_SHARDED_COUNTER:
+      FAI_U64(&lf->shards[local->id * LF_SHARD_SPACING]);
+      return 1;
+    default:
+      break;
+    }
+
+  if (n == NULL)
+    {
+      return 0;
+    }
+  local->free = n->free;
+  n->value = value;
+
+  switch (lf->kind)
+    {
+    case LF_TREIBER:
+      {
+	lf_node_t* t;
+	do
+	  {
+	    t = (lf_node_t*) (uintptr_t) lf->top[0];
+	    n->next = t;
+	  }
+	while (!lf_cas_ptr(local, &lf->top[0], t, n));
+	break;
+      }
+#if defined(CAS_U128)
+    case LF_TREIBER_TAGGED:
+      {
+	lf_tagged_t t;
+	do
+	  {
+	    t = lf_load_tagged(lf->top);
+	    n->next = LF_PTR(t);
+	  }
+	while (!lf_cas_tagged(local, lf->top, t, LF_MAKE(n, LF_TAG(t) + 1)));
+	break;
+      }
+    case LF_MS_QUEUE:
+      {
+	lf_tagged_t tail, next;
+	n->next = NULL;
+	while (1)
+	  {
+	    tail = lf_load_tagged(lf->tail);
+	    next = lf_load_tagged(&LF_PTR(tail)->next);
+	    if (tail != lf_load_tagged(lf->tail))
+	      {
+		continue;
+	      }
+	    if (LF_PTR(next) == NULL)
+	      {
+		if (lf_cas_tagged(local, &LF_PTR(tail)->next, next, LF_MAKE(n, LF_TAG(next) + 1)))
+		  {
+		    break;
+		  }
+	      }
+	    else
+	      {
+		lf_cas_tagged(local, lf->tail, tail, LF_MAKE(LF_PTR(next), LF_TAG(tail) + 1));
+	      }
+	  }
+	lf_cas_tagged(local, lf->tail, tail, LF_MAKE(n, LF_TAG(tail) + 1));
+	break;
+      }
+#endif
+    default:
+      break;
+    }
+  return 1;
+}
+
+/* pop / dequeue / read; returns 0 if the structure is empty */
+static inline int
+lf_other(lf_t* lf, lf_local_t* local, uint64_t* value)
+{
+  switch (lf->kind)
+    {
+    case LF_COUNTER:
+      *value = lf->counter;
+      return 1;
+    case LF_SHARDED_COUNTER:
+      {
+	uint64_t sum = 0;
+	uint32_t s;
+	for (s = 0; s < lf->num_shards; s++)
+	  {
+	    sum += lf->shards[s * LF_SHARD_SPACING];
+	  }
+	*value = sum;
+	return 1;
+      }
+    case LF_TREIBER:
+      {
+	lf_node_t* t;
+	do
+	  {
+	    t = (lf_node_t*) (uintptr_t) lf->top[0];
+	    if (t == NULL)
+	      {
+		return 0;
+	      }
+	  }
+	while (!lf_cas_ptr(local, &lf->top[0], t, t->next));
+	*value = t->value;
+	lf_free(local, t);
+	return 1;
+      }
+#if defined(CAS_U128)
+    case LF_TREIBER_TAGGED:
+      {
+	lf_tagged_t t;
+	do
+	  {
+	    t = lf_load_tagged(lf->top);
+	    if (LF_PTR(t) == NULL)
+	      {
+		return 0;
+	      }
+	  }
+	while (!lf_cas_tagged(local, lf->top, t, LF_MAKE(LF_PTR(t)->next, LF_TAG(t) + 1)));
+	*value = LF_PTR(t)->value;
+	lf_free(local, LF_PTR(t));
+	return 1;
+      }
+    case LF_MS_QUEUE:
+      {
+	lf_tagged_t head, tail, next;
+	while (1)
+	  {
+	    head = lf_load_tagged(lf->head);
+	    tail = lf_load_tagged(lf->tail);
+	    next = lf_load_tagged(&LF_PTR(head)->next);
+	    if (head != lf_load_tagged(lf->head))
+	      {
+		continue;
+	      }
+	    if (LF_PTR(head) == LF_PTR(tail))
+	      {
+		if (LF_PTR(next) == NULL)
+		  {
+		    return 0;
+		  }
+		lf_cas_tagged(local, lf->tail, tail, LF_MAKE(LF_PTR(next), LF_TAG(tail) + 1));
+	      }
+	    else
+	      {
+		*value = LF_PTR(next)->value;
+		if (lf_cas_tagged(local, lf->head, head, LF_MAKE(LF_PTR(next), LF_TAG(head) + 1)))
+		  {
+		    break;
+		  }
+	      }
+	  }
+	lf_free(local, LF_PTR(head));	/* the old dummy */
+	return 1;
+      }
+#endif
+    default:
+      return 0;
+    }
+}
+
+#endif	/* _LOCKFREE_H_ */
@@ -0,0 +1,240 @@
+/*
+ *   File: locks.h
+ *   Description: spin-lock algorithms built on atomic_ops.h, used by the LOCK_* events
+ *   locks.h is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _LOCKS_H_
+#define _LOCKS_H_
+
+#include <inttypes.h>
+#include <pthread.h>
+#include "common.h"
+#include "atomic_ops.h"
+#include "barrier.h"
+
+#define LOCK_BACKOFF_MIN 16	/* TTAS backoff window, in PAUSE()s */
+#define LOCK_BACKOFF_MAX 1024
+
+typedef enum
+  {
+    LOCK_TAS,
+    LOCK_TTAS,
+    LOCK_TICKET,
+    LOCK_ARRAY,
+    LOCK_MCS,
+    LOCK_CLH,
+    LOCK_MUTEX,
+    LOCK_NUM_TYPES,
+  } lock_type_t;
+
+extern const char* lock_type_des[];
+
+typedef ALIGNED(64) struct mcs_qnode
+{
+  struct mcs_qnode* volatile next;
+  volatile uint32_t waiting;
+} mcs_qnode_t;
+
+typedef ALIGNED(64) struct lock_qnode
+{
+  volatile uint32_t locked;	/* CLH: holder or waiter / array: may enter */
+} lock_qnode_t;
+
+typedef ALIGNED(64) struct lock
+{
+  lock_type_t type;
+  uint32_t num_slots;		/* array lock, a power of two */
+  lock_qnode_t* slots;		/* array lock */
+  pthread_mutex_t mutex;
+  ALIGNED(64) volatile uint32_t word; /* TAS, TTAS */
+  volatile uint32_t ticket_next;
+  volatile uint32_t ticket_owner;
+  volatile uint32_t array_tail;
+  mcs_qnode_t* volatile mcs_tail;
+  lock_qnode_t* volatile clh_tail;
+} lock_t;
+
+/* the per-thread part of a lock (queue node, array slot) */
+typedef struct lock_local
+{
+  mcs_qnode_t* mcs;
+  lock_qnode_t* clh;
+  lock_qnode_t* clh_pred;
+  uint32_t slot;
+} lock_local_t;
+
+lock_t* lock_new(const lock_type_t type, const uint32_t num_threads);
+void lock_local_init(lock_t* lock, lock_local_t* local);
+int lock_parse_type(const char* arg);
+
+static inline void
+lock_backoff(uint32_t* window)
+{
+  uint32_t i;
+  for (i = 0; i < *window; i++)
+    {
+      PAUSE();
+    }
+  if (*window < LOCK_BACKOFF_MAX)
+    {
+      *window <<= 1;
+    }
+}
+
+static inline void
+lock_acquire(lock_t* lock, lock_local_t* local)
+{
+  switch (lock->type)
+    {
+    case LOCK_TAS:
+      while (TAS_U8((volatile uint8_t*) &lock->word))
+	{
+	  PAUSE();
+	}
+      break;
+    case LOCK_TTAS:
+      {
+	uint32_t window = LOCK_BACKOFF_MIN;
+	while (1)
+	  {
+	    while (*(volatile uint8_t*) &lock->word)
+	      {
+		PAUSE();
+	      }
+	    if (TAS_U8((volatile uint8_t*) &lock->word) == 0)
+	      {
+		break;
+	      }
+	    lock_backoff(&window);
+	  }
+	break;
+      }
+    case LOCK_TICKET:
+      {
+	uint32_t me = FAI_U32(&lock->ticket_next);
+	while (lock->ticket_owner != me)
+	  {
+	    PAUSE();
+	  }
+	break;
+      }
+    case LOCK_ARRAY:
+      {
+	uint32_t slot = FAI_U32(&lock->array_tail) & (lock->num_slots - 1);
+	while (!lock->slots[slot].locked)
+	  {
+	    PAUSE();
+	  }
+	lock->slots[slot].locked = 0;
+	local->slot = slot;
+	break;
+      }
+    case LOCK_MCS:
+      {
+	mcs_qnode_t* me = local->mcs;
+	me->next = NULL;
+	me->waiting = 1;
+	mcs_qnode_t* pred = (mcs_qnode_t*) SWAP_PTR((volatile void*) &lock->mcs_tail, (void*) me);
+	if (pred != NULL)
+	  {
+	    pred->next = me;
+	    while (me->waiting)
+	      {
+		PAUSE();
+	      }
+	  }
+	break;
+      }
+    case LOCK_CLH:
+      {
+	lock_qnode_t* me = local->clh;
+	me->locked = 1;
+	lock_qnode_t* pred = (lock_qnode_t*) SWAP_PTR((volatile void*) &lock->clh_tail, (void*) me);
+	while (pred->locked)
+	  {
+	    PAUSE();
+	  }
+	local->clh_pred = pred;
+	break;
+      }
+    case LOCK_MUTEX:
+    default:
+      pthread_mutex_lock(&lock->mutex);
+      break;
+    }
+}
+
+static inline void
+lock_release(lock_t* lock, lock_local_t* local)
+{
+  switch (lock->type)
+    {
+    case LOCK_TAS:
+    case LOCK_TTAS:
+      asm volatile ("" ::: "memory");
+      *(volatile uint8_t*) &lock->word = 0;
+      break;
+    case LOCK_TICKET:
+      asm volatile ("" ::: "memory");
+      lock->ticket_owner++;
+      break;
+    case LOCK_ARRAY:
+      asm volatile ("" ::: "memory");
+      lock->slots[(local->slot + 1) & (lock->num_slots - 1)].locked = 1;
+      break;
+    case LOCK_MCS:
+      {
+	mcs_qnode_t* me = local->mcs;
+	if (me->next == NULL)
+	  {
+	    if (CAS_PTR(&lock->mcs_tail, me, NULL) == me)
+	      {
+		break;
+	      }
+	    while (me->next == NULL)
+	      {
+		PAUSE();
+	      }
+	  }
+	me->next->waiting = 0;
+	break;
+      }
+    case LOCK_CLH:
+      {
+	lock_qnode_t* me = local->clh;
+	local->clh = local->clh_pred; /* recycle the predecessor's node */
+	asm volatile ("" ::: "memory");
+	me->locked = 0;
+	break;
+      }
+    case LOCK_MUTEX:
+    default:
+      pthread_mutex_unlock(&lock->mutex);
+      break;
+    }
+}
+
+#endif	/* _LOCKS_H_ */
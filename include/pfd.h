@@ -172,7 +172,11 @@ void pfd_collect_abs_deviation(uint32_t store, uint32_t num_vals, uint32_t num_p
 
 void pfd_store_init(const uint32_t num_entries);
 void get_abs_deviation(volatile ticks* vals, const size_t num_vals, abs_deviation_t* abs_dev);
+void get_abs_deviation_all(volatile ticks* vals, const size_t num_vals, abs_deviation_t* abs_dev);
+void merge_abs_deviation(abs_deviation_t* acc, const abs_deviation_t* batch);
 void print_abs_deviation(const abs_deviation_t* abs_dev);
+void get_percentiles(volatile ticks* vals, const size_t num_vals, const double* qs, double* out,
+                     const uint32_t num_qs);
 
 
 #endif	/* _PFD_H_ */
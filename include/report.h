@@ -0,0 +1,59 @@
+/*
+ *   File: report.h
+ *   Description: records of the results as csv or json (--format)
+ *   report.h is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef _REPORT_H_
+#define _REPORT_H_
+
+#include <inttypes.h>
+#include <stdio.h>
+
+typedef enum
+  {
+    REPORT_TEXT,		/* the PRINT lines only */
+    REPORT_CSV,			/* a header, then one line per record */
+    REPORT_JSON,		/* an array of one object per record */
+    REPORT_NUM_FORMATS,
+  } report_format_t;
+
+extern const char* report_format_des[];
+
+typedef struct report report_t;
+
+/* every record must have the fields of the first one, in the same order */
+report_t* report_open(const report_format_t format, FILE* out);
+void report_begin(report_t* r);
+void report_str(report_t* r, const char* key, const char* value);
+void report_uint(report_t* r, const char* key, const uint64_t value);
+void report_real(report_t* r, const char* key, const double value);
+void report_end(report_t* r);
+/* ends the output and closes out unless it is stdout */
+void report_close(report_t* r);
+int report_parse_format(const char* arg);
+
+#endif	/* _REPORT_H_ */
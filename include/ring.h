@@ -0,0 +1,244 @@
+/*
+ *   File: ring.h
+ *   Description: single- and multi-producer rings of the RING event
+ *   ring.h is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <inttypes.h>
+#include <string.h>
+#include "common.h"
+#include "atomic_ops.h"
+#include "barrier.h"
+
+#define RING_SLOTS       1024	/* power of two */
+#define RING_MIN_PAYLOAD 8	/* the enqueue timestamp */
+#define RING_MAX_PAYLOAD 4096
+
+typedef enum
+  {
+    RING_SPSC,			/* Lamport: both sides read the other's index every time */
+    RING_SPSC_CACHED,		/* both sides keep a copy of the other's index */
+    RING_SPSC_BATCH,		/* cached, and the indices are published every batch messages */
+    RING_MPMC,			/* bounded queue with a sequence number per slot */
+    RING_NUM_KINDS,
+  } ring_kind_t;
+
+extern const char* ring_kind_des[];
+
+/* a slot is the sequence number (MPMC only) followed by the payload */
+typedef struct ring
+{
+  ring_kind_t kind;
+  uint32_t mask;
+  uint32_t slot_size;		/* bytes, a multiple of 8 */
+  uint32_t payload;
+  uint32_t batch;
+  uint8_t* slots;
+  ALIGNED(64) volatile uint64_t head; /* next slot to dequeue */
+  ALIGNED(64) volatile uint64_t tail; /* next slot to enqueue */
+  ALIGNED(64) volatile uint32_t producers_done;
+} ring_t;
+
+/* the per-thread part of a ring: the private copies of the indices */
+typedef struct ring_local
+{
+  uint64_t head;
+  uint64_t tail;
+  uint64_t cached_head;		/* the consumer's index as last seen by the producer */
+  uint64_t cached_tail;		/* the producer's index as last seen by the consumer */
+  uint64_t published;		/* SPSC_BATCH: the own index as last written to the ring */
+} ring_local_t;
+
+ring_t* ring_new(const ring_kind_t kind, const uint32_t payload, const uint32_t batch);
+void ring_local_init(ring_t* ring, ring_local_t* local);
+int ring_parse_kind(const char* arg);
+
+static inline volatile uint64_t*
+ring_seq(ring_t* ring, uint64_t pos)
+{
+  return (volatile uint64_t*) (ring->slots + (pos & ring->mask) * ring->slot_size);
+}
+
+static inline void*
+ring_payload(ring_t* ring, uint64_t pos)
+{
+  return ring->slots + (pos & ring->mask) * ring->slot_size + sizeof(uint64_t);
+}
+
+/* returns 0 if the ring is full */
+static inline int
+ring_enqueue(ring_t* ring, ring_local_t* local, const void* msg)
+{
+  switch (ring->kind)
+    {
+    case RING_SPSC:
+      if (local->tail - ring->head == ring->mask + 1)
+	{
+	  return 0;
+	}
+      memcpy(ring_payload(ring, local->tail), msg, ring->payload);
+      asm volatile ("" ::: "memory");
+      ring->tail = ++local->tail;
+      return 1;
+    case RING_SPSC_CACHED:
+    case RING_SPSC_BATCH:
+      if (local->tail - local->cached_head == ring->mask + 1)
+	{
+	  local->cached_head = ring->head;
+	  if (local->tail - local->cached_head == ring->mask + 1)
+	    {
+	      if (ring->kind == RING_SPSC_BATCH && local->published != local->tail)
+		{
+		  ring->tail = local->published = local->tail; /* do not hold back a full ring */
+		}
+	      return 0;
+	    }
+	}
+      memcpy(ring_payload(ring, local->tail), msg, ring->payload);
+      asm volatile ("" ::: "memory");
+      local->tail++;
+      if (ring->kind == RING_SPSC_CACHED || local->tail - local->published >= ring->batch)
+	{
+	  ring->tail = local->published = local->tail;
+	}
+      return 1;
+    case RING_MPMC:
+    default:
+      {
+	uint64_t pos = ring->tail;
+	while (1)
+	  {
+	    int64_t dif = (int64_t) (*ring_seq(ring, pos) - pos);
+	    if (dif == 0)
+	      {
+		uint64_t cur = CAS_U64(&ring->tail, pos, pos + 1);
+		if (cur == pos)
+		  {
+		    break;
+		  }
+		pos = cur;
+	      }
+	    else if (dif < 0)
+	      {
+		return 0;
+	      }
+	    else
+	      {
+		pos = ring->tail;
+	      }
+	  }
+	memcpy(ring_payload(ring, pos), msg, ring->payload);
+	asm volatile ("" ::: "memory");
+	*ring_seq(ring, pos) = pos + 1;
+	return 1;
+      }
+    }
+}
+
+/* returns 0 if the ring is empty */
+static inline int
+ring_dequeue(ring_t* ring, ring_local_t* local, void* msg)
+{
+  switch (ring->kind)
+    {
+    case RING_SPSC:
+      if (local->head == ring->tail)
+	{
+	  return 0;
+	}
+      memcpy(msg, ring_payload(ring, local->head), ring->payload);
+      asm volatile ("" ::: "memory");
+      ring->head = ++local->head;
+      return 1;
+    case RING_SPSC_CACHED:
+    case RING_SPSC_BATCH:
+      if (local->head == local->cached_tail)
+	{
+	  local->cached_tail = ring->tail;
+	  if (local->head == local->cached_tail)
+	    {
+	      if (ring->kind == RING_SPSC_BATCH && local->published != local->head)
+		{
+		  ring->head = local->published = local->head; /* give the consumed slots back while idle */
+		}
+	      return 0;
+	    }
+	}
+      memcpy(msg, ring_payload(ring, local->head), ring->payload);
+      asm volatile ("" ::: "memory");
+      local->head++;
+      if (ring->kind == RING_SPSC_CACHED || local->head - local->published >= ring->batch)
+	{
+	  ring->head = local->published = local->head;
+	}
+      return 1;
+    case RING_MPMC:
+    default:
+      {
+	uint64_t pos = ring->head;
+	while (1)
+	  {
+	    int64_t dif = (int64_t) (*ring_seq(ring, pos) - (pos + 1));
+	    if (dif == 0)
+	      {
+		uint64_t cur = CAS_U64(&ring->head, pos, pos + 1);
+		if (cur == pos)
+		  {
+		    break;
+		  }
+		pos = cur;
+	      }
+	    else if (dif < 0)
+	      {
+		return 0;
+	      }
+	    else
+	      {
+		pos = ring->head;
+	      }
+	  }
+	memcpy(msg, ring_payload(ring, pos), ring->payload);
+	asm volatile ("" ::: "memory");
+	*ring_seq(ring, pos) = pos + ring->mask + 1;
+	return 1;
+      }
+    }
+}
+
+/* publishes what a batching producer still holds back */
+static inline void
+ring_flush(ring_t* ring, ring_local_t* local)
+{
+  if (ring->kind == RING_SPSC_BATCH)
+    {
+      asm volatile ("" ::: "memory");
+      ring->tail = local->published = local->tail;
+    }
+}
+
+#endif	/* _RING_H_ */
@@ -0,0 +1,90 @@
+/*
+ *   File: sweep.h
+ *   Description: expansion of the --sweep specifications and their resumable output
+ *   sweep.h is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef _SWEEP_H_
+#define _SWEEP_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define SWEEP_MAX_CORES  64	/* cores of one configuration */
+#define SWEEP_MAX_VALUES 256	/* values of one key */
+#define SWEEP_MAX_CONFIGS (1 << 20)
+#define SWEEP_MAX_FENCE  9
+#define SWEEP_SPEC_LEN   4096
+
+/* one point of the cartesian product */
+typedef struct
+{
+  uint32_t test;
+  uint32_t fence;
+  uint32_t stride;
+  size_t mem_size;
+  uint32_t hint;
+  uint32_t num_cores;
+  uint32_t cores[SWEEP_MAX_CORES];
+} sweep_config_t;
+
+typedef struct
+{
+  sweep_config_t* configs;	/* test outermost, hint innermost */
+  uint32_t num_configs;
+  char spec[SWEEP_SPEC_LEN];	/* the keys in that order, ';'-separated: identifies the sweep */
+  size_t max_mem_size;
+  uint32_t max_cores;
+} sweep_t;
+
+/* arg is a file or an inline spec of key=values entries, separated by ';' or */
+/* new lines ('#' starts a comment). The keys are test, fence, stride, mem, */
+/* cores and hint; a key left out takes its value from defaults. Values are */
+/* ','-separated: */
+/*   test    names or indices, a-b for the indices in between */
+/*   fence   0-9, a-b for the levels in between */
+/*   stride  lines, a-b doubling from a up to b */
+/*   mem     bytes with an optional K, M or G, a-b doubling from a up to b */
+/*   cores   [x,y,...] for those cpus, n or a-b for the first n of defaults->cores */
+/*   hint    names or indices, a-b for the indices in between */
+/* exits on errors */
+sweep_t* sweep_parse(const char* arg, const sweep_config_t* defaults, int (*parse_test)(const char*),
+		     int (*parse_hint)(const char*));
+/* the cpus to pin one worker on each, a cpu as many times as one configuration */
+/* uses it; returns their number */
+uint32_t sweep_workers(const sweep_t* sweep, uint32_t* workers, uint32_t max);
+/* rank_of[w]: the rank worker w takes in config, -1 if it sits the config out */
+void sweep_ranks(const sweep_config_t* config, const uint32_t* workers, uint32_t num_workers, int32_t* rank_of);
+/* FNV-1a over every field of every configuration, so the keys the spec leaves */
+/* to the defaults count as well */
+uint64_t sweep_digest(const sweep_t* sweep);
+/* opens path for the rows of the sweep identified by signature: a new file gets */
+/* the signature and the header as its first two lines; an existing one with the */
+/* same lines is resumed after its *done complete rows (a cut-off row is dropped) */
+FILE* sweep_open(const char* path, const char* signature, const char* header, uint32_t* done);
+
+#endif	/* _SWEEP_H_ */
@@ -0,0 +1,99 @@
+/*
+ *   File: topology.h
+ *   Description: cpu and NUMA topology from sysfs (libnuma with PLATFORM_NUMA): how two cpus relate
+ *   topology.h is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _TOPOLOGY_H_
+#define _TOPOLOGY_H_
+
+#include <inttypes.h>
+
+#define TOPO_MAX_CPUS 4096
+#define TOPO_MAX_NODES 64
+
+typedef enum
+  {
+    TOPO_SAME_CPU,
+    TOPO_SMT,			/* hyperthreads of one core */
+    TOPO_SAME_L2,		/* cores of one L2 cluster */
+    TOPO_SAME_L3,
+    TOPO_SAME_PACKAGE,		/* same package and node, another L3 */
+    TOPO_REMOTE,		/* another package or NUMA node */
+    TOPO_NUM_RELATIONS,
+  } topo_relation_t;
+
+extern const char* topo_relation_des[];
+
+/* the domains --spread distributes the cores over */
+typedef enum
+  {
+    TOPO_LEVEL_PACKAGE,
+    TOPO_LEVEL_NODE,
+    TOPO_LEVEL_L3,
+    TOPO_NUM_LEVELS,
+  } topo_level_t;
+
+extern const char* topo_level_des[];
+
+/* the sets (siblings, L2, L3) are named after their first cpu; -1 if unknown */
+typedef struct topo_cpu
+{
+  int32_t online;
+  int32_t allowed;		/* in the affinity mask ccbench started with (cpusets) */
+  int32_t package;
+  int32_t die;
+  int32_t core;
+  int32_t node;
+  int32_t smt_set;
+  int32_t l2_set;
+  int32_t l3_set;
+} topo_cpu_t;
+
+void topo_init();
+const topo_cpu_t* topo_cpu(uint32_t cpu);
+topo_relation_t topo_relation(uint32_t a, uint32_t b);
+/* the first cpu with relation rel to cpu, -1 if there is none */
+int32_t topo_find(uint32_t cpu, topo_relation_t rel);
+uint32_t topo_num_nodes();
+/* the SLIT distance of two nodes (10 = local), -1 if unknown */
+int32_t topo_distance(int32_t a, int32_t b);
+/* prefers the memory node of cpu for the allocations of the calling thread */
+void topo_prefer_node(uint32_t cpu);
+/* the allowed cpus in ascending order; returns how many there are */
+uint32_t topo_allowed(uint32_t* cpus, uint32_t max);
+/* the first two allowed cpus with relation rel, for TOPO_REMOTE in two packages; */
+/* 0 if there are none */
+int topo_pair(topo_relation_t rel, uint32_t* a, uint32_t* b);
+/* num cpus (0 = one per domain), one physical core after the other from every */
+/* domain of level in turn; returns how many were picked */
+uint32_t topo_spread(topo_level_t level, uint32_t* cpus, uint32_t num);
+/* num cpus, SMT siblings first, then the cores of one L3, package, node */
+uint32_t topo_compact(uint32_t* cpus, uint32_t num);
+int topo_parse_level(const char* arg);
+/* one line for the whole machine; with verbose, one per cpu of cpus */
+void topo_print(const uint32_t* cpus, uint32_t num, int verbose);
+
+#endif	/* _TOPOLOGY_H_ */
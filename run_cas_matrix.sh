@@ -15,7 +15,7 @@ if (( CORE_COUNT < 2 )); then
   echo "error: CORE_COUNT must be at least 2 (got ${CORE_COUNT})" >&2
   exit 1
 fi
-TIMEOUT=${TIMEOUT:-60}
+TIMEOUT=${TIMEOUT:-$((60 * CORE_COUNT * (CORE_COUNT - 1)))}
 
 # Automatically rebuild the default benchmark binary when it is out of date.
 # This avoids confusing situations where a stale executable is used after the
@@ -52,92 +52,41 @@ BIN_MTIME=$(stat -c '%y' "$BIN" 2>/dev/null || echo "unavailable")
 
 mkdir -p "$LOG_DIR"
 
-echo "source_core,target_core,reported_core_a,avg_cycles_a,reported_core_b,avg_cycles_b"
-
-for ((src=0; src<CORE_COUNT; src++)); do
-  for ((dst=0; dst<CORE_COUNT; dst++)); do
-    if [[ $src -eq $dst ]]; then
-      continue
-    fi
-    cores_arg="[$src,$dst]"
-    #echo "Running CAS on cores $src and $dst..." >&2
-
-    log_file="$LOG_DIR/src_${src}_dst_${dst}.log"
-
-    if output=$(timeout "$TIMEOUT" "$BIN" --test CAS --cores 2 --cores_array "$cores_arg" --repetitions "$REPS" 2>&1); then
-      status=0
-    else
-      status=$?
-    fi
-
-    printf '%s\n' "$output" >"$log_file"
-
-    line_count=$(printf '%s\n' "$output" | wc -l)
-    byte_count=$(printf '%s' "$output" | wc -c)
-
-    excerpt="--- log metadata ---\\n"
-    excerpt+="total_lines=${line_count}\\n"
-    excerpt+="total_bytes=${byte_count}\\n"
-    excerpt+="--- first 200 lines ---\\n"
-    excerpt+="$(printf '%s\n' "$output" | head -n 200)"
-
-    if (( line_count > 200 )); then
-      excerpt+="\\n--- last 200 lines ---\\n"
-      excerpt+="$(printf '%s\n' "$output" | tail -n 200)"
-    fi
-
-    reason=""
-    if [[ $status -eq 124 ]]; then
-      reason="timed out"
-    elif [[ $status -ne 0 ]]; then
-      reason="failed (exit status $status)"
-      if (( status > 128 )); then
-        signal_num=$((status - 128))
-        if signal_name=$(kill -l "$signal_num" 2>/dev/null); then
-          reason+=" (signal ${signal_num}/${signal_name})"
-        fi
-      fi
-    fi
-
-    mapfile -t stats < <(printf '%s\n' "$output" | awk '/Core [0-9]+ : avg/ {printf "%s %s\n", $3, $6}')
-
-    if [[ ${#stats[@]} -lt 2 ]]; then
-      if [[ -n $reason ]]; then
-        {
-          echo "Run ${reason} for $src,$dst"
-          echo "  Command: $BIN --test CAS --cores 2 --cores_array $cores_arg --repetitions $REPS"
-          echo "  Log file: $log_file"
-          echo "  Output excerpt:"
-          printf '%s\n' "$excerpt" | sed 's/^/    /'
-        } >&2
-      else
-        {
-          echo "Unexpected output format for cores $src,$dst"
-          echo "  Command: $BIN --test CAS --cores 2 --cores_array $cores_arg --repetitions $REPS"
-          echo "  Log file: $log_file"
-          echo "  Output excerpt:"
-          printf '%s\n' "$excerpt" | sed 's/^/    /'
-        } >&2
-      fi
-      echo "${src},${dst},,,,"
-      continue
-    fi
-
-    first_core=$(awk '{print $1}' <<<"${stats[0]}")
-    first_avg=$(awk '{print $2}' <<<"${stats[0]}")
-    second_core=$(awk '{print $1}' <<<"${stats[1]}")
-    second_avg=$(awk '{print $2}' <<<"${stats[1]}")
+cores_arg="[$(seq -s, 0 $((CORE_COUNT - 1)))]"
+matrix_file="$LOG_DIR/matrix.csv"
+log_file="$LOG_DIR/ccbench.log"
+cmd=("$BIN" --test CAS --cores "$CORE_COUNT" --cores_array "$cores_arg" --repetitions "$REPS"
+     --matrix csv --output "$matrix_file")
+
+# One process measures every ordered pair: the workers are pinned and calibrated
+# once and ccbench writes the matrix (avg, 95% confidence interval and percentiles
+# of both cores per pair) itself.  The first six columns keep the old layout,
+# source_core,target_core,reported_core_a,avg_cycles_a,reported_core_b,avg_cycles_b;
+# relation, samples and the spread of both cores follow them.
+if timeout "$TIMEOUT" "${cmd[@]}" >"$log_file" 2>&1; then
+  status=0
+else
+  status=$?
+fi
 
-    if [[ -n $reason ]]; then
-      {
-        echo "Run ${reason} for $src,$dst, but statistics were parsed"
-        echo "  Command: $BIN --test CAS --cores 2 --cores_array $cores_arg --repetitions $REPS"
-        echo "  Log file: $log_file"
-        echo "  Output excerpt:"
-        printf '%s\n' "$excerpt" | sed 's/^/    /'
-      } >&2
+if [[ $status -ne 0 || ! -s $matrix_file ]]; then
+  reason="failed (exit status $status)"
+  if [[ $status -eq 124 ]]; then
+    reason="timed out after ${TIMEOUT}s"
+  elif (( status > 128 )); then
+    signal_num=$((status - 128))
+    if signal_name=$(kill -l "$signal_num" 2>/dev/null); then
+      reason+=" (signal ${signal_num}/${signal_name})"
     fi
+  fi
+  {
+    echo "Matrix run ${reason}"
+    echo "  Command: ${cmd[*]}"
+    echo "  Log file: $log_file"
+    echo "  Output excerpt:"
+    tail -n 200 "$log_file" | sed 's/^/    /'
+  } >&2
+  exit 1
+fi
 
-    echo "${src},${dst},${first_core},${first_avg},${second_core},${second_avg}"
-  done
-done
+cat "$matrix_file"
@@ -25,12 +25,17 @@ echo " ** Confidence lvl: $conf";
 tries=1;
 while :
 do
-    ./$run > $tmp;
-    res=$(cut -d'(' -f2 $tmp | gawk -v c=$conf '/%  \|/ { if ($1+0 > c) print $1" --("$0 }');
+    ./$run --format csv > $tmp 2> $tmp.txt;
+    # the share of the samples in each band around the avg, by the csv columns
+    res=$(awk -F, -v c=$conf 'NR == 1 { for (i = 1; i <= NF; i++) col[$i] = i; next }
+                               { split("10p 25p 50p 75p rst", b, " ");
+                                 for (k in b) { s = 100 * $col["num_" b[k]] / $col["samples"];
+                                                if (s > c) print s"% ("b[k]") core "$col["core"] } }' $tmp);
 
     if [ "$res" ];
     then
-	cat $tmp;
+	cat $tmp.txt;
+	echo " ** $res";
 	echo " ** in # tries: $tries";
 	break;
     fi;
@@ -44,7 +49,4 @@ do
     fi;
 done;
 
-if [ -f $tmp ];
-then
-    rm $tmp;
-fi;
+rm -f $tmp $tmp.txt;
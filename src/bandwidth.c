@@ -0,0 +1,356 @@
+/*
+ *   File: bandwidth.c
+ *   Description: scalar, SSE2, AVX, and AVX2 streaming kernels of the BANDWIDTH event
+ *   bandwidth.c is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "bandwidth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+const char* bw_kernel_des[] =
+  {
+    "READ",
+    "WRITE",
+    "RMW",
+    "COPY",
+    "NT_WRITE",
+  };
+
+#if !defined(__x86_64__)
+
+/* scalar kernels ******************************************************************/
+
+static uint64_t
+bw_read_scalar(void* buf, size_t bytes)
+{
+  volatile uint64_t* p = (volatile uint64_t*) buf;
+  size_t i, n = bytes / sizeof(uint64_t);
+  uint64_t a = 0, b = 0, c = 0, d = 0;
+  for (i = 0; i < n; i += 4)
+    {
+      a ^= p[i];
+      b ^= p[i + 1];
+      c ^= p[i + 2];
+      d ^= p[i + 3];
+    }
+  return a ^ b ^ c ^ d;
+}
+
+static uint64_t
+bw_write_scalar(void* buf, size_t bytes)
+{
+  volatile uint64_t* p = (volatile uint64_t*) buf;
+  size_t i, n = bytes / sizeof(uint64_t);
+  for (i = 0; i < n; i++)
+    {
+      p[i] = i;
+    }
+  return n;
+}
+
+static uint64_t
+bw_rmw_scalar(void* buf, size_t bytes)
+{
+  volatile uint64_t* p = (volatile uint64_t*) buf;
+  size_t i, n = bytes / sizeof(uint64_t);
+  for (i = 0; i < n; i++)
+    {
+      p[i] = p[i] + 1;
+    }
+  return p[0];
+}
+
+static uint64_t
+bw_copy_scalar(void* buf, size_t bytes)
+{
+  volatile uint64_t* src = (volatile uint64_t*) buf;
+  size_t i, n = bytes / 2 / sizeof(uint64_t);
+  volatile uint64_t* dst = src + n;
+  for (i = 0; i < n; i++)
+    {
+      dst[i] = src[i];
+    }
+  return dst[0];
+}
+
+#else
+
+/* SSE2 kernels ********************************************************************/
+
+static uint64_t
+bw_read_sse(void* buf, size_t bytes)
+{
+  const __m128i* p = (const __m128i*) buf;
+  size_t i, n = bytes / sizeof(__m128i);
+  __m128i a = _mm_setzero_si128(), b = a, c = a, d = a;
+  for (i = 0; i < n; i += 4)
+    {
+      a = _mm_xor_si128(a, _mm_load_si128(p + i));
+      b = _mm_xor_si128(b, _mm_load_si128(p + i + 1));
+      c = _mm_xor_si128(c, _mm_load_si128(p + i + 2));
+      d = _mm_xor_si128(d, _mm_load_si128(p + i + 3));
+      asm volatile ("" : "+x" (a), "+x" (b), "+x" (c), "+x" (d));
+    }
+  a = _mm_xor_si128(_mm_xor_si128(a, b), _mm_xor_si128(c, d));
+  return (uint64_t) _mm_cvtsi128_si64(a);
+}
+
+static uint64_t
+bw_write_sse(void* buf, size_t bytes)
+{
+  __m128i* p = (__m128i*) buf;
+  size_t i, n = bytes / sizeof(__m128i);
+  __m128i v = _mm_set1_epi32((int) n);
+  for (i = 0; i < n; i += 4)
+    {
+      _mm_store_si128(p + i, v);
+      _mm_store_si128(p + i + 1, v);
+      _mm_store_si128(p + i + 2, v);
+      _mm_store_si128(p + i + 3, v);
+      asm volatile ("" ::: "memory");
+    }
+  return n;
+}
+
+static uint64_t
+bw_rmw_sse(void* buf, size_t bytes)
+{
+  __m128i* p = (__m128i*) buf;
+  size_t i, n = bytes / sizeof(__m128i);
+  __m128i one = _mm_set1_epi32(1);
+  for (i = 0; i < n; i += 2)
+    {
+      _mm_store_si128(p + i, _mm_add_epi32(_mm_load_si128(p + i), one));
+      _mm_store_si128(p + i + 1, _mm_add_epi32(_mm_load_si128(p + i + 1), one));
+      asm volatile ("" ::: "memory");
+    }
+  return (uint64_t) _mm_cvtsi128_si64(_mm_load_si128(p));
+}
+
+static uint64_t
+bw_copy_sse(void* buf, size_t bytes)
+{
+  __m128i* src = (__m128i*) buf;
+  size_t i, n = bytes / 2 / sizeof(__m128i);
+  __m128i* dst = src + n;
+  for (i = 0; i < n; i += 4)
+    {
+      _mm_store_si128(dst + i, _mm_load_si128(src + i));
+      _mm_store_si128(dst + i + 1, _mm_load_si128(src + i + 1));
+      _mm_store_si128(dst + i + 2, _mm_load_si128(src + i + 2));
+      _mm_store_si128(dst + i + 3, _mm_load_si128(src + i + 3));
+      asm volatile ("" ::: "memory");
+    }
+  return n;
+}
+
+static uint64_t
+bw_nt_write_sse(void* buf, size_t bytes)
+{
+  __m128i* p = (__m128i*) buf;
+  size_t i, n = bytes / sizeof(__m128i);
+  __m128i v = _mm_set1_epi32((int) n);
+  for (i = 0; i < n; i += 4)
+    {
+      _mm_stream_si128(p + i, v);
+      _mm_stream_si128(p + i + 1, v);
+      _mm_stream_si128(p + i + 2, v);
+      _mm_stream_si128(p + i + 3, v);
+    }
+  _mm_sfence();
+  return n;
+}
+
+/* AVX kernels *********************************************************************/
+
+__attribute__((target("avx"))) static uint64_t
+bw_read_avx(void* buf, size_t bytes)
+{
+  const __m256i* p = (const __m256i*) buf;
+  size_t i, n = bytes / sizeof(__m256i);
+  __m256d a = _mm256_setzero_pd(), b = a, c = a, d = a;
+  for (i = 0; i < n; i += 4)
+    {
+      a = _mm256_xor_pd(a, _mm256_load_pd((const double*) (p + i)));
+      b = _mm256_xor_pd(b, _mm256_load_pd((const double*) (p + i + 1)));
+      c = _mm256_xor_pd(c, _mm256_load_pd((const double*) (p + i + 2)));
+      d = _mm256_xor_pd(d, _mm256_load_pd((const double*) (p + i + 3)));
+      asm volatile ("" : "+x" (a), "+x" (b), "+x" (c), "+x" (d));
+    }
+  a = _mm256_xor_pd(_mm256_xor_pd(a, b), _mm256_xor_pd(c, d));
+  return (uint64_t) _mm_cvtsi128_si64(_mm_castpd_si128(_mm256_castpd256_pd128(a)));
+}
+
+__attribute__((target("avx"))) static uint64_t
+bw_write_avx(void* buf, size_t bytes)
+{
+  __m256d* p = (__m256d*) buf;
+  size_t i, n = bytes / sizeof(__m256d);
+  __m256d v = _mm256_set1_pd((double) n);
+  for (i = 0; i < n; i += 4)
+    {
+      _mm256_store_pd((double*) (p + i), v);
+      _mm256_store_pd((double*) (p + i + 1), v);
+      _mm256_store_pd((double*) (p + i + 2), v);
+      _mm256_store_pd((double*) (p + i + 3), v);
+      asm volatile ("" ::: "memory");
+    }
+  _mm256_zeroupper();
+  return n;
+}
+
+/* integer adds: a floating-point add on whatever bit patterns the buffer holds */
+/* can hit denormals or NaNs and slow the kernel down; 256-bit integer adds need AVX2 */
+__attribute__((target("avx2"))) static uint64_t
+bw_rmw_avx2(void* buf, size_t bytes)
+{
+  __m256i* p = (__m256i*) buf;
+  size_t i, n = bytes / sizeof(__m256i);
+  __m256i one = _mm256_set1_epi64x(1);
+  for (i = 0; i < n; i += 2)
+    {
+      _mm256_store_si256(p + i, _mm256_add_epi64(_mm256_load_si256(p + i), one));
+      _mm256_store_si256(p + i + 1, _mm256_add_epi64(_mm256_load_si256(p + i + 1), one));
+      asm volatile ("" ::: "memory");
+    }
+  _mm256_zeroupper();
+  return n;
+}
+
+__attribute__((target("avx"))) static uint64_t
+bw_copy_avx(void* buf, size_t bytes)
+{
+  __m256d* src = (__m256d*) buf;
+  size_t i, n = bytes / 2 / sizeof(__m256d);
+  __m256d* dst = src + n;
+  for (i = 0; i < n; i += 4)
+    {
+      _mm256_store_pd((double*) (dst + i), _mm256_load_pd((double*) (src + i)));
+      _mm256_store_pd((double*) (dst + i + 1), _mm256_load_pd((double*) (src + i + 1)));
+      _mm256_store_pd((double*) (dst + i + 2), _mm256_load_pd((double*) (src + i + 2)));
+      _mm256_store_pd((double*) (dst + i + 3), _mm256_load_pd((double*) (src + i + 3)));
+      asm volatile ("" ::: "memory");
+    }
+  _mm256_zeroupper();
+  return n;
+}
+
+__attribute__((target("avx"))) static uint64_t
+bw_nt_write_avx(void* buf, size_t bytes)
+{
+  __m256d* p = (__m256d*) buf;
+  size_t i, n = bytes / sizeof(__m256d);
+  __m256d v = _mm256_set1_pd((double) n);
+  for (i = 0; i < n; i += 4)
+    {
+      _mm256_stream_pd((double*) (p + i), v);
+      _mm256_stream_pd((double*) (p + i + 1), v);
+      _mm256_stream_pd((double*) (p + i + 2), v);
+      _mm256_stream_pd((double*) (p + i + 3), v);
+    }
+  _mm_sfence();
+  _mm256_zeroupper();
+  return n;
+}
+
+#endif	/* __x86_64__ */
+
+bw_fn_t
+bw_select(const bw_kernel_t kernel, const char** isa)
+{
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (kernel == BW_RMW && __builtin_cpu_supports("avx2"))
+    {
+      *isa = "avx2";
+      return bw_rmw_avx2;
+    }
+  if (kernel != BW_RMW && __builtin_cpu_supports("avx"))
+    {
+      static const bw_fn_t avx[] =
+	{ bw_read_avx, bw_write_avx, NULL, bw_copy_avx, bw_nt_write_avx };
+      *isa = "avx";
+      return avx[kernel];
+    }
+
+  static const bw_fn_t sse[] =
+    { bw_read_sse, bw_write_sse, bw_rmw_sse, bw_copy_sse, bw_nt_write_sse };
+  *isa = "sse2";
+  return sse[kernel];
+#else
+  /* no streaming stores: NT_WRITE falls back to regular stores */
+  static const bw_fn_t scalar[] =
+    { bw_read_scalar, bw_write_scalar, bw_rmw_scalar, bw_copy_scalar, bw_write_scalar };
+  *isa = "scalar";
+  return scalar[kernel];
+#endif
+}
+
+size_t
+bw_bytes_moved(const bw_kernel_t kernel, const size_t bytes)
+{
+  if (kernel == BW_RMW)
+    {
+      return 2 * bytes;
+    }
+  return bytes;
+}
+
+int
+bw_parse_kernel(const char* arg)
+{
+  char* endptr = NULL;
+  errno = 0;
+  long numeric = strtol(arg, &endptr, 10);
+  if (endptr != arg && *endptr == '\0' && errno == 0)
+    {
+      if (numeric < 0 || numeric >= BW_NUM_KERNELS)
+	{
+	  fprintf(stderr, "error: bandwidth kernel %ld out of range (0-%d)\n", numeric, BW_NUM_KERNELS - 1);
+	  exit(EXIT_FAILURE);
+	}
+      return (int) numeric;
+    }
+
+  int idx;
+  for (idx = 0; idx < BW_NUM_KERNELS; idx++)
+    {
+      if (strcasecmp(arg, bw_kernel_des[idx]) == 0)
+	{
+	  return idx;
+	}
+    }
+
+  fprintf(stderr, "error: unknown bandwidth kernel '%s'\n", arg);
+  exit(EXIT_FAILURE);
+}
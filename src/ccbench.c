@@ -28,9 +28,14 @@
  */
 
 #include "ccbench.h"
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
 #include <pthread.h>
 #include <strings.h>
 #include <ctype.h>
+#include <math.h>
+#include <sys/utsname.h>
 
 THREAD_LOCAL uint8_t ID;
 THREAD_LOCAL unsigned long* seeds;
@@ -54,20 +59,193 @@ size_t   test_mem_size = CACHE_LINE_NUM * sizeof(cache_line_t);
 uint32_t test_cache_line_num = CACHE_LINE_NUM;
 uint32_t test_lfence = DEFAULT_LFENCE;
 uint32_t test_sfence = DEFAULT_SFENCE;
+uint32_t test_duration = DEFAULT_DURATION;
+uint32_t test_lines = DEFAULT_LINES;
+uint32_t test_scale = DEFAULT_SCALE;
+lock_type_t test_lock = DEFAULT_LOCK;
+uint32_t test_cs_length = DEFAULT_CS_LENGTH;
+uint32_t test_separate = DEFAULT_SEPARATE;
+uint32_t test_pause = DEFAULT_PAUSE;
+fs_layout_t test_fs_layout = DEFAULT_FS_LAYOUT;
+bw_kernel_t test_bw_kernel = DEFAULT_BW_KERNEL;
+uint32_t test_sweep_mem = DEFAULT_SWEEP_MEM;
+size_t   test_chase_loads = CACHE_LINE_NUM;
+uint32_t test_chains = DEFAULT_CHAINS;
+uint32_t test_width = DEFAULT_WIDTH;
+uint32_t test_offset = DEFAULT_OFFSET;
+hint_type_t test_hint = DEFAULT_HINT;
+uint32_t test_hint_distance = DEFAULT_HINT_DISTANCE;
+flush_type_t test_flush_insn = DEFAULT_FLUSH_INSN;
+store_kind_t test_store_kind = DEFAULT_STORE_KIND;
+chain_mode_t test_chain_mode = DEFAULT_CHAIN_MODE;
+size_t   test_page_size = DEFAULT_PAGE_SIZE;
+ring_kind_t test_ring = DEFAULT_RING;
+uint32_t test_payload = DEFAULT_PAYLOAD;
+uint32_t test_batch = DEFAULT_BATCH;
+uint32_t test_smt_pair = DEFAULT_SMT_PAIR;
+lf_struct_t test_lf_struct = DEFAULT_LF_STRUCT;
+uint32_t test_update_ratio = DEFAULT_UPDATE_RATIO;
+matrix_format_t test_matrix = DEFAULT_MATRIX;
+uint32_t test_concurrent = DEFAULT_CONCURRENT;
+placement_t test_placement = DEFAULT_PLACEMENT;
+topo_relation_t test_pair_rel = TOPO_SAME_L3;
+topo_level_t test_spread_level = TOPO_LEVEL_PACKAGE;
+char* test_output = NULL;	/* --output: where --matrix and --sweep go, stdout if NULL */
+char* test_sweep = NULL;	/* --sweep: the spec or the file holding it */
+double test_target_ci = DEFAULT_TARGET_CI;
+double test_budget = DEFAULT_BUDGET;
+report_format_t test_format = DEFAULT_FORMAT;
 
 
 #ifndef MAP_ANONYMOUS
 #define MAP_ANONYMOUS MAP_ANON
 #endif
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
 
 typedef struct
 {
   abs_deviation_t store[PFD_NUM_STORES];
+  abs_deviation_t record[PFD_NUM_STORES]; /* --format: over the same values as quantiles */
   uint8_t store_valid[PFD_NUM_STORES];
+  uint32_t num_samples;		/* valid entries in store 0 for the fixed-duration events */
+  uint64_t ops;
+  uint64_t successes;
+  uint64_t bytes;		/* BANDWIDTH: bytes read + written */
+  uint64_t cycles;		/* BANDWIDTH: ticks of all the passes */
+  uint64_t retries;		/* FETCH_OP, LOCKFREE: failed CASes */
+  uint64_t cas;			/* LOCKFREE: CAS attempts */
+  uint64_t updates;		/* LOCKFREE: successful pushes / enqueues / increments */
+  double elapsed;		/* seconds */
+  double lat_avg;		/* RING consumers: cycles from enqueue to dequeue */
+  double lat_p50;
+  double lat_p99;
+  double lat_max;
+  double quantiles[PFD_NUM_STORES][REPORT_NUM_QS]; /* of the values collect_core_stats got */
+  ticks correction;		/* the core's pfd calibration */
 } core_summary_t;
 
+/* one --format record past the options of the run; NAN marks what the event */
+/* does not measure, an empty csv field or a json null */
+typedef struct
+{
+  uint32_t rank;
+  uint32_t store;
+  char step[96];		/* the sub-run of the events that step (chains, pages, threads, ..), "" */
+  const abs_deviation_t* stats;	/* the sampled latencies, NULL: only the fields below */
+  double samples;
+  double avg;			/* cycles */
+  double min;
+  double max;
+  double quantiles[REPORT_NUM_QS];
+  double ops;
+  double successes;
+  double retries;
+  double bytes;
+  double elapsed;		/* seconds */
+  double mops;			/* Mops/s, successful ones for ATOMIC_MATRIX */
+  double gbps;
+} report_row_t;
+
+/* the repetitions of one rank in a cell of --matrix or --sweep; store 1 holds */
+/* the second timed region of the rank, if the event has one */
+typedef struct
+{
+  abs_deviation_t stats[PFD_NUM_STORES];
+  double p50[PFD_NUM_STORES];
+  double p99[PFD_NUM_STORES];
+  uint32_t stores;		/* stores the rank timed, 1 or 2 */
+} rank_stats_t;
+
+typedef struct
+{
+  rank_stats_t rank[2];		/* rank 0 on the source core, rank 1 on the target core */
+  ticks elapsed;		/* cycles of the pair's repetitions */
+  uint32_t samples;		/* repetitions per rank, more than --repetitions with --target-ci */
+  volatile uint32_t more;	/* --target-ci: rank 0's call for another batch */
+  uint32_t check;		/* --concurrent: MATRIX_CHECK_* of the isolation check */
+} matrix_cell_t;
+
+enum { MATRIX_CHECK_NONE, MATRIX_CHECK_CONSISTENT, MATRIX_CHECK_SHIFTED };
+static const char* matrix_check_des[] = { "", "consistent", "shifted" };
+
+typedef struct
+{
+  uint32_t a;			/* the workers of rank 0 and rank 1 */
+  uint32_t b;
+  uint32_t slot;		/* barrier set and part of the buffer */
+  matrix_cell_t* cell;
+} matrix_entry_t;
+
+#define TP_BATCH        64	/* untimed operations between two latency samples */
+#define TP_LINE_SPACING 2	/* keep the contended lines out of the same adjacent-line pair */
+
 static core_summary_t* core_summaries;
+static double* sweep_latency;	/* --sweep-mem: [size step][core] avg cycles per load */
+static uint32_t sweep_steps;
+static size_t sweep_lines;	/* --sweep-mem: lines in the chain of the current step, set by core 0 */
+static double* mlp_latency;	/* MLP: [chains - 1][core] avg cycles per access */
+static volatile uint64_t* chain_head; /* LOAD_FROM_MEM_SIZE: first line of the chain */
+static volatile uint32_t litmus_regs[4][16] ALIGNED(64); /* LITMUS_*: the loaded values, per core */
+static uint64_t litmus_counts[16];	/* LITMUS_*: occurrences of every outcome, on core 0 */
+static volatile uint64_t litmus_go ALIGNED(64); /* LITMUS_*: the iteration core 0 released */
+static THREAD_LOCAL uint64_t litmus_iter;
+static THREAD_LOCAL uint32_t store_line_used; /* --store-kind: store 1 holds the sfence after the line stores */
 static volatile cache_line_t* shared_cache_line;
+static lock_t* shared_lock;
+static THREAD_LOCAL lock_local_t lock_local;
+static ring_t* shared_ring;
+static double* matrix_cas_lat;	/* ATOMIC_MATRIX: [core a][core b], the line in b's node memory */
+static double* matrix_owned_lat; /* the line modified in b's cache */
+static double* matrix_cas_tp;
+static double* matrix_fai_tp;
+static volatile uint8_t* matrix_pages; /* ATOMIC_MATRIX: a page per core, first touched by it */
+static ticks* pooled_samples;	/* FETCH_OP, LOCKFREE: [core][test_reps] sampled latencies */
+static lf_t* shared_lf;
+static THREAD_LOCAL lf_local_t lf_local;
+static int64_t lf_expected;	/* LOCKFREE: the size the structure must have */
+static volatile uint64_t* smt_heads[2]; /* SMT_INTERFERENCE: probe and memory-load chains */
+static volatile uint32_t smt_stop ALIGNED(64);
+static double smt_results[SMT_NUM_LOADS][2][3]; /* [sibling load][probe]: avg, p50, p99 */
+static matrix_cell_t* matrix_cells;	/* --matrix: [source][target], by worker */
+static uint32_t matrix_workers;
+static matrix_entry_t* matrix_plan;	/* --matrix: the pairs, round after round */
+static uint32_t* matrix_round_end;	/* index in matrix_plan after the round's last pair */
+static uint32_t matrix_rounds;
+static matrix_cell_t* matrix_verify;
+static uint32_t matrix_num_verify; /* the first rounds measure these cells in isolation */
+static ticks matrix_campaign;	/* cycles of the concurrent rounds */
+static THREAD_LOCAL uint32_t barrier_base; /* first barrier of the B macros */
+static sweep_t* sweep;		/* --sweep: the configurations */
+static int32_t* sweep_rank_of;	/* the rank every worker takes in the current configuration */
+static rank_stats_t* sweep_results; /* by rank */
+static uint32_t sweep_samples;
+static volatile uint32_t sweep_more;
+static double adapt_deadline;	/* --budget: when the batches after the pilots stop */
+static uint32_t adapt_extended;	/* --target-ci: cells that took more batches */
+static uint32_t adapt_loose;	/* cells left wider than the target */
+static THREAD_LOCAL ticks* adapt_pool[PFD_NUM_STORES]; /* the raw samples of the batches of a cell */
+static FILE* report_out;	/* --format csv / json: the records */
+static report_t* report_records; /* opened in main, written on core 0 */
+static const double report_qs[REPORT_NUM_QS] = { 0.50, 0.90, 0.99, 0.999 };
+static const char* report_qs_des[REPORT_NUM_QS] = { "p50", "p90", "p99", "p99_9" };
+static const char* sweep_invalid; /* why the current configuration cannot run, NULL if it can */
+static FILE* sweep_out;
+/* --sweep hint=: the configurations that differ in their hint alone, by hint, */
+/* and what a hint saved over none in every complete one */
+static int32_t sweep_block_config[HINT_NUM_TYPES];
+static double sweep_block_avg[HINT_NUM_TYPES][SWEEP_MAX_CORES];
+typedef struct
+{
+  uint32_t config;
+  double saved[SWEEP_MAX_CORES];	/* cycles of store 0 without the hint minus with it, by rank */
+} sweep_hint_saving_t;
+static sweep_hint_saving_t* sweep_savings;
+static uint32_t sweep_num_savings;
+static uint32_t sweep_resumed;	/* rows the output already held */
+static volatile uint32_t matrix_done ALIGNED(64); /* --matrix: 2 per measured pair */
+static volatile ticks lock_handoff_ts ALIGNED(64);
 static uint32_t* allocated_cores_array;
 static size_t allocated_cores_capacity;
 static int cores_option_explicit;
@@ -78,11 +256,15 @@ static void run_worker(uint32_t rank);
 static void* worker_trampoline(void* arg);
 static void ensure_cores_array_capacity(size_t required);
 static void assign_default_cores_array(uint32_t num_cores);
+static void place_cores();
+static const char* set_fence(uint32_t fence);
 static void parse_cores_array_option(const char* arg);
 
 static void store_0(volatile cache_line_t* cache_line, volatile uint64_t reps);
 static void store_0_no_pf(volatile cache_line_t* cache_line, volatile uint64_t reps);
 static void store_0_eventually(volatile cache_line_t* cl, volatile uint64_t reps);
+static void store_0_kind(volatile cache_line_t* cl, volatile uint64_t reps);
+static void store_0_eventually_kind(volatile cache_line_t* cl, volatile uint64_t reps);
 static void store_0_eventually_pfd1(volatile cache_line_t* cl, volatile uint64_t reps);
 
 static uint64_t load_0(volatile cache_line_t* cache_line, volatile uint64_t reps);
@@ -91,6 +273,7 @@ static uint64_t load_0_eventually(volatile cache_line_t* cl, volatile uint64_t r
 static uint64_t load_0_eventually_no_pf(volatile cache_line_t* cl);
 
 static void invalidate(volatile cache_line_t* cache_line, uint64_t index, volatile uint64_t reps);
+static inline void flush_line(volatile void* p);
 static uint32_t cas(volatile cache_line_t* cache_line, volatile uint64_t reps);
 static uint32_t cas_0_eventually(volatile cache_line_t* cache_line, volatile uint64_t reps);
 static uint32_t cas_no_pf(volatile cache_line_t* cache_line, volatile uint64_t reps);
@@ -98,10 +281,82 @@ static uint32_t fai(volatile cache_line_t* cache_line, volatile uint64_t reps);
 static uint8_t tas(volatile cache_line_t* cl, volatile uint64_t reps);
 static uint32_t swap(volatile cache_line_t* cl, volatile uint64_t reps);
 
+static int test_is_free_running(moesi_type_t test);
+static int test_reports_steps(moesi_type_t test);
+static uint64_t run_free_running(volatile cache_line_t* cache_line);
+static uint64_t throughput_run(volatile cache_line_t* cache_line);
+static void throughput_report();
+static void throughput_scale_report(uint32_t active);
+static void lock_uncontended(volatile uint64_t reps);
+static void lock_handoff_acquire(volatile uint64_t reps);
+static void lock_handoff_release(volatile uint64_t reps);
+static void broadcast_write(volatile uint64_t* w, volatile uint64_t reps);
+static void broadcast_read(volatile uint64_t* w, uint64_t old, volatile uint64_t reps);
+static void broadcast_report();
+static int test_is_lock(moesi_type_t test);
+static int test_is_strided(moesi_type_t test);
+static int test_has_store_kind(moesi_type_t test);
+static int test_needs_third_core(moesi_type_t test);
+static uint64_t pingpong_run(volatile cache_line_t* cache_line);
+static void pingpong_report();
+static void bandwidth_report();
+static uint64_t sweep_mem_run(volatile cache_line_t* cache_line);
+static void sweep_mem_report();
+static uint64_t mlp_run(volatile cache_line_t* cache_line);
+static uint64_t ring_run(volatile cache_line_t* cache_line);
+static uint64_t atomic_matrix_run(volatile cache_line_t* cache_line);
+static void atomic_matrix_report();
+static uint64_t fop_run(volatile cache_line_t* cache_line);
+static uint64_t smt_run(volatile cache_line_t* cache_line);
+static void lf_loop(core_summary_t* res);
+static void lf_report(uint32_t active);
+static void pool_samples(const core_summary_t* res);
+static void smt_report();
+static void smt_pair_cores();
+static void ring_report();
+static uint32_t ring_producers();
+static void mlp_report();
+static inline uint32_t ao_width(uint32_t native);
+static void litmus_run(volatile cache_line_t* cache_line, volatile uint64_t reps);
+static uint32_t litmus_threads(moesi_type_t test);
+static void litmus_report();
+static inline uint32_t ao_native_width();
+static inline void ao_set(volatile cache_line_t* cl, uint32_t ones);
+
 static size_t parse_size(char* optarg);
 static void create_rand_list_cl(volatile uint64_t* list, size_t n);
+static size_t create_chain_cl(volatile cache_line_t* base, size_t bytes, chain_mode_t mode, size_t page,
+			      volatile uint64_t** head);
+static void* huge_alloc(size_t size, size_t page, const char** how);
+static size_t thp_backed_bytes(void* addr, size_t size);
+static uint64_t tlb_sweep_run(volatile cache_line_t* cache_line);
+static void tlb_sweep_report();
+static volatile cache_line_t* cache_line_init(volatile cache_line_t* cache_line, uint64_t size);
 static void collect_core_stats(uint32_t store, uint32_t num_vals, uint32_t num_print);
+static uint64_t rep_loop(volatile cache_line_t* cache_line, volatile uint64_t* cl, const uint32_t loop_reps);
+static uint64_t matrix_run(volatile cache_line_t* cache_line, volatile uint64_t* cl);
+static void matrix_report();
+static void matrix_plan_init();
+static void matrix_verify_report();
+static void sweep_init();
+static void rank_stats_collect(rank_stats_t* out, uint32_t batch);
+static void rank_stats_csv(FILE* out, const rank_stats_t* res, uint32_t st);
+static void rank_stats_csv_spread(FILE* out, const rank_stats_t* res, uint32_t st);
+static double matrix_ci95(const abs_deviation_t* stats);
+static uint64_t adapt_run(volatile cache_line_t* cache_line, volatile uint64_t* cl, rank_stats_t* ranks,
+			  uint32_t* samples, volatile uint32_t* more, uint32_t cells_left);
+static void adapt_report();
+static inline double wtime();
+static void report_results();
+static void report_row_init(report_row_t* row, uint32_t rank, uint32_t store);
+static void report_row_tp(report_row_t* row, const core_summary_t* res);
+static void report_record(const report_row_t* row);
+static void report_step_cores(uint32_t active, const char* step);
+static uint64_t sweep_run(volatile cache_line_t* cache_line);
 static int parse_test_option(const char* arg);
+static int parse_hint_option(const char* arg);
+static void sweep_hint_block(uint32_t c);
+static void sweep_hint_report();
 
 static void
 ensure_cores_array_capacity(size_t required)
@@ -123,27 +378,201 @@ ensure_cores_array_capacity(size_t required)
   allocated_cores_capacity = new_capacity;
 }
 
+/* the first num_cores allowed cpus (cpusets), reused when there are fewer */
 static void
 assign_default_cores_array(uint32_t num_cores)
 {
-  size_t default_len = sizeof(default_cores) / sizeof(default_cores[0]);
-
-  if (!cores_array_explicit && num_cores <= default_len && allocated_cores_array == NULL)
+  uint32_t* allowed = (uint32_t*) calloc(TOPO_MAX_CPUS, sizeof(uint32_t));
+  if (allowed == NULL)
     {
-      test_cores_array = DEFAULT_CORES_ARRAY;
-      configured_cores_array_len = num_cores;
-      return;
+      perror("calloc");
+      exit(1);
+    }
+  uint32_t num_allowed = topo_allowed(allowed, TOPO_MAX_CPUS);
+  if (num_allowed == 0)
+    {
+      fprintf(stderr, "error: no cpu is allowed to this process\n");
+      exit(1);
     }
 
   ensure_cores_array_capacity(num_cores);
-  for (uint32_t idx = 0; idx < num_cores; idx++)
+  uint32_t idx;
+  for (idx = 0; idx < num_cores; idx++)
+    {
+      allocated_cores_array[idx] = allowed[idx % num_allowed];
+    }
+  free(allowed);
+  if (num_cores > num_allowed)
     {
-      allocated_cores_array[idx] = idx;
+      printf("* %u cores on %u allowed cpus: some cores share a cpu\n", num_cores, num_allowed);
     }
   test_cores_array = allocated_cores_array;
   configured_cores_array_len = num_cores;
 }
 
+/* --fence: the fences of the loads (test_lfence) and the stores (test_sfence) */
+static const char*
+set_fence(uint32_t fence)
+{
+  switch (fence)
+    {
+    case 1:
+      test_lfence = test_sfence = 1;
+      return "load & store";
+    case 2:
+      test_lfence = test_sfence = 2;
+      return "full";
+    case 3:
+      test_lfence = 1;
+      test_sfence = 0;
+      return "load";
+    case 4:
+      test_lfence = 0;
+      test_sfence = 1;
+      return "store";
+    case 5:
+      test_lfence = 2;
+      test_sfence = 0;
+      return "full/none";
+    case 6:
+      test_lfence = 0;
+      test_sfence = 2;
+      return "none/full";
+    case 7:
+      test_lfence = 2;
+      test_sfence = 1;
+      return "full/store";
+    case 8:
+      test_lfence = 1;
+      test_sfence = 2;
+      return "load/full";
+    case 9:
+      test_lfence = 0;
+      test_sfence = 3;
+      return "double write";
+    default:
+      test_lfence = test_sfence = 0;
+      return "none";
+    }
+}
+
+/* --pair, --spread, --compact: the cores from the topology, within the */
+/* affinity mask */
+static void
+place_cores()
+{
+  if (cores_array_explicit)
+    {
+      fprintf(stderr, "error: --cores_array and --%s exclude each other\n", placement_des[test_placement]);
+      exit(1);
+    }
+
+  ensure_cores_array_capacity(test_cores > TOPO_MAX_CPUS ? test_cores : TOPO_MAX_CPUS);
+  uint32_t* cores = allocated_cores_array;
+  uint32_t n = 0;
+  switch (test_placement)
+    {
+    case PLACE_PAIR:
+      if (cores_option_explicit && test_cores != 2)
+	{
+	  fprintf(stderr, "error: --pair picks 2 cores\n");
+	  exit(1);
+	}
+      if (!topo_pair(test_pair_rel, &cores[0], &cores[1]))
+	{
+	  fprintf(stderr, "error: no two allowed cpus are %s\n", pair_des[test_pair_rel]);
+	  exit(1);
+	}
+      n = 2;
+      break;
+    case PLACE_SPREAD:
+      n = topo_spread(test_spread_level, cores, cores_option_explicit ? test_cores : 0);
+      break;
+    default:
+      n = topo_compact(cores, test_cores);
+      break;
+    }
+  if (n == 0)
+    {
+      fprintf(stderr, "error: no cpu is allowed to this process\n");
+      exit(1);
+    }
+
+  /* more cores than the cpus to pick from: the placement hands cpus out again */
+  uint32_t distinct = 0, i, j;
+  for (i = 0; i < n; i++)
+    {
+      for (j = 0; j < i && cores[j] != cores[i]; j++)
+	;
+      distinct += (j == i);
+    }
+  if (distinct < n)
+    {
+      printf("* %u cores on %u distinct cpus (--%s): some cores share a cpu\n", n, distinct,
+	     placement_des[test_placement]);
+    }
+
+  test_cores = n;
+  test_cores_array = cores;
+  configured_cores_array_len = n;
+  printf("Using cores array (--%s): ", placement_des[test_placement]);
+  uint32_t idx;
+  for (idx = 0; idx < n; idx++)
+    {
+      printf("%u ", cores[idx]);
+    }
+  printf("\n");
+}
+
+/* --smt-pair: moves core 1 to the SMT sibling of core 0 or to the nearest other */
+/* physical core, swapping it with a core that already runs there */
+static void
+smt_pair_cores()
+{
+  if (test_cores < 2)
+    {
+      fprintf(stderr, "error: --smt-pair needs >=2 processes\n");
+      exit(1);
+    }
+
+  const uint32_t core = test_cores_array[0];
+  int32_t other = -1;
+  if (test_smt_pair == 1)
+    {
+      other = topo_find(core, TOPO_SMT);
+    }
+  else
+    {
+      topo_relation_t rel;
+      for (rel = TOPO_SAME_L2; rel < TOPO_NUM_RELATIONS && other < 0; rel++)
+	{
+	  other = topo_find(core, rel);
+	}
+    }
+  if (other < 0)
+    {
+      fprintf(stderr, "error: cpu %u has no %s\n", core,
+	      (test_smt_pair == 1) ? "SMT sibling" : "other physical core");
+      exit(1);
+    }
+
+  ensure_cores_array_capacity(test_cores);
+  memmove(allocated_cores_array, test_cores_array, test_cores * sizeof(uint32_t));
+  test_cores_array = allocated_cores_array;
+  /* a worker already on that cpu takes the old cpu of core 1, so no cpu runs two */
+  uint32_t c;
+  for (c = 2; c < test_cores; c++)
+    {
+      if (test_cores_array[c] == (uint32_t) other)
+	{
+	  test_cores_array[c] = test_cores_array[1];
+	  printf("Core %u on cpu %u (swapped with core 1)\n", c, test_cores_array[c]);
+	}
+    }
+  test_cores_array[1] = other;
+  printf("Core 1 on cpu %d (%s of cpu %u)\n", other, topo_relation_des[topo_relation(core, other)], core);
+}
+
 static void
 parse_cores_array_option(const char* arg)
 {
@@ -279,10 +708,13 @@ main(int argc, char **argv)
     }
 #endif
 
+  topo_init();			/* before set_cpu narrows the affinity mask */
 #if defined(XEON)
   set_cpu(1);
 #else
-  set_cpu(0);
+  uint32_t first_cpu = 0;
+  topo_allowed(&first_cpu, 1);
+  set_cpu(first_cpu);
 #endif
 
   struct option long_options[] = 
@@ -301,6 +733,41 @@ main(int argc, char **argv)
       {"success",                   no_argument,       NULL, 'u'},
       {"verbose",                   no_argument,       NULL, 'v'},
       {"print",                     required_argument, NULL, 'p'},
+      {"duration",                  required_argument, NULL, 'd'},
+      {"lines",                     required_argument, NULL, 'l'},
+      {"scale",                     no_argument,       NULL, 'S'},
+      {"lock",                      required_argument, NULL, 'k'},
+      {"cs-length",                 required_argument, NULL, 'w'},
+      {"separate-lines",            no_argument,       NULL, 'i'},
+      {"pause",                     no_argument,       NULL, 'P'},
+      {"fs-layout",                 required_argument, NULL, 'g'},
+      {"bw-kernel",                 required_argument, NULL, 'b'},
+      {"sweep-mem",                 no_argument,       NULL, 'M'},
+      {"chains",                    required_argument, NULL, 'C'},
+      {"width",                     required_argument, NULL, 'W'},
+      {"offset",                    required_argument, NULL, 'O'},
+      {"hint",                      required_argument, NULL, 'H'},
+      {"hint-distance",             required_argument, NULL, 'D'},
+      {"flush-insn",                required_argument, NULL, 'F'},
+      {"store-kind",                required_argument, NULL, 'K'},
+      {"chain-mode",                required_argument, NULL, 'N'},
+      {"page-size",                 required_argument, NULL, 'Z'},
+      {"ring",                      required_argument, NULL, 'q'},
+      {"payload",                   required_argument, NULL, 'a'},
+      {"batch",                     required_argument, NULL, 'B'},
+      {"smt-pair",                  required_argument, NULL, 'T'},
+      {"lf-struct",                 required_argument, NULL, 'L'},
+      {"update-ratio",              required_argument, NULL, 'U'},
+      {"matrix",                    required_argument, NULL, 'X'},
+      {"output",                    required_argument, NULL, 'Y'},
+      {"concurrent",                required_argument, NULL, 'j'},
+      {"pair",                      required_argument, NULL, 'A'},
+      {"spread",                    required_argument, NULL, 'E'},
+      {"compact",                   no_argument,       NULL, 'G'},
+      {"sweep",                     required_argument, NULL, 'R'},
+      {"target-ci",                 required_argument, NULL, 'V'},
+      {"budget",                    required_argument, NULL, 'J'},
+      {"format",                    required_argument, NULL, 'Q'},
       {NULL, 0, NULL, 0}
     };
 
@@ -309,7 +776,7 @@ main(int argc, char **argv)
   while(1)
     {
       i = 0;
-      c = getopt_long(argc, argv, "hc:r:t:x:m:y:z:o:e:fvup:s:", long_options, &i);
+      c = getopt_long(argc, argv, "hc:r:t:x:m:y:z:o:e:fvup:s:d:l:Sk:w:iPg:b:MC:W:O:H:D:F:K:N:Z:q:a:B:T:L:U:X:Y:j:A:E:GR:V:J:Q:", long_options, &i);
 
       if(c == -1)
 	break;
@@ -362,6 +829,124 @@ main(int argc, char **argv)
 		 "        Verbose printing of results (default=" XSTR(DEFAULT_VERBOSE) ")\n"
 		 "  -p, --print <int>\n"
 		 "        If verbose, how many results to print (default=" XSTR(DEFAULT_PRINT) ")\n"
+		 "  -d, --duration <int>\n"
+		 "        Run time in ms of the fixed-duration (*_THROUGHPUT) events (default=" XSTR(DEFAULT_DURATION) ")\n"
+		 "        ATOMIC_MATRIX runs a CAS and a FAI measurement of that length for every ordered core pair\n"
+		 "  -l, --lines <int>\n"
+		 "        Number of cache lines the *_THROUGHPUT events spread the cores on (default=" XSTR(DEFAULT_LINES) ")\n"
+		 "        Core i operates on line (i %% lines); the latencies of every " XSTR(TP_BATCH) "th operation are sampled\n"
+		 "  -S, --scale\n"
+		 "        Repeat the fixed-duration events with 1, 2, .., #cores active cores (throughput vs. thread count)\n"
+		 "  -k, --lock <int or name>\n"
+		 "        Lock algorithm of the LOCK_* events (default=TAS). See below for supported locks\n"
+		 "  -w, --cs-length <int>\n"
+		 "        Critical-section length in cycles for LOCK_THROUGHPUT (default=" XSTR(DEFAULT_CS_LENGTH) ")\n"
+		 "  -i, --separate-lines\n"
+		 "        PINGPONG: give every core its flag on a separate cache line (default: all flags in one line)\n"
+		 "  -P, --pause\n"
+		 "        PINGPONG: execute PAUSE while polling the flag (default: busy polling)\n"
+		 "  -g, --fs-layout <int>\n"
+		 "        FALSE_SHARING: where the per-core words are (default=0)\n"
+		 "        0 = all in one line / 1 = spread over two adjacent lines / 2 = one line per core /\n"
+		 "        3 = one 128-byte line pair per core (exposes the adjacent-line prefetcher)\n"
+		 "  -b, --bw-kernel <int or name>\n"
+		 "        BANDWIDTH: streaming kernel over a --mem-size / #cores chunk per core (default=READ)\n"
+		 "        0 = READ / 1 = WRITE / 2 = RMW / 3 = COPY (half to half) / 4 = NT_WRITE (non-temporal stores)\n"
+		 "  -M, --sweep-mem\n"
+		 "        LOAD_FROM_MEM_SIZE: walk the working set from 4 KiB to --mem-size in half-octave steps,\n"
+		 "        rebuilding the chain in place, and detect the cache-level plateaus of the latency curve\n"
+		 "  -C, --chains <int>\n"
+		 "        MLP: chase 1 .. chains disjoint random chains interleaved over a --mem-size / #cores slice\n"
+		 "        per core (default=" XSTR(DEFAULT_CHAINS) ", max=" XSTR(MLP_MAX_CHAINS) ")\n"
+		 "  -W, --width <int>\n"
+		 "        Operand width in bits of the CAS / FAI / TAS / SWAP events: 8, 16, 32, 64 or 128\n"
+		 "        (default: 32, 8 for TAS). 128 is cmpxchg16b; FAI, TAS and SWAP are then a cmpxchg16b loop\n"
+		 "  -O, --offset <int>\n"
+		 "        Byte offset of that operand in its cache line (default=" XSTR(DEFAULT_OFFSET) "). An operand that\n"
+		 "        crosses the end of the line is a split lock (e.g., -W 32 -O 62); kernels with split_lock_detect\n"
+		 "        trap and throttle those, so use a small --stride and --repetitions\n"
+		 "  -H, --hint <int>\n"
+		 "        Cache hint of the STORE_ON_* / LOAD_FROM_* events (default=0)\n"
+		 "        0 = none / 1 = prefetcht0 and 2 = prefetchw --hint-distance cycles before the timed access /\n"
+		 "        3 = cldemote after every store (pushes the line towards the shared cache)\n"
+		 "  -D, --hint-distance <int>\n"
+		 "        Cycles between the prefetch and the timed access (default=" XSTR(DEFAULT_HINT_DISTANCE) ")\n"
+		 "  -F, --flush-insn <int>\n"
+		 "        Instruction of --flush and of the *_ON_INVALID events (default=0)\n"
+		 "        0 = clflush / 1 = clflushopt / 2 = clwb (write back only; the *_ON_INVALID events time the\n"
+		 "        clwb and then clflush the line untimed, --flush uses clflush)\n"
+		 "  -K, --store-kind <int>\n"
+		 "        How the timed store of STORE_ON_MODIFIED(_NO_SYNC), STORE_ON_EXCLUSIVE, STORE_ON_SHARED and\n"
+		 "        STORE_ON_INVALID writes; the stores that prepare a state stay word stores (default=0)\n"
+		 "        0 = one word / 1 = full line with AVX / 2 = full line with AVX-512 / 3 = full line with movnti /\n"
+		 "        4 = full line with movntdq. Full-line stores are followed by an sfence timed separately (store 1)\n"
+		 "  -N, --chain-mode <int>\n"
+		 "        How LOAD_FROM_MEM_SIZE links its chain (default=0)\n"
+		 "        0 = random over the buffer / 1 = random within a page, page after page /\n"
+		 "        2 = one random line per page, pages in order / 3 = one random line per page, pages at random\n"
+		 "  -Z, --page-size <4K, 2M or 1G>\n"
+		 "        Page size backing the buffer and the page of --chain-mode (default=4K). 2M falls back to\n"
+		 "        transparent huge pages without reserved huge pages, and fails unless they back the whole\n"
+		 "        buffer (AnonHugePages in /proc/self/smaps). TLB_SWEEP compares 4K with 2M itself\n"
+		 "  -q, --ring <int or name>\n"
+		 "        RING: ring algorithm (default=SPSC). Core 0 produces and core 1 consumes; MPMC splits the\n"
+		 "        cores into producers (first half) and consumers. See below for supported rings\n"
+		 "  -a, --payload <int>\n"
+		 "        RING: bytes per message, including the 8-byte enqueue timestamp (default=" XSTR(DEFAULT_PAYLOAD) ")\n"
+		 "  -B, --batch <int>\n"
+		 "        RING: messages per index update of SPSC_BATCH (default=" XSTR(DEFAULT_BATCH) ")\n"
+		 "  -T, --smt-pair <int>\n"
+		 "        Where core 1 runs relative to core 0, from the sysfs topology (default=0, SMT_INTERFERENCE: 1)\n"
+		 "        0 = as given / 1 = on the SMT sibling of core 0 / 2 = on another physical core, the nearest one\n"
+		 "  -L, --lf-struct <int or name>\n"
+		 "        LOCKFREE: structure (default=TREIBER). See below for supported structures\n"
+		 "  -U, --update-ratio <int>\n"
+		 "        LOCKFREE: percentage of pushes / enqueues / increments; the rest are pops / dequeues / reads\n"
+		 "        (default=" XSTR(DEFAULT_UPDATE_RATIO) ")\n"
+		 "  -X, --matrix <csv or json>\n"
+		 "        Run the event for every ordered pair of the cores of -x in one process: the source core\n"
+		 "        takes core 0's role and the target core 1's; writes avg, 95%% confidence interval and\n"
+		 "        percentiles of both per pair, and of their store-1 region if they time one (not for the\n"
+		 "        fixed-duration events, nor for the events that need a third core, e.g. LOAD_FROM_SHARED)\n"
+		 "  -Y, --output <file>\n"
+		 "        Where --matrix writes its matrix and --sweep its rows (default=stdout)\n"
+		 "  -A, --pair <smt, same-l2, same-l3, same-socket or cross-socket>\n"
+		 "        Run on the first two allowed cpus with that relation\n"
+		 "  -E, --spread <socket, node or l3>\n"
+		 "        One physical core from every socket / node / L3 in turn; as many cores as domains\n"
+		 "        without -c\n"
+		 "  -G, --compact\n"
+		 "        -c cores as close together as possible: SMT siblings, then one L3, one package, ...\n"
+		 "        Without these and -x, the cores are the first allowed cpus (cpusets are respected)\n"
+		 "  -j, --concurrent <int>\n"
+		 "        --matrix: measure up to that many pairs at once, pairs that share no L3 (default=1). Every\n"
+		 "        " XSTR(MATRIX_VERIFY_SHARE) "th cell is first measured alone; its isolation_check column says whether\n"
+		 "        the concurrent measurement is consistent with it or shifted\n"
+		 "  -R, --sweep <spec or file>\n"
+		 "        Run every combination of the values of the keys in one process, one csv row each; the\n"
+		 "        spec is key=values entries separated by ';' (or lines of the file, # comments):\n"
+		 "        test=names/indices/a-b, fence=a-b, stride=a-b (doubling), mem=a-b (doubling, K/M/G),\n"
+		 "        cores=[x,y,..] or n (the first n of -x), hint=names/indices (innermost: the rows of one\n"
+		 "        configuration with none and with each hint follow each other, and the run ends with\n"
+		 "        the cycles every hint saved over none, by rank); e.g.\n"
+		 "        \"test=0,7;stride=1-64;cores=[0,1],[0,2];hint=none,prefetchw\". The rows end with the hint.\n"
+		 "        Keys left out take their options' values. Rerun with the same --output to resume; the\n"
+		 "        expanded configurations and the options that change the rows must be the same\n"
+		 "  -V, --target-ci <percent>\n"
+		 "        --matrix, --sweep: --repetitions is a pilot; a cell gets further batches of that many while\n"
+		 "        the 95%% confidence interval of a core's mean is wider than that share of the mean, up to\n"
+		 "        " XSTR(ADAPT_MAX_BATCHES) " batches (default=0: no further batches)\n"
+		 "  -J, --budget <seconds>\n"
+		 "        --target-ci: the whole run, pilots included, should take at most that long; the cells\n"
+		 "        left share what remains of it (default=0: no limit)\n"
+		 "  -Q, --format <text, csv or json>\n"
+		 "        csv / json: one record per core and store with the configuration, the host, the core's\n"
+		 "        relation to core 0, all statistics, percentiles and the calibration, and the ops,\n"
+		 "        successes, bytes, seconds, Mops/s and GB/s of the free-running events; the events that\n"
+		 "        step (MLP chains, TLB_SWEEP pages, FETCH_OP variants, --scale, ..) get one per step.\n"
+		 "        What an event does not measure is empty / null. Every statistic of a record counts the\n"
+		 "        samples above the 1500 cycles the text output sets to 0. To --output or stdout; the\n"
+		 "        text lines then go to stderr (default=text)\n"
 		 );
 	  printf("Supported events: \n");
 	  int ar;
@@ -369,6 +954,21 @@ main(int argc, char **argv)
 	    {
 	      printf("      %2d - %s\n", ar, moesi_type_des[ar]);
 	    }
+	  printf("Supported locks: \n");
+	  for (ar = 0; ar < LOCK_NUM_TYPES; ar++)
+	    {
+	      printf("      %2d - %s\n", ar, lock_type_des[ar]);
+	    }
+	  printf("Supported lock-free structures: \n");
+	  for (ar = 0; ar < LF_NUM_STRUCTS; ar++)
+	    {
+	      printf("      %2d - %s\n", ar, lf_struct_des[ar]);
+	    }
+	  printf("Supported rings: \n");
+	  for (ar = 0; ar < RING_NUM_KINDS; ar++)
+	    {
+	      printf("      %2d - %s\n", ar, ring_kind_des[ar]);
+	    }
 
 	  exit(0);
         case 'c':
@@ -405,10 +1005,6 @@ main(int argc, char **argv)
                     exit(1);
                   }
               }
-            else
-              {
-                assign_default_cores_array(test_cores);
-              }
           }
           break;
 	case 'r':
@@ -446,6 +1042,219 @@ main(int argc, char **argv)
 	  test_verbose = 1;
 	  test_print = atoi(optarg);
 	  break;
+	case 'd':
+	  test_duration = atoi(optarg);
+	  break;
+	case 'l':
+	  test_lines = atoi(optarg);
+	  break;
+	case 'S':
+	  test_scale = 1;
+	  break;
+	case 'k':
+	  test_lock = lock_parse_type(optarg);
+	  break;
+	case 'w':
+	  test_cs_length = atoi(optarg);
+	  break;
+	case 'i':
+	  test_separate = 1;
+	  break;
+	case 'P':
+	  test_pause = 1;
+	  break;
+	case 'b':
+	  test_bw_kernel = bw_parse_kernel(optarg);
+	  break;
+	case 'M':
+	  test_sweep_mem = 1;
+	  break;
+	case 'W':
+	  test_width = atoi(optarg);
+	  if (test_width != 8 && test_width != 16 && test_width != 32 && test_width != 64
+#if defined(CAS_U128)
+	      && test_width != 128
+#endif
+	      )
+	    {
+	      fprintf(stderr, "error: unsupported --width %s\n", optarg);
+	      exit(1);
+	    }
+	  break;
+	case 'O':
+	  test_offset = atoi(optarg);
+	  if (test_offset >= sizeof(cache_line_t))
+	    {
+	      fprintf(stderr, "error: --offset must be in 0-%zu\n", sizeof(cache_line_t) - 1);
+	      exit(1);
+	    }
+	  break;
+	case 'H':
+	  test_hint = atoi(optarg);
+	  if (test_hint >= HINT_NUM_TYPES)
+	    {
+	      fprintf(stderr, "error: --hint must be in 0-%d\n", HINT_NUM_TYPES - 1);
+	      exit(1);
+	    }
+	  break;
+	case 'D':
+	  test_hint_distance = atoi(optarg);
+	  break;
+	case 'F':
+	  test_flush_insn = atoi(optarg);
+	  if (test_flush_insn >= FLUSH_NUM_TYPES)
+	    {
+	      fprintf(stderr, "error: --flush-insn must be in 0-%d\n", FLUSH_NUM_TYPES - 1);
+	      exit(1);
+	    }
+	  break;
+	case 'K':
+	  test_store_kind = atoi(optarg);
+	  if (test_store_kind >= STORE_NUM_KINDS)
+	    {
+	      fprintf(stderr, "error: --store-kind must be in 0-%d\n", STORE_NUM_KINDS - 1);
+	      exit(1);
+	    }
+	  break;
+	case 'N':
+	  test_chain_mode = atoi(optarg);
+	  if (test_chain_mode >= CHAIN_NUM_MODES)
+	    {
+	      fprintf(stderr, "error: --chain-mode must be in 0-%d\n", CHAIN_NUM_MODES - 1);
+	      exit(1);
+	    }
+	  break;
+	case 'Z':
+	  test_page_size = parse_size(optarg);
+	  if (test_page_size != PAGE_SIZE_4K && test_page_size != PAGE_SIZE_2M && test_page_size != PAGE_SIZE_1G)
+	    {
+	      fprintf(stderr, "error: --page-size must be 4K, 2M or 1G\n");
+	      exit(1);
+	    }
+	  break;
+	case 'q':
+	  test_ring = ring_parse_kind(optarg);
+	  break;
+	case 'a':
+	  test_payload = atoi(optarg);
+	  if (test_payload < RING_MIN_PAYLOAD || test_payload > RING_MAX_PAYLOAD)
+	    {
+	      fprintf(stderr, "error: --payload must be in %d-%d\n", RING_MIN_PAYLOAD, RING_MAX_PAYLOAD);
+	      exit(1);
+	    }
+	  break;
+	case 'B':
+	  test_batch = atoi(optarg);
+	  if (test_batch == 0 || test_batch > RING_SLOTS)
+	    {
+	      fprintf(stderr, "error: --batch must be in 1-%d\n", RING_SLOTS);
+	      exit(1);
+	    }
+	  break;
+	case 'T':
+	  test_smt_pair = atoi(optarg);
+	  if (test_smt_pair > 2)
+	    {
+	      fprintf(stderr, "error: --smt-pair must be in 0-2\n");
+	      exit(1);
+	    }
+	  break;
+	case 'L':
+	  test_lf_struct = lf_parse_struct(optarg);
+	  break;
+	case 'U':
+	  test_update_ratio = atoi(optarg);
+	  if (test_update_ratio > 100)
+	    {
+	      fprintf(stderr, "error: --update-ratio must be in 0-100\n");
+	      exit(1);
+	    }
+	  break;
+	case 'X':
+	  if (strcasecmp(optarg, "csv") == 0)
+	    {
+	      test_matrix = MATRIX_CSV;
+	    }
+	  else if (strcasecmp(optarg, "json") == 0)
+	    {
+	      test_matrix = MATRIX_JSON;
+	    }
+	  else
+	    {
+	      fprintf(stderr, "error: --matrix must be csv or json\n");
+	      exit(1);
+	    }
+	  break;
+	case 'Y':
+	  test_output = optarg;
+	  break;
+	case 'A':
+	  {
+	    int rel;
+	    for (rel = TOPO_SMT; rel < TOPO_NUM_RELATIONS && strcasecmp(optarg, pair_des[rel]) != 0; rel++)
+	      ;
+	    if (rel == TOPO_NUM_RELATIONS)
+	      {
+		fprintf(stderr, "error: --pair must be smt, same-l2, same-l3, same-socket or cross-socket\n");
+		exit(1);
+	      }
+	    test_pair_rel = rel;
+	    test_placement = PLACE_PAIR;
+	    break;
+	  }
+	case 'E':
+	  test_spread_level = topo_parse_level(optarg);
+	  test_placement = PLACE_SPREAD;
+	  break;
+	case 'G':
+	  test_placement = PLACE_COMPACT;
+	  break;
+	case 'R':
+	  test_sweep = optarg;
+	  break;
+	case 'V':
+	  test_target_ci = atof(optarg);
+	  if (test_target_ci <= 0 || test_target_ci >= 100)
+	    {
+	      fprintf(stderr, "error: --target-ci must be a percentage above 0 and below 100\n");
+	      exit(1);
+	    }
+	  break;
+	case 'Q':
+	  test_format = report_parse_format(optarg);
+	  break;
+	case 'J':
+	  test_budget = atof(optarg);
+	  if (test_budget <= 0)
+	    {
+	      fprintf(stderr, "error: --budget must be a positive number of seconds\n");
+	      exit(1);
+	    }
+	  break;
+	case 'j':
+	  test_concurrent = atoi(optarg);
+	  if (test_concurrent == 0 || test_concurrent > BARRIER_SETS)
+	    {
+	      fprintf(stderr, "error: --concurrent must be in 1-%d\n", BARRIER_SETS);
+	      exit(1);
+	    }
+	  break;
+	case 'C':
+	  test_chains = atoi(optarg);
+	  if (test_chains == 0 || test_chains > MLP_MAX_CHAINS)
+	    {
+	      fprintf(stderr, "error: --chains must be in 1-%d\n", MLP_MAX_CHAINS);
+	      exit(1);
+	    }
+	  break;
+	case 'g':
+	  test_fs_layout = atoi(optarg);
+	  if (test_fs_layout >= FS_NUM_LAYOUTS)
+	    {
+	      fprintf(stderr, "error: --fs-layout must be in 0-%d\n", FS_NUM_LAYOUTS - 1);
+	      exit(1);
+	    }
+	  break;
 	case '?':
 	  printf("Use -h or --help for help\n");
 	  exit(0);
@@ -454,14 +1263,61 @@ main(int argc, char **argv)
         }
     }
 
+  if (test_format != REPORT_TEXT)
+    {
+      if (test_matrix != MATRIX_OFF || test_sweep != NULL)
+	{
+	  fprintf(stderr, "error: --matrix and --sweep write their own csv / json, not --format\n");
+	  exit(1);
+	}
+      if (test_output != NULL)
+	{
+	  report_out = fopen(test_output, "w");
+	  if (report_out == NULL)
+	    {
+	      perror(test_output);
+	      exit(1);
+	    }
+	}
+      else
+	{
+	  /* stdout keeps the records only; what is still buffered goes to stderr too */
+	  int fd = dup(STDOUT_FILENO);
+	  if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0 || (report_out = fdopen(fd, "w")) == NULL)
+	    {
+	      perror("--format");
+	      exit(1);
+	    }
+	}
+      report_records = report_open(test_format, report_out);
+    }
 
-  if (!cores_array_explicit)
+  if (test_placement != PLACE_NONE)
+    {
+      place_cores();
+    }
+  else if (!cores_array_explicit)
     {
       assign_default_cores_array(test_cores);
     }
+  uint32_t core_idx;
+  for (core_idx = 0; core_idx < test_cores; core_idx++)
+    {
+      if (!topo_cpu(test_cores_array[core_idx])->allowed)
+	{
+	  fprintf(stderr, "error: cpu %u is offline or outside the affinity mask of ccbench "
+		  "(--compact, --spread or --pair pick allowed cpus)\n", test_cores_array[core_idx]);
+	  exit(1);
+	}
+    }
 
+  if (test_sweep != NULL)
+    {
+      sweep_init();
+    }
 
   test_cache_line_num = test_mem_size / sizeof(cache_line_t);
+  test_chase_loads = test_cache_line_num;
 
   if ((test_test == STORE_ON_EXCLUSIVE || test_test == STORE_ON_INVALID || test_test == LOAD_FROM_INVALID
        || test_test == LOAD_FROM_EXCLUSIVE || test_test == LOAD_FROM_SHARED) && !test_flush)
@@ -469,77 +1325,332 @@ main(int argc, char **argv)
       assert((test_reps * test_stride) <= test_cache_line_num);
     }
 
-  if (test_test != LOAD_FROM_MEM_SIZE)
+  if (test_test != LOAD_FROM_MEM_SIZE && !test_is_free_running(test_test))
     {
       assert(test_stride < test_cache_line_num);
     }
 
+  if (test_is_free_running(test_test))
+    {
+      assert(test_duration > 0 && test_lines > 0);
+      assert((test_lines * TP_LINE_SPACING) <= test_cache_line_num);
+      assert((test_cores * TP_LINE_SPACING) <= test_cache_line_num);
+    }
 
-  ID = 0;
-  printf("test: %20s  / #cores: %d / #repetitions: %d / stride: %d (%u kiB)", moesi_type_des[test_test], 
-	 test_cores, test_reps, test_stride, (64 * test_stride) / 1024);
-  if (test_flush)
+  if (test_sweep_mem && (test_test != LOAD_FROM_MEM_SIZE || test_mem_size < SWEEP_MIN_SIZE))
     {
-      printf(" / flush");
+      fprintf(stderr, "error: --sweep-mem needs --test LOAD_FROM_MEM_SIZE and --mem-size >= 4 KiB\n");
+      exit(1);
     }
 
-  printf("  / fence: ");
+  if ((test_hint == HINT_PREFETCHW && !cpu_has_prefetchw())
+      || (test_hint == HINT_CLDEMOTE && !cpu_has_cldemote()))
+    {
+      fprintf(stderr, "error: this cpu does not support %s\n", hint_type_des[test_hint]);
+      exit(1);
+    }
+  if ((test_flush_insn == FLUSH_CLFLUSHOPT && !cpu_has_clflushopt())
+      || (test_flush_insn == FLUSH_CLWB && !cpu_has_clwb()))
+    {
+      fprintf(stderr, "error: this cpu does not support %s\n", flush_type_des[test_flush_insn]);
+      exit(1);
+    }
 
-  switch (test_fence)
+  if ((test_store_kind == STORE_AVX && !cpu_has_avx())
+      || (test_store_kind == STORE_AVX512 && !cpu_has_avx512f()))
     {
-    case 1:
-      printf(" load & store");
-      test_lfence = test_sfence = 1;
-      break;
-    case 2:
-      printf(" full");
-      test_lfence = test_sfence = 2;
-      break;
-    case 3:
-      printf(" load");
-      test_lfence = 1;
-      test_sfence = 0;
-      break;
-    case 4:
-      printf(" store");
-      test_lfence = 0;
-      test_sfence = 1;
-      break;
-    case 5:
-      printf(" full/none");
-      test_lfence = 2;
-      test_sfence = 0;
-      break;
-    case 6:
-      printf(" none/full");
-      test_lfence = 0;
-      test_sfence = 2;
-      break;
-    case 7:
-      printf(" full/store");
-      test_lfence = 2;
-      test_sfence = 1;
-      break;
-    case 8:
-      printf(" load/full");
-      test_lfence = 1;
-      test_sfence = 2;
-      break;    
-    case 9:
-      printf(" double write");
-      test_lfence = 0;
-      test_sfence = 3;
-      break;
-    default:
-      printf(" none");
-      test_lfence = test_sfence = 0;
-      break;
+      fprintf(stderr, "error: this cpu does not support %s stores\n", store_kind_des[test_store_kind]);
+      exit(1);
+    }
+#if !defined(__x86_64__)
+  if (test_store_kind != STORE_WORD)
+    {
+      fprintf(stderr, "error: --store-kind needs x86_64\n");
+      exit(1);
+    }
+#endif
+  if (test_store_kind != STORE_WORD && test_sweep == NULL && !test_has_store_kind(test_test))
+    {
+      fprintf(stderr, "error: --store-kind selects the timed store of STORE_ON_MODIFIED(_NO_SYNC), "
+	      "STORE_ON_EXCLUSIVE, STORE_ON_SHARED and STORE_ON_INVALID, not %s\n", moesi_type_des[test_test]);
+      exit(1);
+    }
+
+  if (test_test == TLB_SWEEP && (test_page_size != PAGE_SIZE_4K || test_mem_size < SWEEP_MIN_SIZE))
+    {
+      fprintf(stderr, "error: TLB_SWEEP compares its own 2M buffer with a 4K-backed --mem-size >= 4 KiB\n");
+      exit(1);
+    }
+
+  if (test_test == PINGPONG && !test_separate && test_cores > PINGPONG_LINE_FLAGS)
+    {
+      fprintf(stderr, "error: PINGPONG fits %d flags in one line; use --separate-lines for more processes\n",
+	      PINGPONG_LINE_FLAGS);
+      exit(1);
+    }
+
+  if (litmus_threads(test_test) > test_cores)
+    {
+      fprintf(stderr, "error: %s needs >=%u processes\n", moesi_type_des[test_test], litmus_threads(test_test));
+      exit(1);
+    }
+
+  if (test_test == SMT_INTERFERENCE && !cores_array_explicit && test_smt_pair == 0)
+    {
+      test_smt_pair = 1;
+    }
+  if (test_smt_pair)
+    {
+      smt_pair_cores();
+    }
+
+  if (test_test == SMT_INTERFERENCE && test_mem_size < 2 * SMT_PROBE_BYTES)
+    {
+      fprintf(stderr, "error: SMT_INTERFERENCE needs --mem-size of at least %d bytes\n", 2 * SMT_PROBE_BYTES);
+      exit(1);
+    }
+
+  if ((test_test == RING || test_test == BROADCAST || test_test == ATOMIC_MATRIX || test_test == SMT_INTERFERENCE)
+      && test_cores < 2)
+    {
+      fprintf(stderr, "error: %s needs >=2 processes\n", moesi_type_des[test_test]);
+      exit(1);
+    }
+
+#if !defined(CAS_U128)
+  if (test_test == LOCKFREE && (test_lf_struct == LF_TREIBER_TAGGED || test_lf_struct == LF_MS_QUEUE))
+    {
+      fprintf(stderr, "error: %s needs a 128-bit CAS\n", lf_struct_des[test_lf_struct]);
+      exit(1);
+    }
+#endif
+
+  if (test_width == 128 && (test_offset % 16) != 0)
+    {
+      fprintf(stderr, "error: cmpxchg16b needs a 16-byte aligned --offset\n");
+      exit(1);
+    }
+
+  if (test_test == MLP && (test_mem_size / test_cores) / sizeof(cache_line_t) < 2 * test_chains)
+    {
+      fprintf(stderr, "error: MLP needs --mem-size of at least 2 lines per chain per core\n");
+      exit(1);
+    }
+
+  if (test_test == BANDWIDTH && (test_mem_size / test_cores) < BW_CHUNK_ALIGN)
+    {
+      fprintf(stderr, "error: BANDWIDTH needs --mem-size of at least %d bytes per core\n", BW_CHUNK_ALIGN);
+      exit(1);
+    }
+
+  if (test_matrix != MATRIX_OFF)
+    {
+      if (test_cores < 2)
+	{
+	  fprintf(stderr, "error: --matrix needs >=2 processes\n");
+	  exit(1);
+	}
+      if (test_is_free_running(test_test) || litmus_threads(test_test) > 2 || test_needs_third_core(test_test))
+	{
+	  fprintf(stderr, "error: --matrix runs the repetitions of a two-core event, not %s\n",
+		  moesi_type_des[test_test]);
+	  exit(1);
+	}
+    }
+  if (test_concurrent > 1)
+    {
+      /* the pairs of a round only get their own lines and barriers */
+      if (test_matrix == MATRIX_OFF || test_is_lock(test_test) || test_test == LOAD_FROM_MEM_SIZE
+	  || litmus_threads(test_test) > 0)
+	{
+	  fprintf(stderr, "error: --concurrent needs --matrix and an event that only uses its lines\n");
+	  exit(1);
+	}
+      size_t part = test_cache_line_num / test_concurrent;
+      if (test_stride >= part || (!test_flush && test_is_strided(test_test)
+				  && (size_t) test_reps * test_stride > part))
+	{
+	  fprintf(stderr, "error: --concurrent %u needs --repetitions x --stride of at most %zu lines\n",
+		  test_concurrent, part);
+	  exit(1);
+	}
+    }
+
+  if ((test_target_ci > 0 && test_matrix == MATRIX_OFF && test_sweep == NULL)
+      || (test_budget > 0 && test_target_ci == 0))
+    {
+      fprintf(stderr, "error: --target-ci needs --matrix or --sweep, --budget needs --target-ci\n");
+      exit(1);
+    }
+
+  topo_init();
+  topo_print(test_cores_array, test_cores, test_verbose);
+
+  ID = 0;
+  printf("test: %20s  / #cores: %d / #repetitions: %d / stride: %d (%u kiB)", moesi_type_des[test_test], 
+	 test_cores, test_reps, test_stride, (64 * test_stride) / 1024);
+  if (test_flush)
+    {
+      printf(" / flush");
+    }
+  if (test_is_free_running(test_test))
+    {
+      printf(" / duration: %u ms / lines: %u", test_duration, test_lines);
+    }
+  if (test_is_lock(test_test))
+    {
+      printf(" / lock: %s / cs: %u cycles", lock_type_des[test_lock], test_cs_length);
+    }
+  if (test_test == PINGPONG)
+    {
+      printf(" / flags: %s / polling: %s", test_separate ? "separate lines" : "same line",
+	     test_pause ? "pause" : "busy");
+    }
+  if (test_test == FALSE_SHARING)
+    {
+      printf(" / layout: %s", fs_layout_des[test_fs_layout]);
+    }
+  if (test_test == BANDWIDTH)
+    {
+      const char* isa;
+      bw_select(test_bw_kernel, &isa);
+      printf(" / kernel: %s (%s) / %zu KiB per core", bw_kernel_des[test_bw_kernel], isa,
+	     (test_mem_size / test_cores) / 1024);
+    }
+  if (test_test == LOCKFREE)
+    {
+      printf(" / structure: %s / updates: %u%%", lf_struct_des[test_lf_struct], test_update_ratio);
+    }
+  if (test_sweep != NULL)
+    {
+      printf(" / sweep: %u configurations on %u workers", sweep->num_configs, test_cores);
+    }
+  if (test_target_ci > 0)
+    {
+      printf(" / target ci: %g%%", test_target_ci);
+      if (test_budget > 0)
+	{
+	  printf(" within %g s", test_budget);
+	}
+    }
+  if (test_matrix != MATRIX_OFF)
+    {
+      printf(" / matrix: %u pairs", test_cores * (test_cores - 1));
+      if (test_concurrent > 1)
+	{
+	  printf(" / up to %u at once", test_concurrent);
+	}
+    }
+  if (test_test == RING)
+    {
+      printf(" / ring: %s / payload: %u bytes", ring_kind_des[test_ring], test_payload);
+      if (test_ring == RING_SPSC_BATCH)
+	{
+	  printf(" / batch: %u", test_batch);
+	}
+    }
+  if (test_test == MLP)
+    {
+      printf(" / chains: 1-%u / %zu KiB per core", test_chains, (test_mem_size / test_cores) / 1024);
+    }
+  if (test_hint != HINT_NONE)
+    {
+      printf(" / hint: %s", hint_type_des[test_hint]);
+      if (test_hint != HINT_CLDEMOTE)
+	{
+	  printf(" %u cycles ahead", test_hint_distance);
+	}
+    }
+  if (test_test == LOAD_FROM_MEM_SIZE && (test_chain_mode != DEFAULT_CHAIN_MODE || test_page_size != DEFAULT_PAGE_SIZE))
+    {
+      printf(" / chain: %s / pages: %zu KiB", chain_mode_des[test_chain_mode], test_page_size / 1024);
+    }
+  if (test_store_kind != DEFAULT_STORE_KIND)
+    {
+      printf(" / stores: full line, %s", store_kind_des[test_store_kind]);
+    }
+  if (test_flush_insn != DEFAULT_FLUSH_INSN)
+    {
+      printf(" / flush: %s", flush_type_des[test_flush_insn]);
+    }
+  if (test_width != DEFAULT_WIDTH || test_offset != DEFAULT_OFFSET)
+    {
+      uint32_t bytes = ao_width(ao_native_width()) / 8;
+      printf(" / operand: %u bits at byte %u%s", bytes * 8, test_offset,
+	     (test_offset + bytes > sizeof(cache_line_t)) ? " (split lock)" : "");
     }
 
+  printf("  / fence:  %s", set_fence(test_fence));
+
   barriers_init(test_cores);
 
   shared_cache_line = cache_line_open();
 
+  if (test_is_lock(test_test))
+    {
+      shared_lock = lock_new(test_lock, test_cores);
+    }
+
+  if (test_test == RING)
+    {
+      shared_ring = ring_new(test_ring, test_payload, test_batch);
+    }
+
+  if (test_test == ATOMIC_MATRIX)
+    {
+      matrix_cas_lat = (double*) calloc(test_cores * test_cores, sizeof(double));
+      matrix_owned_lat = (double*) calloc(test_cores * test_cores, sizeof(double));
+      matrix_cas_tp = (double*) calloc(test_cores * test_cores, sizeof(double));
+      matrix_fai_tp = (double*) calloc(test_cores * test_cores, sizeof(double));
+      assert(matrix_cas_lat != NULL && matrix_owned_lat != NULL && matrix_cas_tp != NULL && matrix_fai_tp != NULL);
+      /* left untouched here: the page of every core is homed where that core touches it */
+      matrix_pages = (volatile uint8_t*) mmap(NULL, (size_t) test_cores * PAGE_SIZE_4K, PROT_READ | PROT_WRITE,
+					      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      assert(matrix_pages != MAP_FAILED);
+    }
+
+  if (test_test == FETCH_OP || test_test == LOCKFREE)
+    {
+      pooled_samples = (ticks*) calloc((size_t) test_cores * test_reps, sizeof(ticks));
+      assert(pooled_samples != NULL);
+    }
+
+  if (test_test == LOCKFREE)
+    {
+      shared_lf = lf_new(test_lf_struct, test_cores);
+      if (test_lf_struct != LF_COUNTER && test_lf_struct != LF_SHARDED_COUNTER)
+	{
+	  lf_expected = (int64_t) test_cores * (LF_NODES_PER_THREAD / 2);
+	}
+    }
+
+  if (test_matrix != MATRIX_OFF)
+    {
+      matrix_workers = test_cores;
+      matrix_plan_init();
+    }
+  if (test_sweep != NULL)
+    {
+      matrix_workers = test_cores;
+    }
+
+  if (test_sweep_mem || test_test == TLB_SWEEP)
+    {
+      size_t size;
+      for (size = SWEEP_MIN_SIZE; size <= test_mem_size; size <<= 1)
+	{
+	  sweep_steps += 1 + ((size + size / 2) <= test_mem_size && (size << 1) > size + size / 2);
+	}
+      sweep_latency = (double*) calloc(sweep_steps * ((test_cores > 2) ? test_cores : 2), sizeof(double));
+      assert(sweep_latency != NULL);
+    }
+
+  if (test_test == MLP)
+    {
+      mlp_latency = (double*) calloc(test_chains * test_cores, sizeof(double));
+      assert(mlp_latency != NULL);
+    }
+
   size_t summary_bytes = test_cores * sizeof(core_summary_t);
   core_summaries = (core_summary_t*) mmap(NULL, summary_bytes, PROT_READ | PROT_WRITE,
                                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
@@ -561,6 +1672,7 @@ main(int argc, char **argv)
         }
     }
 
+  adapt_deadline = wtime() + test_budget;
   uint32_t rank;
   for (rank = 1; rank < test_cores; rank++)
     {
@@ -637,12 +1749,22 @@ run_worker(uint32_t rank)
       exit(1);
     }
 
-  volatile uint64_t* cl = (volatile uint64_t*) cache_line;
+  if (shared_lock != NULL)
+    {
+      lock_local_init(shared_lock, &lock_local);
+    }
+  if (shared_lf != NULL)
+    {
+      lf_local_init(shared_lf, &lf_local, ID);
+    }
+
+  volatile uint64_t* cl = (chain_head != NULL) ? chain_head : (volatile uint64_t*) cache_line;
 
   B0;
   if (ID < test_cores)
     {
       PFDINIT(test_reps);
+      core_summaries[ID].correction = pfd_correction;
     }
   B0;
 
@@ -652,436 +1774,673 @@ run_worker(uint32_t rank)
 
   uint64_t sum = 0;
 
-  volatile uint64_t reps;
-  for (reps = 0; reps < test_reps; reps++)
+  /* the free-running events do their own synchronization; they replace the */
+  /* barrier-separated repetitions below */
+  uint32_t loop_reps = test_reps;
+  if (test_is_free_running(test_test))
     {
-      if (test_flush)
-	{
-	  _mm_mfence();
-	  _mm_clflush((void*) cache_line);
-	  _mm_mfence();
-	}
+      sum += run_free_running(cache_line);
+      loop_reps = 0;
+    }
 
-      B0;			/* BARRIER 0 */
+  if (test_matrix != MATRIX_OFF)
+    {
+      sum += matrix_run(cache_line, cl);
+      cache_line_close(ID, "cache_line");
+      barriers_term(ID);
+      return;
+    }
+  if (test_sweep != NULL)
+    {
+      sum += sweep_run(cache_line);
+      cache_line_close(ID, "cache_line");
+      barriers_term(ID);
+      return;
+    }
 
-      switch (test_test)
-	{
-	case STORE_ON_MODIFIED: /* 0 */
-	  {
-	    switch (ID)
-	      {
-	      case 0:
-		store_0_eventually(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		break;
-	      case 1:
-		B1;		/* BARRIER 1 */
-		store_0_eventually(cache_line, reps);
-		break;
-	      default:
-		B1;		/* BARRIER 1 */
-		break;
-	      }
-	    break;
-	  }
-	case STORE_ON_MODIFIED_NO_SYNC: /* 1 */
-	  {
-	    switch (ID)
-	      {
-	      case 0:
-	      case 1:
-	      case 2:
-		store_0(cache_line, reps);
-		break;
-	      default:
-		store_0_no_pf(cache_line, reps);
-		break;
-	      }
-	    break;
-	  }
-	case STORE_ON_EXCLUSIVE: /* 2 */
-	  {
-	    switch (ID)
-	      {
-	      case 0:
-		sum += load_0_eventually(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		break;
-	      case 1:
-		B1;		/* BARRIER 1 */
-		store_0_eventually(cache_line, reps);
-		break;
-	      default:
-		B1;		/* BARRIER 1 */
-		break;
-	      }
+  sum += rep_loop(cache_line, cl, loop_reps);
 
-	    if (!test_flush)
-	      {
-		cache_line += test_stride;
-	      }
-	    break;
-	  }
-	case STORE_ON_SHARED:	/* 3 */
-	  {
-	    switch (ID)
-	      {
-	      case 0:
-		sum += load_0_eventually(cache_line, reps);
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		break;
-	      case 1:
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		store_0_eventually(cache_line, reps);
-		break;
-	      case 2:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps);
-		B2;			/* BARRIER 2 */
-		break;
-	      default:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually_no_pf(cache_line);
-		B2;			/* BARRIER 2 */
-		break;
+  if (!test_verbose)
+    {
+      test_print = 0;
+    }
+
+  uint32_t id;
+  for (id = 0; id < test_cores; id++)
+    {
+      if (ID == id && ID < test_cores)
+	{
+	  switch (test_test)
+	    {
+	    case STORE_ON_OWNED_MINE:
+	    case STORE_ON_OWNED:
+	      if (ID < 2)
+		{
+		  PRINT(" *** Core %ld ************************************************************************************", core);
+		  collect_core_stats(0, test_reps, test_print);
+		  if (ID == 1)
+		    {
+		      collect_core_stats(1, test_reps, test_print);
+		    }
+		}
+	      break;
+            case CAS_CONCURRENT:
+              PRINT(" *** Core %ld ************************************************************************************", core);
+              collect_core_stats(0, test_reps, test_print);
+              break;
+	    case LOAD_FROM_L1:
+	      if (ID < 1)
+		{
+		  PRINT(" *** Core %ld ************************************************************************************", core);
+		  collect_core_stats(0, test_reps, test_print);
+		}
+	      break;
+	    case MLP:
+	    case TLB_SWEEP:
+	    case RING:
+	    case ATOMIC_MATRIX:
+	    case FETCH_OP:
+	    case SMT_INTERFERENCE:
+	      break;
+	    case LITMUS_SB:
+	    case LITMUS_MP:
+	    case LITMUS_LB:
+	    case LITMUS_IRIW:
+	      if (ID < litmus_threads(test_test))
+		{
+		  PRINT(" *** Core %ld ************************************************************************************", core);
+		  collect_core_stats(0, test_reps, test_print);
+		}
+	      break;
+	    case LOAD_FROM_MEM_SIZE:
+	      if (ID < test_cores && !test_sweep_mem)
+		{
+		  PRINT(" *** Core %ld ************************************************************************************", core);
+		  collect_core_stats(0, test_reps, test_print);
+		}
+	      break;
+	    case CAS_THROUGHPUT:
+	    case FAI_THROUGHPUT:
+	    case SWAP_THROUGHPUT:
+	    case TAS_THROUGHPUT:
+	    case LOCK_THROUGHPUT:
+	    case FALSE_SHARING:
+	    case BANDWIDTH:
+	    case LOCKFREE:
+	      PRINT(" *** Core %ld ************************************************************************************", core);
+	      collect_core_stats(0, core_summaries[ID].num_samples, test_print);
+	      break;
+	    case LOCK_UNCONTENDED:
+	      if (ID == 0)
+		{
+		  PRINT(" *** Core %ld ************************************************************************************", core);
+		  collect_core_stats(0, test_reps, test_print);
+		  collect_core_stats(1, test_reps, test_print);
+		}
+	      break;
+	    case PINGPONG:
+	      if (ID == 0)
+		{
+		  PRINT(" *** Core %ld ************************************************************************************", core);
+		  collect_core_stats(0, test_reps, test_print);
+		}
+	      break;
+	    case LOCK_HANDOFF:
+	      if (ID < 2)
+		{
+		  PRINT(" *** Core %ld ************************************************************************************", core);
+		  collect_core_stats(0, test_reps, test_print);
+		}
+	      break;
+	    default:
+	      PRINT(" *** Core %ld ************************************************************************************", core);
+	      collect_core_stats(0, test_reps, test_print);
+	      if (store_line_used)
+		{
+		  collect_core_stats(1, test_reps, test_print);
+		}
+	    }
+	}
+      B0;
+    }
+  B10;
+
+
+  if (ID == 0)
+    {
+      PRINT(" ---- Cross-core summary ------------------------------------------------------------");
+      double min_avg = DBL_MAX;
+      double max_avg = 0.0;
+      double sum_avg = 0.0;
+      uint32_t min_core = 0;
+      uint32_t max_core = 0;
+      uint32_t cores_with_stats = 0;
+
+      uint32_t core_idx;
+      for (core_idx = 0; core_idx < test_cores; core_idx++)
+        {
+          const core_summary_t* summary = &core_summaries[core_idx];
+          const abs_deviation_t* stats = NULL;
+          uint32_t store_idx;
+          for (store_idx = 0; store_idx < PFD_NUM_STORES; store_idx++)
+            {
+              if (summary->store_valid[store_idx])
+                {
+                  stats = &summary->store[store_idx];
+                  break;
+                }
+            }
+
+          if (stats == NULL)
+            {
+              PRINT(" Core %u : no samples recorded", test_cores_array[core_idx]);
+              continue;
+            }
+
+          double avg = stats->avg;
+          if (core_idx == 0)
+            {
+              PRINT(" Core %u : avg %8.1f cycles (min %8.1f | max %8.1f)",
+                    test_cores_array[core_idx], avg, stats->min_val, stats->max_val);
+            }
+          else
+            {
+              PRINT(" Core %u : avg %8.1f cycles (min %8.1f | max %8.1f) | %s of core %u",
+                    test_cores_array[core_idx], avg, stats->min_val, stats->max_val,
+                    topo_relation_des[topo_relation(test_cores_array[0], test_cores_array[core_idx])],
+                    test_cores_array[0]);
+            }
+          sum_avg += avg;
+          cores_with_stats++;
+          if (avg < min_avg)
+            {
+              min_avg = avg;
+              min_core = test_cores_array[core_idx];
+            }
+          if (avg > max_avg)
+            {
+              max_avg = avg;
+              max_core = test_cores_array[core_idx];
+            }
+        }
+
+      if (cores_with_stats > 0)
+        {
+          double mean_avg = sum_avg / cores_with_stats;
+          PRINT(" Summary : mean avg %8.1f cycles | min avg %8.1f (core %u) | max avg %8.1f (core %u)",
+                mean_avg, min_avg, min_core, max_avg, max_core);
+        }
+      else
+        {
+          PRINT(" Summary : no statistics captured");
+        }
+
+      if (test_format != REPORT_TEXT)
+	{
+	  report_results();
+	}
+
+      switch (test_test)
+        {
+        case STORE_ON_MODIFIED:
+          {
+	    if (test_flush)
+	      {
+		PRINT(" ** Results from Core 0 : store on invalid");
+		PRINT(" ** Results from Core 1 : store on modified");
+	      }
+	    else
+	      {
+		PRINT(" ** Results from Core 0 and 1 : store on modified");
 	      }
 	    break;
 	  }
-	case STORE_ON_OWNED_MINE: /* 4 */
+	case STORE_ON_MODIFIED_NO_SYNC:
 	  {
-	    switch (ID)
+	    if (test_flush)
 	      {
-	      case 0:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps);
-		B2;			/* BARRIER 2 */
-		break;
-	      case 1:
-		store_0_eventually(cache_line, reps);
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		store_0_eventually_pfd1(cache_line, reps);
-		break;
-	      default:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually_no_pf(cache_line);
-		B2;			/* BARRIER 2 */
-		break;
+		PRINT(" ** Results do not make sense");
+	      }
+	    else
+	      {
+		PRINT(" ** Results from Core 0 and 1 : store on modified while another core is "
+		      "also trying to do the same");
 	      }
 	    break;
 	  }
-	case STORE_ON_OWNED:	/* 5 */
+	case STORE_ON_EXCLUSIVE:
 	  {
-	    switch (ID)
+	    if (test_flush)
 	      {
-	      case 0:
-		store_0_eventually(cache_line, reps);
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		break;
-	      case 1:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps);
-		B2;			/* BARRIER 2 */
-		store_0_eventually_pfd1(cache_line, reps);
-		break;
-	      default:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually_no_pf(cache_line);
-		B2;			/* BARRIER 2 */
-		break;
+		PRINT(" ** Results from Core 0 : load from invalid");
+	      }
+	    else
+	      {
+		PRINT(" ** Results from Core 0 : load from invalid, BUT could have prefetching");
 	      }
+	    PRINT(" ** Results from Core 1 : store on exclusive");
 	    break;
 	  }
-	case STORE_ON_INVALID:	/* 6 */
+	case STORE_ON_SHARED:
 	  {
-	    switch (ID)
+	    PRINT(" ** Results from Core 0 & 2: load from modified and exclusive or shared, respectively");
+	    PRINT(" ** Results from Core 1 : store on shared");
+	    if (test_cores < 3)
 	      {
-	      case 0:
-		B1;
-		/* store_0_eventually(cache_line, reps); */
-		store_0(cache_line, reps);
-		if (!test_flush)
-		  {
-		    cache_line += test_stride;
-		  }
-		break;
-	      case 1:
-		invalidate(cache_line, 0, reps);
-		if (!test_flush)
-		  {
-		    cache_line += test_stride;
-		  }
-		B1;
-		break;
-	      default:
-		B1;
-		break;
+		PRINT(" ** Need >=3 processes to achieve STORE_ON_SHARED");
 	      }
 	    break;
 	  }
-	case LOAD_FROM_MODIFIED: /* 7 */
+	case STORE_ON_OWNED_MINE:
 	  {
-	    switch (ID)
+	    PRINT(" ** Results from Core 0 : load from modified (makes it owned, if owned state is supported)");
+	    if (test_flush)
 	      {
-	      case 0:
-		store_0_eventually(cache_line, reps);
-		B1;		
-		break;
-	      case 1:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps);
-		break;
-	      default:
-		B1;
-		break;
+		PRINT(" ** Results 1 from Core 1 : store to invalid");
 	      }
-	    break;
-	  }
-	case LOAD_FROM_EXCLUSIVE: /* 8 */
-	  {
-	    switch (ID)
+	    else
 	      {
-	      case 0:
-		sum += load_0_eventually(cache_line, reps);
-		B1;			/* BARRIER 1 */
-
-		if (!test_flush)
-		  {
-		    cache_line += test_stride;
-		  }
-		break;
-	      case 1:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps);
-
-		if (!test_flush)
-		  {
-		    cache_line += test_stride;
-		  }
-		break;
-	      default:
-		B1;			/* BARRIER 1 */
-		break;
+		PRINT(" ** Results 1 from Core 1 : store to modified mine");
 	      }
+
+	    PRINT(" ** Results 2 from Core 1 : store to owned mine (if owned is supported, else exclusive)");
 	    break;
 	  }
-	case LOAD_FROM_SHARED:	/* 9 */
+	case STORE_ON_OWNED:
 	  {
-	    switch (ID)
+	    if (test_flush)
 	      {
-	      case 0:
-		sum += load_0_eventually(cache_line, reps);
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		break;
-	      case 1:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps);
-		B2;			/* BARRIER 2 */
-		break;
-	      case 2:
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		sum += load_0_eventually(cache_line, reps);
-		break;
-	      default:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually_no_pf(cache_line);
-		B2;			/* BARRIER 2 */
-		break;
+		PRINT(" ** Results from Core 0 : store to modified");
 	      }
-
-	    if (!test_flush)
+	    else
 	      {
-		cache_line += test_stride;
+		PRINT(" ** Results from Core 0 : store to invalid");
 	      }
+	    PRINT(" ** Results 1 from Core 1 : load from modified (makes it owned, if owned state is supported)");
+	    PRINT(" ** Results 2 from Core 1 : store to owned (if owned is supported, else exclusive mine)");
 	    break;
 	  }
-	case LOAD_FROM_OWNED:	/* 10 */
+	case LOAD_FROM_MODIFIED:
 	  {
-	    switch (ID)
+	    if (test_flush)
 	      {
-	      case 0:
-		store_0_eventually(cache_line, reps);
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		break;
-	      case 1:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps);
-		B2;			/* BARRIER 2 */
-		break;
-	      case 2:
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		sum += load_0_eventually(cache_line, reps);
-		break;
-	      default:
-		B1;			/* BARRIER 1 */
-		B2;			/* BARRIER 2 */
-		break;
+		PRINT(" ** Results from Core 0 : store to invalid");
+	      }
+	    else
+	      {
+		PRINT(" ** Results from Core 0 : store to owned mine (if owned state supported, else exclusive)");
 	      }
+
+	    PRINT(" ** Results from Core 1 : load from modified (makes it owned, if owned state supported)");
+
 	    break;
 	  }
-	case LOAD_FROM_INVALID:	/* 11 */
+	case LOAD_FROM_EXCLUSIVE:
 	  {
-	    switch (ID)
+	    if (test_flush)
 	      {
-	      case 0:
-		B1;			/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps); 		/* sum += load_0(cache_line, reps); */
-		break;
-	      case 1:
-		invalidate(cache_line, 0, reps);
-		B1;			/* BARRIER 1 */
-		break;
-	      default:
-		B1;			/* BARRIER 1 */
-		break;
+		PRINT(" ** Results from Core 0 : load from invalid");
 	      }
-
-	    if (!test_flush)
+	    else
 	      {
-		cache_line += test_stride;
+		PRINT(" ** Results from Core 0 : load from invalid, BUT could have prefetching");
 	      }
+	    PRINT(" ** Results from Core 1 : load from exclusive");
+
 	    break;
 	  }
-	case CAS: /* 12 */
+	case STORE_ON_INVALID:
 	  {
-	    switch (ID)
-	      {
-	      case 0:
-		sum += cas_0_eventually(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		break;
-	      case 1:
-		B1;		/* BARRIER 1 */
-		sum += cas_0_eventually(cache_line, reps);
-		break;
-	      default:
-		B1;		/* BARRIER 1 */
-		break;
-	      }
+	    PRINT(" ** Results from Core 0 : store on invalid");
+	    PRINT(" ** Results from Core 1 : cache line flush");
 	    break;
 	  }
-	case FAI: /* 13 */
+	case LOAD_FROM_INVALID:
 	  {
-	    switch (ID)
-	      {
-	      case 0:
-		sum += fai(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		break;
-	      case 1:
-		B1;		/* BARRIER 1 */
-		sum += fai(cache_line, reps);
-		break;
-	      default:
-		B1;		/* BARRIER 1 */
-		break;
-	      }
+	    PRINT(" ** Results from Core 0 : load from invalid");
+	    PRINT(" ** Results from Core 1 : cache line flush");
 	    break;
 	  }
-	case TAS:		/* 14 */
+	case LOAD_FROM_SHARED:
 	  {
-	    switch (ID)
+	    if (test_flush)
 	      {
-	      case 0:
-		sum += tas(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
-		break;
-	      case 1:
-		B1;		/* BARRIER 1 */
-		sum += tas(cache_line, reps);
-		_mm_mfence();
-		cache_line->word[0] = 0;
-		B2;		/* BARRIER 2 */
-		break;
-	      default:
-		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
-		break;
+		PRINT(" ** Results from Core 0 : load from invalid");
 	      }
-	    break;
-	  }
-	case SWAP: /* 15 */
-	  {
-	    switch (ID)
+	    else
 	      {
-	      case 0:
-		sum += swap(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		break;
-	      case 1:
-		B1;		/* BARRIER 1 */
-		sum += swap(cache_line, reps);
-		break;
-	      default:
-		B1;		/* BARRIER 1 */
-		break;
+		PRINT(" ** Results from Core 0 : load from invalid, BUT could have prefetching");
+	      }
+	    PRINT(" ** Results from Core 1 : load from exclusive");
+	    if (test_cores >= 3)
+	      {
+		PRINT(" ** Results from Core 2 : load from shared");
+	      }
+	    else
+	      {
+		PRINT(" ** Need >=3 processes to achieve LOAD_FROM_SHARED");
 	      }
 	    break;
 	  }
-	case CAS_ON_MODIFIED: /* 16 */
+	case LOAD_FROM_OWNED:
 	  {
-	    switch (ID)
+	    if (test_flush)
 	      {
-	      case 0:
-		store_0_eventually(cache_line, reps);
-		if (test_ao_success)
-		  {
-		    cache_line->word[0] = reps & 0x01;
-		  }
-		B1;		/* BARRIER 1 */
-		break;
-	      case 1:
-		B1;		/* BARRIER 1 */
-		sum += cas_0_eventually(cache_line, reps);
-		break;
-	      default:
-		B1;		/* BARRIER 1 */
-		break;
+		PRINT(" ** Results from Core 0 : store to invalid");
+	      }
+	    else
+	      {
+		PRINT(" ** Results from Core 0 : store to owned mine (if owned is supported, else shared)");
+	      }
+	    PRINT(" ** Results from Core 1 : load from modified");
+	    if (test_cores == 3)
+	      {
+		PRINT(" ** Results from Core 2 : load from owned");
+	      }
+	    else
+	      {
+		PRINT(" ** Need 3 processes to achieve LOAD_FROM_OWNED");
 	      }
 	    break;
 	  }
-	case FAI_ON_MODIFIED: /* 17 */
+	case CAS:
 	  {
-	    switch (ID)
-	      {
-	      case 0:
-		store_0_eventually(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		break;
-	      case 1:
-		B1;		/* BARRIER 1 */
-		sum += fai(cache_line, reps);
-		break;
-	      default:
-		B1;		/* BARRIER 1 */
-		break;
-	      }
+	    PRINT(" ** Results from Core 0 : CAS successfull");
+	    PRINT(" ** Results from Core 1 : CAS unsuccessfull");
 	    break;
 	  }
-	case TAS_ON_MODIFIED: /* 18 */
+	case FAI:
+	  {
+	    PRINT(" ** Results from Cores 0 & 1: FAI");
+	    break;
+	  }
+	case TAS:
+	  {
+	    PRINT(" ** Results from Core 0 : TAS successfull");
+	    PRINT(" ** Results from Core 1 : TAS unsuccessfull");
+	    break;
+	  }
+	case SWAP:
+	  {
+	    PRINT(" ** Results from Cores 0 & 1: SWAP");
+	    break;
+	  }
+	case CAS_ON_MODIFIED:
+	  {
+	    PRINT(" ** Results from Core 0 : store on modified");
+	    uint32_t succ = 50 + test_ao_success * 50;
+	    PRINT(" ** Results from Core 1 : CAS on modified (%d%% successfull)", succ);
+	    break;
+	  }
+	case FAI_ON_MODIFIED:
+	  {
+	    PRINT(" ** Results from Core 0 : store on modified");
+	    PRINT(" ** Results from Core 1 : FAI on modified");
+	    break;
+	  }
+	case TAS_ON_MODIFIED:
+	  {
+	    PRINT(" ** Results from Core 0 : store on modified");
+	    uint32_t succ = test_ao_success * 100;
+	    PRINT(" ** Results from Core 1 : TAS on modified (%d%% successfull)", succ);
+	    break;
+	  }
+	case SWAP_ON_MODIFIED:
+	  {
+	    PRINT(" ** Results from Core 0 : store on modified");
+	    PRINT(" ** Results from Core 1 : SWAP on modified");
+	    break;
+	  }
+	case CAS_ON_SHARED:
+	  {
+	    PRINT(" ** Results from Core 0 : load from modified");
+	    PRINT(" ** Results from Core 1 : CAS on shared (100%% successfull)");
+	    PRINT(" ** Results from Core 2 : load from exlusive or shared");
+	    if (test_cores < 3)
+	      {
+		PRINT(" ** Need >=3 processes to achieve CAS_ON_SHARED");
+	      }
+	    break;
+	  }
+	case FAI_ON_SHARED:
+	  {
+	    PRINT(" ** Results from Core 0 : load from modified");
+	    PRINT(" ** Results from Core 1 : FAI on shared");
+	    PRINT(" ** Results from Core 2 : load from exlusive or shared");
+	    if (test_cores < 3)
+	      {
+		PRINT(" ** Need >=3 processes to achieve FAI_ON_SHARED");
+	      }
+	    break;
+	  }
+	case TAS_ON_SHARED:
+	  {
+	    PRINT(" ** Results from Core 0 : load from L1");
+	    uint32_t succ = test_ao_success * 100;
+	    PRINT(" ** Results from Core 1 : TAS on shared (%d%% successfull)", succ);
+	    PRINT(" ** Results from Core 2 : load from exlusive or shared");
+	    if (test_cores < 3)
+	      {
+		PRINT(" ** Need >=3 processes to achieve TAS_ON_SHARED");
+	      }
+	    break;
+	  }
+	case SWAP_ON_SHARED:
+	  {
+	    PRINT(" ** Results from Core 0 : load from modified");
+	    PRINT(" ** Results from Core 1 : SWAP on shared");
+	    PRINT(" ** Results from Core 2 : load from exlusive or shared");
+	    if (test_cores < 3)
+	      {
+		PRINT(" ** Need >=3 processes to achieve SWAP_ON_SHARED");
+	      }
+	    break;
+	  }
+        case CAS_CONCURRENT:
+          {
+            PRINT(" ** Results from %u cores: CAS concurrent", test_cores);
+            break;
+          }
+	case FAI_ON_INVALID:
+	  {
+	    PRINT(" ** Results from Core 0 : FAI on invalid");
+	    PRINT(" ** Results from Core 1 : cache line flush");
+	    break;
+	  }
+	case LOAD_FROM_L1:
+	  {
+	    PRINT(" ** Results from Core 0: load from L1");
+	    break;
+	  }
+	case LOAD_FROM_MEM_SIZE:
+	  {
+	    if (test_sweep_mem)
+	      {
+		sweep_mem_report();
+		break;
+	      }
+	    PRINT(" ** Results from Corees 0 & 1 & 2: load from random %zu KiB", test_mem_size / 1024);
+	    break;
+	  }
+	case LFENCE:
+	  {
+	    PRINT(" ** Results from Cores 0 & 1: load fence");
+	    break;
+	  }
+	case SFENCE:
+	  {
+	    PRINT(" ** Results from Cores 0 & 1: store fence");
+	    break;
+	  }
+	case MFENCE:
+	  {
+	    PRINT(" ** Results from Cores 0 & 1: full fence");
+	    break;
+	  }
+	case PROFILER:
+	  {
+	    PRINT(" ** Results from Cores 0 & 1: empty profiler region (start_prof - empty - stop_prof");
+	    break;
+	  }
+	case CAS_THROUGHPUT:
+	case FAI_THROUGHPUT:
+	case SWAP_THROUGHPUT:
+	case TAS_THROUGHPUT:
+	  {
+	    PRINT(" ** Results from %u cores: sampled latency of %s", test_cores, moesi_type_des[test_test]);
+	    throughput_report();
+	    break;
+	  }
+	case LOCK_UNCONTENDED:
+	  {
+	    PRINT(" ** Results 1 from Core 0 : uncontended %s acquire", lock_type_des[test_lock]);
+	    PRINT(" ** Results 2 from Core 0 : uncontended %s release", lock_type_des[test_lock]);
+	    break;
+	  }
+	case LOCK_HANDOFF:
+	  {
+	    PRINT(" ** Results from Core 0 : %s handoff (release on core 1 until acquired on core 0)",
+		  lock_type_des[test_lock]);
+	    PRINT(" ** Results from Core 1 : %s release with a waiter", lock_type_des[test_lock]);
+	    if (test_cores < 2)
+	      {
+		PRINT(" ** Need >=2 processes to achieve LOCK_HANDOFF");
+	      }
+	    break;
+	  }
+	case LOCK_THROUGHPUT:
+	  {
+	    PRINT(" ** Results from %u cores: sampled %s acquire latency (critical section of %u cycles)",
+		  test_cores, lock_type_des[test_lock], test_cs_length);
+	    throughput_report();
+	    break;
+	  }
+	case BANDWIDTH:
+	  {
+	    PRINT(" ** Results from %u cores: cycles per 64-byte line of one %s pass",
+		  test_cores, bw_kernel_des[test_bw_kernel]);
+	    bandwidth_report();
+	    break;
+	  }
+	case PINGPONG:
+	  {
+	    pingpong_report();
+	    break;
+	  }
+	case MLP:
+	  {
+	    mlp_report();
+	    break;
+	  }
+	case TLB_SWEEP:
+	  {
+	    tlb_sweep_report();
+	    break;
+	  }
+	case RING:
+	  {
+	    ring_report();
+	    break;
+	  }
+	case BROADCAST:
+	  {
+	    broadcast_report();
+	    break;
+	  }
+	case ATOMIC_MATRIX:
+	  {
+	    atomic_matrix_report();
+	    break;
+	  }
+	case SMT_INTERFERENCE:
+	  {
+	    smt_report();
+	    break;
+	  }
+	case LOCKFREE:
+	  {
+	    PRINT(" ** Results from %u cores: %s, %u%% updates", test_cores, lf_struct_des[test_lf_struct],
+		  test_update_ratio);
+	    if (!test_scale)
+	      {
+		lf_report(test_cores);
+	      }
+	    break;
+	  }
+	case LITMUS_SB:
+	case LITMUS_MP:
+	case LITMUS_LB:
+	case LITMUS_IRIW:
+	  {
+	    litmus_report();
+	    break;
+	  }
+	case FALSE_SHARING:
+	  {
+	    PRINT(" ** Results from %u cores: sampled latency of incrementing a private word (%s)",
+		  test_cores, fs_layout_des[test_fs_layout]);
+	    throughput_report();
+	    break;
+	  }
+
+	default:
+	  break;
+	}
+      if (test_store_kind != STORE_WORD)
+	{
+	  PRINT(" ** The timed stores write the full line with %s; their Results 2: the sfence after them",
+		store_kind_des[test_store_kind]);
+	}
+      if (report_records != NULL)
+	{
+	  report_close(report_records);
+	}
+    }
+
+  B0;
+
+
+  if (ID < test_cores)
+    {
+      PRINT(" value of cl is %-10u / sum is %llu", cache_line->word[0], (LLU) sum);
+    }
+  cache_line_close(ID, "cache_line");
+  barriers_term(ID);
+
+}
+
+/* the barrier-separated repetitions of the rep-loop events; the strided events advance */
+/* their copy of cache_line */
+static uint64_t
+rep_loop(volatile cache_line_t* cache_line, volatile uint64_t* cl, const uint32_t loop_reps)
+{
+  uint64_t sum = 0;
+
+  volatile uint64_t reps;
+  for (reps = 0; reps < loop_reps; reps++)
+    {
+      if (test_flush)
+	{
+	  _mm_mfence();
+	  flush_line(cache_line);
+	  _mm_mfence();
+	}
+
+      B0;			/* BARRIER 0 */
+
+      switch (test_test)
+	{
+	case STORE_ON_MODIFIED: /* 0 */
 	  {
 	    switch (ID)
 	      {
 	      case 0:
 		store_0_eventually(cache_line, reps);
-		if (!test_ao_success)
-		  {
-		    cache_line->word[0] = 0xFFFFFFFF;
-		    _mm_mfence();
-		  }
 		B1;		/* BARRIER 1 */
 		break;
 	      case 1:
 		B1;		/* BARRIER 1 */
-		sum += tas(cache_line, reps);
+		store_0_eventually_kind(cache_line, reps);
 		break;
 	      default:
 		B1;		/* BARRIER 1 */
@@ -1089,166 +2448,262 @@ run_worker(uint32_t rank)
 	      }
 	    break;
 	  }
-	case SWAP_ON_MODIFIED: /* 19 */
+	case STORE_ON_MODIFIED_NO_SYNC: /* 1 */
 	  {
 	    switch (ID)
 	      {
 	      case 0:
-		store_0_eventually(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		break;
 	      case 1:
-		B1;		/* BARRIER 1 */
-		sum += swap(cache_line, reps);
+	      case 2:
+		store_0_kind(cache_line, reps);
 		break;
 	      default:
-		B1;		/* BARRIER 1 */
+		store_0_no_pf(cache_line, reps);
 		break;
 	      }
 	    break;
 	  }
-	case CAS_ON_SHARED: /* 20 */
+	case STORE_ON_EXCLUSIVE: /* 2 */
 	  {
 	    switch (ID)
 	      {
 	      case 0:
 		sum += load_0_eventually(cache_line, reps);
 		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
 		break;
 	      case 1:
 		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
-		sum += cas_0_eventually(cache_line, reps);
-		break;
-	      case 2:
-		B1;		/* BARRIER 1 */
-		sum += load_0_eventually(cache_line, reps);
-		B2;		/* BARRIER 2 */
+		store_0_eventually_kind(cache_line, reps);
 		break;
 	      default:
 		B1;		/* BARRIER 1 */
-		sum += load_0_eventually_no_pf(cache_line);
-		B2;			/* BARRIER 2 */
 		break;
 	      }
+
+	    if (!test_flush)
+	      {
+		cache_line += test_stride;
+	      }
 	    break;
 	  }
-	case FAI_ON_SHARED: /* 21 */
+	case STORE_ON_SHARED:	/* 3 */
 	  {
 	    switch (ID)
 	      {
 	      case 0:
 		sum += load_0_eventually(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
+		B1;			/* BARRIER 1 */
+		B2;			/* BARRIER 2 */
 		break;
 	      case 1:
-		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
-		sum += fai(cache_line, reps);
+		B1;			/* BARRIER 1 */
+		B2;			/* BARRIER 2 */
+		store_0_eventually_kind(cache_line, reps);
 		break;
 	      case 2:
-		B1;		/* BARRIER 1 */
+		B1;			/* BARRIER 1 */
 		sum += load_0_eventually(cache_line, reps);
-		B2;		/* BARRIER 2 */
+		B2;			/* BARRIER 2 */
 		break;
 	      default:
-		B1;		/* BARRIER 1 */
+		B1;			/* BARRIER 1 */
 		sum += load_0_eventually_no_pf(cache_line);
 		B2;			/* BARRIER 2 */
 		break;
 	      }
 	    break;
 	  }
-	case TAS_ON_SHARED: /* 22 */
+	case STORE_ON_OWNED_MINE: /* 4 */
 	  {
 	    switch (ID)
 	      {
 	      case 0:
-		if (test_ao_success)
+		B1;			/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+		B2;			/* BARRIER 2 */
+		break;
+	      case 1:
+		store_0_eventually(cache_line, reps);
+		B1;			/* BARRIER 1 */
+		B2;			/* BARRIER 2 */
+		store_0_eventually_pfd1(cache_line, reps);
+		break;
+	      default:
+		B1;			/* BARRIER 1 */
+		sum += load_0_eventually_no_pf(cache_line);
+		B2;			/* BARRIER 2 */
+		break;
+	      }
+	    break;
+	  }
+	case STORE_ON_OWNED:	/* 5 */
+	  {
+	    switch (ID)
+	      {
+	      case 0:
+		store_0_eventually(cache_line, reps);
+		B1;			/* BARRIER 1 */
+		B2;			/* BARRIER 2 */
+		break;
+	      case 1:
+		B1;			/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+		B2;			/* BARRIER 2 */
+		store_0_eventually_pfd1(cache_line, reps);
+		break;
+	      default:
+		B1;			/* BARRIER 1 */
+		sum += load_0_eventually_no_pf(cache_line);
+		B2;			/* BARRIER 2 */
+		break;
+	      }
+	    break;
+	  }
+	case STORE_ON_INVALID:	/* 6 */
+	  {
+	    switch (ID)
+	      {
+	      case 0:
+		B1;
+		/* store_0_eventually(cache_line, reps); */
+		store_0_kind(cache_line, reps);
+		if (!test_flush)
 		  {
-		    cache_line->word[0] = 0;
+		    cache_line += test_stride;
 		  }
-		else
+		break;
+	      case 1:
+		invalidate(cache_line, 0, reps);
+		if (!test_flush)
 		  {
-		    cache_line->word[0] = 0xFFFFFFFF;
+		    cache_line += test_stride;
 		  }
+		B1;
+		break;
+	      default:
+		B1;
+		break;
+	      }
+	    break;
+	  }
+	case LOAD_FROM_MODIFIED: /* 7 */
+	  {
+	    switch (ID)
+	      {
+	      case 0:
+		store_0_eventually(cache_line, reps);
+		B1;		
+		break;
+	      case 1:
+		B1;			/* BARRIER 1 */
 		sum += load_0_eventually(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
+		break;
+	      default:
+		B1;
+		break;
+	      }
+	    break;
+	  }
+	case LOAD_FROM_EXCLUSIVE: /* 8 */
+	  {
+	    switch (ID)
+	      {
+	      case 0:
+		sum += load_0_eventually(cache_line, reps);
+		B1;			/* BARRIER 1 */
+
+		if (!test_flush)
+		  {
+		    cache_line += test_stride;
+		  }
 		break;
 	      case 1:
-		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
-		sum += tas(cache_line, reps);
+		B1;			/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+
+		if (!test_flush)
+		  {
+		    cache_line += test_stride;
+		  }
+		break;
+	      default:
+		B1;			/* BARRIER 1 */
+		break;
+	      }
+	    break;
+	  }
+	case LOAD_FROM_SHARED:	/* 9 */
+	  {
+	    switch (ID)
+	      {
+	      case 0:
+		sum += load_0_eventually(cache_line, reps);
+		B1;			/* BARRIER 1 */
+		B2;			/* BARRIER 2 */
+		break;
+	      case 1:
+		B1;			/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+		B2;			/* BARRIER 2 */
 		break;
 	      case 2:
-		B1;		/* BARRIER 1 */
+		B1;			/* BARRIER 1 */
+		B2;			/* BARRIER 2 */
 		sum += load_0_eventually(cache_line, reps);
-		B2;		/* BARRIER 2 */
 		break;
 	      default:
-		B1;		/* BARRIER 1 */
+		B1;			/* BARRIER 1 */
 		sum += load_0_eventually_no_pf(cache_line);
 		B2;			/* BARRIER 2 */
 		break;
 	      }
+
+	    if (!test_flush)
+	      {
+		cache_line += test_stride;
+	      }
 	    break;
 	  }
-	case SWAP_ON_SHARED: /* 23 */
+	case LOAD_FROM_OWNED:	/* 10 */
 	  {
 	    switch (ID)
 	      {
 	      case 0:
-		sum += load_0_eventually(cache_line, reps);
-		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
+		store_0_eventually(cache_line, reps);
+		B1;			/* BARRIER 1 */
+		B2;			/* BARRIER 2 */
 		break;
 	      case 1:
-		B1;		/* BARRIER 1 */
-		B2;		/* BARRIER 2 */
-		sum += swap(cache_line, reps);
+		B1;			/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+		B2;			/* BARRIER 2 */
 		break;
 	      case 2:
-		B1;		/* BARRIER 1 */
+		B1;			/* BARRIER 1 */
+		B2;			/* BARRIER 2 */
 		sum += load_0_eventually(cache_line, reps);
-		B2;		/* BARRIER 2 */
 		break;
 	      default:
-		B1;		/* BARRIER 1 */
-		sum += load_0_eventually_no_pf(cache_line);
+		B1;			/* BARRIER 1 */
 		B2;			/* BARRIER 2 */
 		break;
 	      }
 	    break;
 	  }
-        case CAS_CONCURRENT: /* 24 */
-          {
-            if (ID < test_cores)
-              {
-                sum += cas(cache_line, reps);
-              }
-            else
-              {
-                sum += cas_no_pf(cache_line, reps);
-              }
-            break;
-          }
-	case FAI_ON_INVALID:	/* 25 */
+	case LOAD_FROM_INVALID:	/* 11 */
 	  {
 	    switch (ID)
 	      {
 	      case 0:
-		B1;		/* BARRIER 1 */
-		sum += fai(cache_line, reps);
+		B1;			/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps); 		/* sum += load_0(cache_line, reps); */
 		break;
 	      case 1:
 		invalidate(cache_line, 0, reps);
-		B1;		/* BARRIER 1 */
+		B1;			/* BARRIER 1 */
 		break;
 	      default:
-		B1;		/* BARRIER 1 */
+		B1;			/* BARRIER 1 */
 		break;
 	      }
 
@@ -1258,512 +2713,4080 @@ run_worker(uint32_t rank)
 	      }
 	    break;
 	  }
-	case LOAD_FROM_L1:	/* 26 */
+	case CAS: /* 12 */
 	  {
-	    if (ID == 0)
+	    switch (ID)
 	      {
-		sum += load_0(cache_line, reps);
-		sum += load_0(cache_line, reps);
-		sum += load_0(cache_line, reps);
+	      case 0:
+		sum += cas_0_eventually(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		sum += cas_0_eventually(cache_line, reps);
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
 	    break;
 	  }
-	case LOAD_FROM_MEM_SIZE: /* 27 */
+	case FAI: /* 13 */
 	  {
-	    if (ID < test_cores)
+	    switch (ID)
 	      {
-		sum += load_next(cl, reps);
+	      case 0:
+		sum += fai(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		sum += fai(cache_line, reps);
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
+	    break;
 	  }
-	  break;
-	case LFENCE:		/* 28 */
-	  if (ID < 2)
-	    {
-	      PFDI(0);
-	      _mm_lfence();
-	      PFDO(0, reps);
-	    }
-	  break;
-	case SFENCE:		/* 29 */
-	  if (ID < 2)
-	    {
-	      PFDI(0);
-	      _mm_sfence();
-	      PFDO(0, reps);
-	    }
-	  break;
-	case MFENCE:		/* 30 */
-	  if (ID < 2)
-	    {
-	      PFDI(0);
-	      _mm_mfence();
-	      PFDO(0, reps);
-	    }
-	  break;
-	case PAUSE:		/* 31 */
-	  if (ID < 2)
-	    {
-	      PFDI(0);
-	      _mm_pause();
-	      PFDO(0, reps);
-	    }
-	  break;
-	case NOP:		/* 32 */
-	  if (ID < 2)
-	    {
-	      PFDI(0);
-	      asm volatile ("nop");
-	      PFDO(0, reps);
-	    }
-	  break;
-	case PROFILER:		/* 30 */
-	default:
-	  PFDI(0);
-	  asm volatile ("");
-	  PFDO(0, reps);
-	  break;
-	}
-
-      B3;			/* BARRIER 3 */
-    }
-
-  if (!test_verbose)
-    {
-      test_print = 0;
-    }
-
-  uint32_t id;
-  for (id = 0; id < test_cores; id++)
-    {
-      if (ID == id && ID < test_cores)
-	{
-	  switch (test_test)
-	    {
-	    case STORE_ON_OWNED_MINE:
-	    case STORE_ON_OWNED:
-	      if (ID < 2)
-		{
-		  PRINT(" *** Core %ld ************************************************************************************", core);
-		  collect_core_stats(0, test_reps, test_print);
-		  if (ID == 1)
-		    {
-		      collect_core_stats(1, test_reps, test_print);
-		    }
-		}
-	      break;
-            case CAS_CONCURRENT:
-              PRINT(" *** Core %ld ************************************************************************************", core);
-              collect_core_stats(0, test_reps, test_print);
-              break;
-	    case LOAD_FROM_L1:
-	      if (ID < 1)
-		{
-		  PRINT(" *** Core %ld ************************************************************************************", core);
-		  collect_core_stats(0, test_reps, test_print);
-		}
-	      break;
-	    case LOAD_FROM_MEM_SIZE:
-	      if (ID < test_cores)
-		{
-		  PRINT(" *** Core %ld ************************************************************************************", core);
-		  collect_core_stats(0, test_reps, test_print);
-		}
-	      break;
-	    default:
-	      PRINT(" *** Core %ld ************************************************************************************", core);
-	      collect_core_stats(0, test_reps, test_print);
-	    }
-	}
-      B0;
-    }
-  B10;
-
-
-  if (ID == 0)
-    {
-      PRINT(" ---- Cross-core summary ------------------------------------------------------------");
-      double min_avg = DBL_MAX;
-      double max_avg = 0.0;
-      double sum_avg = 0.0;
-      uint32_t min_core = 0;
-      uint32_t max_core = 0;
-      uint32_t cores_with_stats = 0;
-
-      uint32_t core_idx;
-      for (core_idx = 0; core_idx < test_cores; core_idx++)
-        {
-          const core_summary_t* summary = &core_summaries[core_idx];
-          const abs_deviation_t* stats = NULL;
-          uint32_t store_idx;
-          for (store_idx = 0; store_idx < PFD_NUM_STORES; store_idx++)
-            {
-              if (summary->store_valid[store_idx])
-                {
-                  stats = &summary->store[store_idx];
-                  break;
-                }
-            }
-
-          if (stats == NULL)
-            {
-              PRINT(" Core %u : no samples recorded", test_cores_array[core_idx]);
-              continue;
-            }
-
-          double avg = stats->avg;
-          PRINT(" Core %u : avg %8.1f cycles (min %8.1f | max %8.1f)",
-                test_cores_array[core_idx], avg, stats->min_val, stats->max_val);
-          sum_avg += avg;
-          cores_with_stats++;
-          if (avg < min_avg)
-            {
-              min_avg = avg;
-              min_core = test_cores_array[core_idx];
-            }
-          if (avg > max_avg)
-            {
-              max_avg = avg;
-              max_core = test_cores_array[core_idx];
-            }
-        }
-
-      if (cores_with_stats > 0)
-        {
-          double mean_avg = sum_avg / cores_with_stats;
-          PRINT(" Summary : mean avg %8.1f cycles | min avg %8.1f (core %u) | max avg %8.1f (core %u)",
-                mean_avg, min_avg, min_core, max_avg, max_core);
-        }
-      else
-        {
-          PRINT(" Summary : no statistics captured");
-        }
-
-      switch (test_test)
-        {
-        case STORE_ON_MODIFIED:
-          {
-	    if (test_flush)
-	      {
-		PRINT(" ** Results from Core 0 : store on invalid");
-		PRINT(" ** Results from Core 1 : store on modified");
-	      }
-	    else
+	case TAS:		/* 14 */
+	  {
+	    switch (ID)
 	      {
-		PRINT(" ** Results from Core 0 and 1 : store on modified");
+	      case 0:
+		sum += tas(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		sum += tas(cache_line, reps);
+		_mm_mfence();
+		ao_set(cache_line, 0);
+		B2;		/* BARRIER 2 */
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		break;
 	      }
 	    break;
 	  }
-	case STORE_ON_MODIFIED_NO_SYNC:
+	case SWAP: /* 15 */
 	  {
-	    if (test_flush)
-	      {
-		PRINT(" ** Results do not make sense");
-	      }
-	    else
+	    switch (ID)
 	      {
-		PRINT(" ** Results from Core 0 and 1 : store on modified while another core is "
-		      "also trying to do the same");
+	      case 0:
+		sum += swap(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		sum += swap(cache_line, reps);
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
 	    break;
 	  }
-	case STORE_ON_EXCLUSIVE:
+	case CAS_ON_MODIFIED: /* 16 */
 	  {
-	    if (test_flush)
-	      {
-		PRINT(" ** Results from Core 0 : load from invalid");
-	      }
-	    else
+	    switch (ID)
 	      {
-		PRINT(" ** Results from Core 0 : load from invalid, BUT could have prefetching");
+	      case 0:
+		store_0_eventually(cache_line, reps);
+		if (test_ao_success)
+		  {
+		    cache_line->word[0] = reps & 0x01;
+		  }
+		B1;		/* BARRIER 1 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		sum += cas_0_eventually(cache_line, reps);
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
-	    PRINT(" ** Results from Core 1 : store on exclusive");
 	    break;
 	  }
-	case STORE_ON_SHARED:
+	case FAI_ON_MODIFIED: /* 17 */
 	  {
-	    PRINT(" ** Results from Core 0 & 2: load from modified and exclusive or shared, respectively");
-	    PRINT(" ** Results from Core 1 : store on shared");
-	    if (test_cores < 3)
+	    switch (ID)
 	      {
-		PRINT(" ** Need >=3 processes to achieve STORE_ON_SHARED");
+	      case 0:
+		store_0_eventually(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		sum += fai(cache_line, reps);
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
 	    break;
 	  }
-	case STORE_ON_OWNED_MINE:
+	case TAS_ON_MODIFIED: /* 18 */
 	  {
-	    PRINT(" ** Results from Core 0 : load from modified (makes it owned, if owned state is supported)");
-	    if (test_flush)
-	      {
-		PRINT(" ** Results 1 from Core 1 : store to invalid");
-	      }
-	    else
+	    switch (ID)
 	      {
-		PRINT(" ** Results 1 from Core 1 : store to modified mine");
+	      case 0:
+		store_0_eventually(cache_line, reps);
+		if (!test_ao_success)
+		  {
+		    ao_set(cache_line, 1);
+		    _mm_mfence();
+		  }
+		B1;		/* BARRIER 1 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		sum += tas(cache_line, reps);
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
-
-	    PRINT(" ** Results 2 from Core 1 : store to owned mine (if owned is supported, else exclusive)");
 	    break;
 	  }
-	case STORE_ON_OWNED:
+	case SWAP_ON_MODIFIED: /* 19 */
 	  {
-	    if (test_flush)
+	    switch (ID)
 	      {
-		PRINT(" ** Results from Core 0 : store to modified");
-	      }
-	    else
-	      {
-		PRINT(" ** Results from Core 0 : store to invalid");
+	      case 0:
+		store_0_eventually(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		sum += swap(cache_line, reps);
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
-	    PRINT(" ** Results 1 from Core 1 : load from modified (makes it owned, if owned state is supported)");
-	    PRINT(" ** Results 2 from Core 1 : store to owned (if owned is supported, else exclusive mine)");
 	    break;
 	  }
-	case LOAD_FROM_MODIFIED:
+	case CAS_ON_SHARED: /* 20 */
 	  {
-	    if (test_flush)
-	      {
-		PRINT(" ** Results from Core 0 : store to invalid");
-	      }
-	    else
+	    switch (ID)
 	      {
-		PRINT(" ** Results from Core 0 : store to owned mine (if owned state supported, else exclusive)");
+	      case 0:
+		sum += load_0_eventually(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		sum += cas_0_eventually(cache_line, reps);
+		break;
+	      case 2:
+		B1;		/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+		B2;		/* BARRIER 2 */
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		sum += load_0_eventually_no_pf(cache_line);
+		B2;			/* BARRIER 2 */
+		break;
 	      }
-
-	    PRINT(" ** Results from Core 1 : load from modified (makes it owned, if owned state supported)");
-
 	    break;
 	  }
-	case LOAD_FROM_EXCLUSIVE:
+	case FAI_ON_SHARED: /* 21 */
 	  {
-	    if (test_flush)
-	      {
-		PRINT(" ** Results from Core 0 : load from invalid");
-	      }
-	    else
+	    switch (ID)
 	      {
-		PRINT(" ** Results from Core 0 : load from invalid, BUT could have prefetching");
+	      case 0:
+		sum += load_0_eventually(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		sum += fai(cache_line, reps);
+		break;
+	      case 2:
+		B1;		/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+		B2;		/* BARRIER 2 */
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		sum += load_0_eventually_no_pf(cache_line);
+		B2;			/* BARRIER 2 */
+		break;
 	      }
-	    PRINT(" ** Results from Core 1 : load from exclusive");
-
 	    break;
 	  }
-	case STORE_ON_INVALID:
+	case TAS_ON_SHARED: /* 22 */
 	  {
-	    PRINT(" ** Results from Core 0 : store on invalid");
-	    PRINT(" ** Results from Core 1 : cache line flush");
+	    switch (ID)
+	      {
+	      case 0:
+		ao_set(cache_line, !test_ao_success);
+		sum += load_0_eventually(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		sum += tas(cache_line, reps);
+		break;
+	      case 2:
+		B1;		/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+		B2;		/* BARRIER 2 */
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		sum += load_0_eventually_no_pf(cache_line);
+		B2;			/* BARRIER 2 */
+		break;
+	      }
 	    break;
 	  }
-	case LOAD_FROM_INVALID:
+	case SWAP_ON_SHARED: /* 23 */
 	  {
-	    PRINT(" ** Results from Core 0 : load from invalid");
-	    PRINT(" ** Results from Core 1 : cache line flush");
+	    switch (ID)
+	      {
+	      case 0:
+		sum += load_0_eventually(cache_line, reps);
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		break;
+	      case 1:
+		B1;		/* BARRIER 1 */
+		B2;		/* BARRIER 2 */
+		sum += swap(cache_line, reps);
+		break;
+	      case 2:
+		B1;		/* BARRIER 1 */
+		sum += load_0_eventually(cache_line, reps);
+		B2;		/* BARRIER 2 */
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		sum += load_0_eventually_no_pf(cache_line);
+		B2;			/* BARRIER 2 */
+		break;
+	      }
 	    break;
 	  }
-	case LOAD_FROM_SHARED:
+        case CAS_CONCURRENT: /* 24 */
+          {
+            if (ID < test_cores)
+              {
+                sum += cas(cache_line, reps);
+              }
+            else
+              {
+                sum += cas_no_pf(cache_line, reps);
+              }
+            break;
+          }
+	case FAI_ON_INVALID:	/* 25 */
 	  {
-	    if (test_flush)
-	      {
-		PRINT(" ** Results from Core 0 : load from invalid");
-	      }
-	    else
+	    switch (ID)
 	      {
-		PRINT(" ** Results from Core 0 : load from invalid, BUT could have prefetching");
+	      case 0:
+		B1;		/* BARRIER 1 */
+		sum += fai(cache_line, reps);
+		break;
+	      case 1:
+		invalidate(cache_line, 0, reps);
+		B1;		/* BARRIER 1 */
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
-	    PRINT(" ** Results from Core 1 : load from exclusive");
-	    if (test_cores >= 3)
+
+	    if (!test_flush)
 	      {
-		PRINT(" ** Results from Core 2 : load from shared");
+		cache_line += test_stride;
 	      }
-	    else
+	    break;
+	  }
+	case LOAD_FROM_L1:	/* 26 */
+	  {
+	    if (ID == 0)
 	      {
-		PRINT(" ** Need >=3 processes to achieve LOAD_FROM_SHARED");
+		sum += load_0(cache_line, reps);
+		sum += load_0(cache_line, reps);
+		sum += load_0(cache_line, reps);
 	      }
 	    break;
 	  }
-	case LOAD_FROM_OWNED:
+	case LOAD_FROM_MEM_SIZE: /* 27 */
 	  {
-	    if (test_flush)
+	    if (ID < test_cores)
 	      {
-		PRINT(" ** Results from Core 0 : store to invalid");
+		sum += load_next(cl, reps);
 	      }
-	    else
+	  }
+	  break;
+	case LFENCE:		/* 28 */
+	  if (ID < 2)
+	    {
+	      PFDI(0);
+	      _mm_lfence();
+	      PFDO(0, reps);
+	    }
+	  break;
+	case SFENCE:		/* 29 */
+	  if (ID < 2)
+	    {
+	      PFDI(0);
+	      _mm_sfence();
+	      PFDO(0, reps);
+	    }
+	  break;
+	case MFENCE:		/* 30 */
+	  if (ID < 2)
+	    {
+	      PFDI(0);
+	      _mm_mfence();
+	      PFDO(0, reps);
+	    }
+	  break;
+	case PAUSE:		/* 31 */
+	  if (ID < 2)
+	    {
+	      PFDI(0);
+	      _mm_pause();
+	      PFDO(0, reps);
+	    }
+	  break;
+	case NOP:		/* 32 */
+	  if (ID < 2)
+	    {
+	      PFDI(0);
+	      asm volatile ("nop");
+	      PFDO(0, reps);
+	    }
+	  break;
+	case LOCK_UNCONTENDED:
+	  if (ID == 0)
+	    {
+	      lock_uncontended(reps);
+	    }
+	  break;
+	case LOCK_HANDOFF:
+	  {
+	    switch (ID)
 	      {
-		PRINT(" ** Results from Core 0 : store to owned mine (if owned is supported, else shared)");
+	      case 0:
+		B1;		/* BARRIER 1 */
+		lock_handoff_acquire(reps);
+		break;
+	      case 1:
+		lock_acquire(shared_lock, &lock_local);
+		B1;		/* BARRIER 1 */
+		lock_handoff_release(reps);
+		break;
+	      default:
+		B1;		/* BARRIER 1 */
+		break;
 	      }
-	    PRINT(" ** Results from Core 1 : load from modified");
-	    if (test_cores == 3)
+	    break;
+	  }
+	case LITMUS_SB:
+	case LITMUS_MP:
+	case LITMUS_LB:
+	case LITMUS_IRIW:
+	  litmus_run(cache_line, reps);
+	  break;
+	case BROADCAST:
+	  {
+	    volatile uint64_t* w = (volatile uint64_t*) cache_line->word;
+	    uint64_t old = *w;	/* the readers get the line shared before they spin */
+	    B1;			/* BARRIER 1 */
+	    if (ID == 0)
 	      {
-		PRINT(" ** Results from Core 2 : load from owned");
+		broadcast_write(w, reps);
 	      }
 	    else
 	      {
-		PRINT(" ** Need 3 processes to achieve LOAD_FROM_OWNED");
+		broadcast_read(w, old, reps);
 	      }
 	    break;
 	  }
-	case CAS:
-	  {
-	    PRINT(" ** Results from Core 0 : CAS successfull");
-	    PRINT(" ** Results from Core 1 : CAS unsuccessfull");
-	    break;
-	  }
-	case FAI:
-	  {
-	    PRINT(" ** Results from Cores 0 & 1: FAI");
-	    break;
-	  }
-	case TAS:
-	  {
-	    PRINT(" ** Results from Core 0 : TAS successfull");
-	    PRINT(" ** Results from Core 1 : TAS unsuccessfull");
-	    break;
-	  }
-	case SWAP:
-	  {
-	    PRINT(" ** Results from Cores 0 & 1: SWAP");
-	    break;
-	  }
-	case CAS_ON_MODIFIED:
-	  {
-	    PRINT(" ** Results from Core 0 : store on modified");
-	    uint32_t succ = 50 + test_ao_success * 50;
-	    PRINT(" ** Results from Core 1 : CAS on modified (%d%% successfull)", succ);
-	    break;
-	  }
-	case FAI_ON_MODIFIED:
-	  {
-	    PRINT(" ** Results from Core 0 : store on modified");
-	    PRINT(" ** Results from Core 1 : FAI on modified");
-	    break;
-	  }
-	case TAS_ON_MODIFIED:
-	  {
-	    PRINT(" ** Results from Core 0 : store on modified");
-	    uint32_t succ = test_ao_success * 100;
-	    PRINT(" ** Results from Core 1 : TAS on modified (%d%% successfull)", succ);
-	    break;
-	  }
-	case SWAP_ON_MODIFIED:
-	  {
-	    PRINT(" ** Results from Core 0 : store on modified");
-	    PRINT(" ** Results from Core 1 : SWAP on modified");
-	    break;
-	  }
-	case CAS_ON_SHARED:
-	  {
-	    PRINT(" ** Results from Core 0 : load from modified");
-	    PRINT(" ** Results from Core 1 : CAS on shared (100%% successfull)");
-	    PRINT(" ** Results from Core 2 : load from exlusive or shared");
-	    if (test_cores < 3)
-	      {
-		PRINT(" ** Need >=3 processes to achieve CAS_ON_SHARED");
-	      }
-	    break;
-	  }
-	case FAI_ON_SHARED:
+	case PROFILER:		/* 30 */
+	default:
+	  PFDI(0);
+	  asm volatile ("");
+	  PFDO(0, reps);
+	  break;
+	}
+
+      B3;			/* BARRIER 3 */
+    }
+
+  return sum;
+}
+
+/* --concurrent: pairs measured at once must not share an L3 (or, without */
+/* cache information, a package or a cpu) */
+static int32_t
+matrix_domain(uint32_t cpu)
+{
+  const topo_cpu_t* t = topo_cpu(cpu);
+  if (t->l3_set >= 0)
+    {
+      return t->l3_set;
+    }
+  if (t->package >= 0)
+    {
+      return TOPO_MAX_CPUS + t->package;
+    }
+  return cpu;
+}
+
+/* splits the ordered pairs into rounds of at most test_concurrent pairs that */
+/* share no domain; with --concurrent, a share of the cells goes first, one per */
+/* round, to be compared with the concurrent measurements that follow */
+static void
+matrix_plan_init()
+{
+  const uint32_t workers = matrix_workers;
+  const uint32_t cells = workers * (workers - 1);
+  if (test_concurrent > 1)
+    {
+      matrix_num_verify = (cells + MATRIX_VERIFY_SHARE - 1) / MATRIX_VERIFY_SHARE;
+    }
+
+  matrix_cells = (matrix_cell_t*) calloc(workers * workers, sizeof(matrix_cell_t));
+  matrix_verify = (matrix_cell_t*) calloc(matrix_num_verify + 1, sizeof(matrix_cell_t));
+  matrix_plan = (matrix_entry_t*) calloc(cells + matrix_num_verify, sizeof(matrix_entry_t));
+  matrix_round_end = (uint32_t*) calloc(cells + matrix_num_verify, sizeof(uint32_t));
+  uint8_t* placed = (uint8_t*) calloc(cells, sizeof(uint8_t));
+  int32_t* taken = (int32_t*) calloc(2 * test_concurrent, sizeof(int32_t));
+  assert(matrix_cells != NULL && matrix_verify != NULL && matrix_plan != NULL && matrix_round_end != NULL
+	 && placed != NULL && taken != NULL);
+
+  uint32_t n = 0, left = cells, c, k;
+  for (k = 0; k < matrix_num_verify; k++)
+    {
+      c = (uint32_t) (((uint64_t) k * cells) / matrix_num_verify);
+      matrix_plan[n].a = c / (workers - 1);
+      matrix_plan[n].b = c % (workers - 1);
+      matrix_plan[n].b += (matrix_plan[n].b >= matrix_plan[n].a);
+      matrix_plan[n].slot = 0;
+      matrix_plan[n].cell = &matrix_verify[k];
+      n++;
+      matrix_round_end[matrix_rounds++] = n;
+    }
+
+  while (left > 0)
+    {
+      uint32_t slots = 0, num_taken = 0;
+      for (c = 0; c < cells && slots < test_concurrent; c++)
+	{
+	  if (placed[c])
+	    {
+	      continue;
+	    }
+	  uint32_t a = c / (workers - 1);
+	  uint32_t b = c % (workers - 1);
+	  b += (b >= a);
+	  int32_t da = matrix_domain(test_cores_array[a]);
+	  int32_t db = matrix_domain(test_cores_array[b]);
+	  for (k = 0; k < num_taken; k++)
+	    {
+	      if (taken[k] == da || taken[k] == db)
+		{
+		  break;
+		}
+	    }
+	  if (k < num_taken)
+	    {
+	      continue;
+	    }
+
+	  taken[num_taken++] = da;
+	  taken[num_taken++] = db;
+	  matrix_plan[n].a = a;
+	  matrix_plan[n].b = b;
+	  matrix_plan[n].slot = slots++;
+	  matrix_plan[n].cell = &matrix_cells[a * workers + b];
+	  n++;
+	  placed[c] = 1;
+	  left--;
+	}
+      matrix_round_end[matrix_rounds++] = n;
+    }
+
+  free(placed);
+  free(taken);
+}
+
+/* --matrix: every worker runs this instead of the repetitions. For every ordered */
+/* pair (a, b) of workers, a takes rank 0 and b rank 1 of the event while the */
+/* workers outside the round's pairs wait, so the threads, the pinning and the */
+/* calibration are paid once. The pairs of a round use their own barrier set and */
+/* their own part of the buffer */
+static uint64_t
+matrix_run(volatile cache_line_t* cache_line, volatile uint64_t* cl)
+{
+  const uint32_t rank = ID;
+  const uint32_t workers = matrix_workers;
+  const size_t part = test_cache_line_num / test_concurrent;
+  uint64_t sum = 0;
+  uint32_t bar, round, e = 0, done = 0;
+  ticks start = 0;
+
+  BM;
+  if (rank == 0)
+    {
+      for (bar = 0; bar < NUM_BARRIERS; bar++)
+	{
+	  if (bar != MATRIX_BARRIER)
+	    {
+	      barrier_init(bar, 0, color_all, 2);
+	    }
+	}
+      test_cores = 2;
+    }
+  BM;
+
+  for (round = 0; round < matrix_rounds; round++)
+    {
+      const uint32_t end = matrix_round_end[round];
+      const matrix_entry_t* mine = NULL;
+      for (; e < end; e++)
+	{
+	  done += 2;
+	  if (matrix_plan[e].a == rank || matrix_plan[e].b == rank)
+	    {
+	      mine = &matrix_plan[e];
+	    }
+	}
+
+      if (rank == 0 && round == matrix_num_verify)
+	{
+	  start = getticks();
+	}
+
+      if (mine != NULL)
+	{
+	  volatile cache_line_t* base = cache_line + mine->slot * part;
+	  ID = (rank == mine->a) ? 0 : 1;
+	  barrier_base = mine->slot * BARRIER_SET;
+	  if (ID == 0)
+	    {
+	      /* the lines the previous pair touched must not start cached; */
+	      /* rank 1 waits in the first B0 */
+	      uint32_t r;
+	      for (r = 0; r < test_reps && (size_t) r * test_stride + 1 < part; r++)
+		{
+		  flush_line(base + (size_t) r * test_stride);
+		  flush_line(base + (size_t) r * test_stride + 1);
+		}
+	      _mm_mfence();
+	    }
+
+	  ticks t0 = getticks();
+	  sum += rep_loop(base, cl, test_reps);
+	  matrix_cell_t* cell = mine->cell;
+	  rank_stats_collect(&cell->rank[ID], 0);
+	  cell->samples = test_reps;
+	  /* the isolation checks stay at the pilot and take none of the budget */
+	  if (test_target_ci > 0 && round >= matrix_num_verify)
+	    {
+	      sum += adapt_run(base, cl, cell->rank, &cell->samples, &cell->more, matrix_rounds - round);
+	    }
+	  if (ID == 0)
+	    {
+	      cell->elapsed = getticks() - t0;
+	    }
+	  ID = rank;
+	  barrier_base = 0;
+	  FAI_U32(&matrix_done);
+	}
+      else
+	{
+	  /* sleep rather than spin: an idle worker may be the SMT sibling of a pair */
+	  while (matrix_done < done)
+	    {
+	      usleep(MATRIX_IDLE_US);
+	    }
+	}
+      BM;
+
+      if (rank == 0 && round + 1 == matrix_rounds)
+	{
+	  matrix_campaign = getticks() - start;
+	}
+    }
+
+  if (rank == 0)
+    {
+      test_cores = workers;
+      for (bar = 0; bar < NUM_BARRIERS; bar++)
+	{
+	  if (bar != MATRIX_BARRIER)
+	    {
+	      barrier_init(bar, 0, color_all, workers);
+	    }
+	}
+      if (test_concurrent > 1)
+	{
+	  matrix_verify_report();
+	}
+      matrix_report();
+      adapt_report();
+    }
+  BM;
+
+  return sum;
+}
+
+/* Welch's t of the difference of two cell means */
+static double
+matrix_welch_t(const abs_deviation_t* x, const abs_deviation_t* y)
+{
+  double var = (x->std_dev * x->std_dev) / x->num_vals + (y->std_dev * y->std_dev) / y->num_vals;
+  return (var > 0) ? (x->avg - y->avg) / sqrt(var) : 0;
+}
+
+/* --concurrent: the speedup over measuring the pairs one after another, and */
+/* whether the cells measured first in isolation moved; marks their check */
+static void
+matrix_verify_report()
+{
+  const uint32_t workers = matrix_workers;
+  const uint32_t cells = workers * (workers - 1);
+  ticks sequential = 0;
+  uint32_t c, k, r;
+  for (c = 0; c < workers * workers; c++)
+    {
+      sequential += matrix_cells[c].elapsed;
+    }
+
+  PRINT(" ---- Concurrent pairs -------------------------------------------------------------");
+  PRINT(" %u pairs in %u rounds of up to %u | speedup %.2fx (sum of the pairs' cycles / campaign cycles)",
+	cells, matrix_rounds - matrix_num_verify, test_concurrent,
+	matrix_campaign ? (double) sequential / matrix_campaign : 0.0);
+
+  uint32_t shifted = 0;
+  double worst = 0;
+  for (k = 0; k < matrix_num_verify; k++)
+    {
+      const matrix_entry_t* v = &matrix_plan[k];
+      matrix_cell_t* conc = &matrix_cells[v->a * workers + v->b];
+      const matrix_cell_t* iso = v->cell;
+      int moved = 0;
+      for (r = 0; r < 2; r++)
+	{
+	  const abs_deviation_t* c_s = &conc->rank[r].stats[0];
+	  const abs_deviation_t* i_s = &iso->rank[r].stats[0];
+	  double t = matrix_welch_t(c_s, i_s);
+	  if (fabs(t) > MATRIX_T_CRIT)
+	    {
+	      moved = 1;
+	    }
+	  if (i_s->avg > 0)
+	    {
+	      double rel = fabs(c_s->avg - i_s->avg) / i_s->avg;
+	      worst = (rel > worst) ? rel : worst;
+	    }
+	}
+      shifted += moved;
+      conc->check = moved ? MATRIX_CHECK_SHIFTED : MATRIX_CHECK_CONSISTENT;
+      if (moved || test_verbose)
+	{
+	  PRINT(" Pair %3u -> %-3u : concurrent avg %8.1f / %8.1f | isolated avg %8.1f / %8.1f%s",
+		test_cores_array[v->a], test_cores_array[v->b], conc->rank[0].stats[0].avg, conc->rank[1].stats[0].avg,
+		iso->rank[0].stats[0].avg, iso->rank[1].stats[0].avg, moved ? " | SHIFTED" : "");
+	}
+    }
+
+  PRINT(" %u of %u cells measured first in isolation shifted (|Welch t| > %.1f); largest change of an avg %.1f%%",
+	shifted, matrix_num_verify, MATRIX_T_CRIT, 100 * worst);
+  if (shifted)
+    {
+      PRINT(" ** concurrency disturbs this event on these cores: rerun without --concurrent");
+    }
+}
+
+/* half width of the 95% confidence interval of the mean of a cell */
+static double
+matrix_ci95(const abs_deviation_t* stats)
+{
+  return stats->num_vals ? MATRIX_Z95 * stats->std_dev / sqrt((double) stats->num_vals) : 0;
+}
+
+static void
+matrix_report()
+{
+  FILE* out = stdout;
+  if (test_output != NULL)
+    {
+      out = fopen(test_output, "w");
+      if (out == NULL)
+	{
+	  perror(test_output);
+	  exit(1);
+	}
+    }
+
+  const uint32_t workers = matrix_workers;
+  uint32_t a, b, r;
+  if (test_matrix == MATRIX_CSV)
+    {
+      /* the six columns of the one-pair-per-process layout first, the rest appended */
+      fprintf(out, "source_core,target_core,reported_core_a,avg_cycles_a,reported_core_b,avg_cycles_b,"
+	      "relation,samples");
+      for (r = 0; r < 2; r++)
+	{
+	  const char s = r ? 'b' : 'a';
+	  fprintf(out, ",std_dev_%c,ci95_%c,p50_%c,p99_%c,min_%c,max_%c", s, s, s, s, s, s);
+	}
+      /* store 1: the second timed region, e.g. rank 1 of the STORE_ON_OWNED events */
+      for (r = 0; r < 2; r++)
+	{
+	  const char s = r ? 'b' : 'a';
+	  fprintf(out, ",store1_avg_cycles_%c,store1_std_dev_%c,store1_ci95_%c,store1_p50_%c,store1_p99_%c,"
+		  "store1_min_%c,store1_max_%c", s, s, s, s, s, s, s);
+	}
+      fprintf(out, ",isolation_check\n");
+    }
+  else
+    {
+      fprintf(out, "{\n  \"event\": \"%s\",\n  \"repetitions\": %u,\n  \"cores\": [",
+	      moesi_type_des[test_test], test_reps);
+      for (a = 0; a < workers; a++)
+	{
+	  fprintf(out, "%s%u", a ? ", " : "", test_cores_array[a]);
+	}
+      fprintf(out, "],\n  \"cells\": [");
+    }
+
+  uint32_t cells = 0;
+  for (a = 0; a < workers; a++)
+    {
+      for (b = 0; b < workers; b++)
+	{
+	  if (a == b)
+	    {
+	      continue;
+	    }
+	  const matrix_cell_t* cell = &matrix_cells[a * workers + b];
+	  const uint32_t core[2] = { test_cores_array[a], test_cores_array[b] };
+	  const char* rel = topo_relation_des[topo_relation(core[0], core[1])];
+
+	  if (test_matrix == MATRIX_CSV)
+	    {
+	      fprintf(out, "%u,%u,%u,%.1f,%u,%.1f,%s,%u", core[0], core[1], core[0], cell->rank[0].stats[0].avg,
+		      core[1], cell->rank[1].stats[0].avg, rel, cell->samples);
+	      for (r = 0; r < 2; r++)
+		{
+		  rank_stats_csv_spread(out, &cell->rank[r], 0);
+		}
+	      for (r = 0; r < 2; r++)
+		{
+		  rank_stats_csv(out, &cell->rank[r], 1);
+		}
+	      fprintf(out, ",%s\n", matrix_check_des[cell->check]);
+	    }
+	  else
+	    {
+	      fprintf(out, "%s\n    { \"source\": %u, \"target\": %u, \"relation\": \"%s\", \"samples\": %u",
+		      cells ? "," : "", core[0], core[1], rel, cell->samples);
+	      for (r = 0; r < 2; r++)
+		{
+		  const rank_stats_t* res = &cell->rank[r];
+		  uint32_t st;
+		  fprintf(out, ",\n      \"%c\": { \"core\": %u", r ? 'b' : 'a', core[r]);
+		  for (st = 0; st < PFD_NUM_STORES; st++)
+		    {
+		      const abs_deviation_t* s = &res->stats[st];
+		      if (st >= res->stores)
+			{
+			  fprintf(out, ", \"store1\": null");
+			  continue;
+			}
+		      fprintf(out, "%s\"avg\": %.1f, \"std_dev\": %.1f, \"ci95\": %.1f, \"p50\": %.0f, "
+			      "\"p99\": %.0f, \"min\": %.0f, \"max\": %.0f%s", st ? ", \"store1\": { " : ", ",
+			      s->avg, s->std_dev, matrix_ci95(s), res->p50[st], res->p99[st], s->min_val, s->max_val,
+			      st ? " }" : "");
+		    }
+		  fprintf(out, " }");
+		}
+	      if (cell->check != MATRIX_CHECK_NONE)
+		{
+		  fprintf(out, ",\n      \"isolation_check\": \"%s\"", matrix_check_des[cell->check]);
+		}
+	      else
+		{
+		  fprintf(out, ",\n      \"isolation_check\": null");
+		}
+	      fprintf(out, " }");
+	    }
+	  cells++;
+	}
+    }
+
+  if (test_matrix == MATRIX_JSON)
+    {
+      fprintf(out, "\n  ]\n}\n");
+    }
+
+  if (out != stdout)
+    {
+      fclose(out);
+      PRINT(" ** %u pairs written to %s", cells, test_output);
+    }
+  else
+    {
+      fflush(out);
+    }
+}
+
+
+/* no values: the fields of the event alone are set afterwards */
+static void
+report_row_init(report_row_t* row, uint32_t rank, uint32_t store)
+{
+  uint32_t q;
+  memset(row, 0, sizeof(*row));
+  row->rank = rank;
+  row->store = store;
+  row->samples = row->avg = row->min = row->max = NAN;
+  for (q = 0; q < REPORT_NUM_QS; q++)
+    {
+      row->quantiles[q] = NAN;
+    }
+  row->ops = row->successes = row->retries = row->bytes = row->elapsed = row->mops = row->gbps = NAN;
+}
+
+/* the throughput of a free-running core, as its text report prints it */
+static void
+report_row_tp(report_row_t* row, const core_summary_t* res)
+{
+  row->ops = res->ops;
+  row->successes = res->successes;
+  row->retries = res->retries;
+  row->bytes = res->bytes;
+  row->elapsed = res->elapsed;
+  row->mops = (res->elapsed > 0) ? res->ops / res->elapsed / 1e6 : 0;
+  row->gbps = (res->elapsed > 0) ? res->bytes / res->elapsed / 1e9 : 0;
+}
+
+/* a count, or the empty field of NAN */
+static void
+report_count(report_t* r, const char* key, const double value)
+{
+  if (isnan(value))
+    {
+      report_real(r, key, value);
+    }
+  else
+    {
+      report_uint(r, key, (uint64_t) value);
+    }
+}
+
+/* every record has all the fields, so that the csv keeps one header */
+static void
+report_record(const report_row_t* row)
+{
+  if (report_records == NULL)
+    {
+      return;
+    }
+
+  static char host[256];
+  static struct utsname un;
+  static char cores[4096];
+  if (host[0] == '\0')
+    {
+      gethostname(host, sizeof(host) - 1);
+      if (uname(&un) != 0)
+	{
+	  memset(&un, 0, sizeof(un));
+	}
+      size_t len = 0;
+      uint32_t c;
+      for (c = 0; c < test_cores && len < sizeof(cores) - 12; c++)
+	{
+	  len += snprintf(cores + len, sizeof(cores) - len, "%s%u", c ? " " : "", test_cores_array[c]);
+	}
+    }
+
+  report_t* r = report_records;
+  const abs_deviation_t* s = row->stats;
+  const uint32_t c = row->rank;
+  uint32_t q;
+
+  report_begin(r);
+  report_str(r, "host", host);
+  report_str(r, "kernel", un.release);
+  report_str(r, "arch", un.machine);
+  report_str(r, "event", moesi_type_des[test_test]);
+  report_uint(r, "event_index", test_test);
+  report_uint(r, "cores", test_cores);
+  report_str(r, "cores_array", cores);
+  report_uint(r, "repetitions", test_reps);
+  report_uint(r, "duration_ms", test_duration);
+  report_uint(r, "stride", test_stride);
+  report_uint(r, "fence", test_fence);
+  report_uint(r, "flush", test_flush);
+  report_uint(r, "success", test_ao_success);
+  report_uint(r, "mem_size", test_mem_size);
+  report_uint(r, "page_size", test_page_size);
+  report_str(r, "hint", hint_type_des[test_hint]);
+  report_str(r, "flush_insn", flush_type_des[test_flush_insn]);
+  report_str(r, "store_kind", store_kind_des[test_store_kind]);
+  report_uint(r, "width", ao_width(ao_native_width()));
+  report_uint(r, "offset", test_offset);
+
+  report_uint(r, "rank", c);
+  report_uint(r, "core", test_cores_array[c]);
+  report_str(r, "relation", c ? topo_relation_des[topo_relation(test_cores_array[0], test_cores_array[c])] : "");
+  report_uint(r, "store", row->store);
+  report_str(r, "step", row->step);
+
+  report_count(r, "samples", s ? s->num_vals : row->samples);
+  report_real(r, "avg", s ? s->avg : row->avg);
+  report_real(r, "std_dev", s ? s->std_dev : NAN);
+  report_real(r, "abs_dev", s ? s->abs_dev : NAN);
+  report_real(r, "ci95", s ? matrix_ci95(s) : NAN);
+  report_real(r, "min", s ? s->min_val : row->min);
+  report_real(r, "max", s ? s->max_val : row->max);
+  for (q = 0; q < REPORT_NUM_QS; q++)
+    {
+      report_real(r, report_qs_des[q], row->quantiles[q]);
+    }
+
+  report_count(r, "num_10p", s ? s->num_dev_10p : NAN);
+  report_real(r, "avg_10p", s ? s->avg_10p : NAN);
+  report_real(r, "std_dev_10p", s ? s->std_dev_10p : NAN);
+  report_count(r, "num_25p", s ? s->num_dev_25p : NAN);
+  report_real(r, "avg_25p", s ? s->avg_25p : NAN);
+  report_real(r, "std_dev_25p", s ? s->std_dev_25p : NAN);
+  report_count(r, "num_50p", s ? s->num_dev_50p : NAN);
+  report_real(r, "avg_50p", s ? s->avg_50p : NAN);
+  report_real(r, "std_dev_50p", s ? s->std_dev_50p : NAN);
+  report_count(r, "num_75p", s ? s->num_dev_75p : NAN);
+  report_real(r, "avg_75p", s ? s->avg_75p : NAN);
+  report_real(r, "std_dev_75p", s ? s->std_dev_75p : NAN);
+  report_count(r, "num_rst", s ? s->num_dev_rst : NAN);
+  report_real(r, "avg_rst", s ? s->avg_rst : NAN);
+  report_real(r, "std_dev_rst", s ? s->std_dev_rst : NAN);
+  report_uint(r, "correction", core_summaries[c].correction);
+
+  report_count(r, "ops", row->ops);
+  report_count(r, "successes", row->successes);
+  report_count(r, "retries", row->retries);
+  report_count(r, "bytes", row->bytes);
+  report_real(r, "elapsed_s", row->elapsed);
+  report_real(r, "mops_per_s", row->mops);
+  report_real(r, "gb_per_s", row->gbps);
+  report_end(r);
+}
+
+/* the free-running events with --scale and FETCH_OP: a record per active core */
+/* of the step, before pooled_percentiles packs the samples */
+static void
+report_step_cores(uint32_t active, const char* step)
+{
+  uint32_t c;
+  for (c = 0; c < active; c++)
+    {
+      const core_summary_t* res = &core_summaries[c];
+      report_row_t row;
+      abs_deviation_t stats;
+      report_row_init(&row, c, 0);
+      snprintf(row.step, sizeof(row.step), "%s", step);
+      report_row_tp(&row, res);
+      if (pooled_samples != NULL && res->num_samples > 0)
+	{
+	  get_abs_deviation_all(pooled_samples + (size_t) c * test_reps, res->num_samples, &stats);
+	  row.stats = &stats;
+	  get_percentiles(pooled_samples + (size_t) c * test_reps, res->num_samples, report_qs,
+			  row.quantiles, REPORT_NUM_QS);
+	}
+      report_record(&row);
+    }
+}
+
+/* --format csv / json: on core 0 after the summary, a record per core and store */
+/* with stats, with the throughput of the free-running events; their cores */
+/* without stats (RING) get a record of the throughput alone. The events that */
+/* step write their records in their reports */
+static void
+report_results()
+{
+  if (test_reports_steps(test_test))
+    {
+      return;
+    }
+
+  uint32_t c, st;
+  for (c = 0; c < test_cores; c++)
+    {
+      const core_summary_t* summary = &core_summaries[c];
+      const int tp = test_is_free_running(test_test) && summary->elapsed > 0;
+      uint32_t records = 0;
+      report_row_t row;
+      for (st = 0; st < PFD_NUM_STORES; st++)
+	{
+	  if (!summary->store_valid[st])
+	    {
+	      continue;
+	    }
+	  report_row_init(&row, c, st);
+	  row.stats = &summary->record[st];
+	  memcpy(row.quantiles, summary->quantiles[st], sizeof(row.quantiles));
+	  if (tp && st == 0)
+	    {
+	      report_row_tp(&row, summary);
+	    }
+	  report_record(&row);
+	  records++;
+	}
+
+      if (records == 0 && tp)
+	{
+	  report_row_init(&row, c, 0);
+	  report_row_tp(&row, summary);
+	  if (test_test == RING && c >= ring_producers())
+	    {
+	      /* enqueue to dequeue */
+	      row.samples = summary->ops;
+	      row.avg = summary->lat_avg;
+	      row.max = summary->lat_max;
+	      row.quantiles[0] = summary->lat_p50;
+	      row.quantiles[2] = summary->lat_p99;
+	    }
+	  report_record(&row);
+	}
+    }
+}
+
+/* whether this thread timed a second region in store 1, as the report of the */
+/* repetitions collects it */
+static uint32_t
+rank_stores()
+{
+  if (((test_test == STORE_ON_OWNED_MINE || test_test == STORE_ON_OWNED) && ID == 1)
+      || (test_test == LOCK_UNCONTENDED && ID == 0) || store_line_used)
+    {
+      return 2;
+    }
+  return 1;
+}
+
+/* the stats of the repetitions this thread just ran, batch of a cell (0 for the */
+/* pilot). With --target-ci the percentiles are those of all the cell's batches */
+/* so far: the raw samples are pooled before get_abs_deviation drops the tail */
+static void
+rank_stats_collect(rank_stats_t* out, uint32_t batch)
+{
+  const double qs[] = { 0.50, 0.99 };
+  double pct[2];
+  uint32_t st;
+  out->stores = rank_stores();
+  for (st = 0; st < out->stores; st++)
+    {
+      if (test_target_ci > 0)
+	{
+	  if (adapt_pool[st] == NULL)
+	    {
+	      adapt_pool[st] = (ticks*) malloc((size_t) ADAPT_MAX_BATCHES * test_reps * sizeof(ticks));
+	      assert(adapt_pool[st] != NULL);
+	    }
+	  memcpy(adapt_pool[st] + (size_t) batch * test_reps, (void*) pfd_store[st], test_reps * sizeof(ticks));
+	  get_percentiles(adapt_pool[st], (size_t) (batch + 1) * test_reps, qs, pct, 2);
+	}
+      else
+	{
+	  get_percentiles(pfd_store[st], test_reps, qs, pct, 2);
+	}
+      get_abs_deviation(pfd_store[st], test_reps, &out->stats[st]);
+      out->p50[st] = pct[0];
+      out->p99[st] = pct[1];
+    }
+}
+
+/* the csv fields of store st of a rank: avg, std_dev, ci95, p50, p99, min, max */
+static void
+rank_stats_csv(FILE* out, const rank_stats_t* res, uint32_t st)
+{
+  if (res == NULL || st >= res->stores)
+    {
+      fprintf(out, ",");
+    }
+  else
+    {
+      fprintf(out, ",%.1f", res->stats[st].avg);
+    }
+  rank_stats_csv_spread(out, res, st);
+}
+
+/* rank_stats_csv without the avg: ",std,ci95,p50,p99,min,max" */
+static void
+rank_stats_csv_spread(FILE* out, const rank_stats_t* res, uint32_t st)
+{
+  if (res == NULL || st >= res->stores)
+    {
+      fprintf(out, ",,,,,,");
+      return;
+    }
+  const abs_deviation_t* s = &res->stats[st];
+  fprintf(out, ",%.1f,%.1f,%.0f,%.0f,%.0f,%.0f", s->std_dev, matrix_ci95(s), res->p50[st],
+	  res->p99[st], s->min_val, s->max_val);
+}
+
+/* --target-ci: whether a rank's mean is still known less precisely than asked */
+static int
+adapt_loose_stats(const abs_deviation_t* stats)
+{
+  return stats->num_vals > 0 && stats->avg > 0 && matrix_ci95(stats) > stats->avg * test_target_ci / 100;
+}
+
+/* --target-ci: the ranks of a cell ran its pilot (--repetitions) and hold their */
+/* stats in ranks[ID]. While a rank's interval is wider than the target, rank 0 */
+/* calls for another batch of --repetitions, until the cell has ADAPT_MAX_BATCHES */
+/* or spent its share of --budget: what is left of it, split over the cells left */
+/* to measure (the isolation checks run their pilot only). The percentiles are */
+/* those of the pooled samples of all the batches, see rank_stats_collect */
+static uint64_t
+adapt_run(volatile cache_line_t* cache_line, volatile uint64_t* cl, rank_stats_t* ranks,
+	  uint32_t* samples, volatile uint32_t* more, uint32_t cells_left)
+{
+  uint64_t sum = 0;
+  uint32_t batch, r, st;
+  double until = 0;
+  if (ID == 0 && test_budget > 0)
+    {
+      double now = wtime();
+      until = now + (adapt_deadline - now) / cells_left;
+    }
+
+  for (batch = 1;; batch++)
+    {
+      B0;			/* the ranks' stats are in */
+      if (ID == 0)
+	{
+	  uint32_t loose = 0;
+	  for (r = 0; r < test_cores; r++)
+	    {
+	      for (st = 0; st < ranks[r].stores; st++)
+		{
+		  loose += adapt_loose_stats(&ranks[r].stats[st]);
+		}
+	    }
+	  *more = loose && batch < ADAPT_MAX_BATCHES && (test_budget == 0 || wtime() < until);
+	  if (!*more)
+	    {
+	      *samples = batch * test_reps;
+	      if (batch > 1)
+		{
+		  FAI_U32(&adapt_extended);
+		}
+	      if (loose)
+		{
+		  FAI_U32(&adapt_loose);
+		}
+	    }
+	}
+      B0;
+      if (!*more)
+	{
+	  break;
+	}
+
+      sum += rep_loop(cache_line, cl, test_reps);
+      rank_stats_t b;
+      rank_stats_collect(&b, batch);
+      rank_stats_t* mine = &ranks[ID];
+      for (st = 0; st < mine->stores; st++)
+	{
+	  mine->p50[st] = b.p50[st];
+	  mine->p99[st] = b.p99[st];
+	  merge_abs_deviation(&mine->stats[st], &b.stats[st]);
+	}
+    }
+
+  return sum;
+}
+
+static void
+adapt_report()
+{
+  if (test_target_ci > 0)
+    {
+      PRINT(" ** --target-ci %g%%: %u cells took more than the pilot's %u repetitions, %u are still wider%s",
+	    test_target_ci, adapt_extended, test_reps, adapt_loose,
+	    adapt_loose ? " (out of batches or --budget)" : "");
+    }
+}
+
+/* --sweep: expands the spec over the options given, pins one worker per use of */
+/* a cpu in one configuration and sizes the buffer for the largest mem */
+static void
+sweep_init()
+{
+  if (test_matrix != MATRIX_OFF || test_sweep_mem || test_concurrent > 1)
+    {
+      fprintf(stderr, "error: --sweep does not combine with --matrix, --sweep-mem or --concurrent\n");
+      exit(1);
+    }
+  if (test_cores > SWEEP_MAX_CORES)
+    {
+      fprintf(stderr, "error: --sweep takes at most %d cores\n", SWEEP_MAX_CORES);
+      exit(1);
+    }
+
+  sweep_config_t defaults;
+  defaults.test = test_test;
+  defaults.fence = test_fence;
+  defaults.stride = test_stride;
+  defaults.mem_size = test_mem_size;
+  defaults.hint = test_hint;
+  defaults.num_cores = test_cores;
+  memcpy(defaults.cores, test_cores_array, test_cores * sizeof(uint32_t));
+  sweep = sweep_parse(test_sweep, &defaults, parse_test_option, parse_hint_option);
+
+  uint32_t c, r;
+  for (c = 0; c < sweep->num_configs; c++)
+    {
+      const sweep_config_t* config = &sweep->configs[c];
+      const moesi_type_t test = config->test;
+      if (test_is_free_running(test) || test_is_lock(test) || litmus_threads(test) > 0 || test == BROADCAST)
+	{
+	  fprintf(stderr, "error: --sweep runs the repetitions of the latency events, not %s\n",
+		  moesi_type_des[test]);
+	  exit(1);
+	}
+      if ((config->hint == HINT_PREFETCHW && !cpu_has_prefetchw())
+	  || (config->hint == HINT_CLDEMOTE && !cpu_has_cldemote()))
+	{
+	  fprintf(stderr, "error: --sweep: this cpu does not support %s\n", hint_type_des[config->hint]);
+	  exit(1);
+	}
+      for (r = 0; r < config->num_cores; r++)
+	{
+	  if (config->cores[r] >= TOPO_MAX_CPUS || !topo_cpu(config->cores[r])->allowed)
+	    {
+	      fprintf(stderr, "error: --sweep: cpu %u is offline or outside the affinity mask of ccbench\n",
+		      config->cores[r]);
+	      exit(1);
+	    }
+	}
+    }
+
+  uint32_t* workers = (uint32_t*) calloc(SWEEP_MAX_WORKERS, sizeof(uint32_t));
+  assert(workers != NULL);
+  test_cores = sweep_workers(sweep, workers, SWEEP_MAX_WORKERS);
+  ensure_cores_array_capacity(test_cores);
+  memcpy(allocated_cores_array, workers, test_cores * sizeof(uint32_t));
+  test_cores_array = allocated_cores_array;
+  free(workers);
+
+  /* the events of the first configuration set the run up */
+  test_test = sweep->configs[0].test;
+  if (sweep->max_mem_size > test_mem_size)
+    {
+      test_mem_size = sweep->max_mem_size;
+    }
+
+  sweep_rank_of = (int32_t*) calloc(test_cores, sizeof(int32_t));
+  sweep_results = (rank_stats_t*) calloc(sweep->max_cores, sizeof(rank_stats_t));
+  assert(sweep_rank_of != NULL && sweep_results != NULL);
+
+  /* the configurations after the defaults filled the keys in, and every option */
+  /* that changes what a row measures: a resume must match all of them */
+  char signature[SWEEP_SPEC_LEN + 512];
+  int n = snprintf(signature, sizeof(signature), "# sweep: %s / configurations: %u, digest %016llx / "
+		   "repetitions: %u / flush: %u / success: %u / hint: %s %u / flush insn: %s / "
+		   "store kind: %s / chain: %s / page: %zu / width: %u / offset: %u / pingpong: %u %u / "
+		   "placement: %s / smt pair: %u", sweep->spec, sweep->num_configs, (LLU) sweep_digest(sweep),
+		   test_reps, test_flush, test_ao_success, hint_type_des[test_hint], test_hint_distance,
+		   flush_type_des[test_flush_insn], store_kind_des[test_store_kind], chain_mode_des[test_chain_mode],
+		   test_page_size, test_width, test_offset, test_separate, test_pause, placement_des[test_placement],
+		   test_smt_pair);
+  if (test_target_ci > 0)
+    {
+      snprintf(signature + n, sizeof(signature) - n, " / target ci: %g%% / budget: %g s", test_target_ci,
+	       test_budget);
+    }
+  size_t len = 0, cap = 128 + 192 * sweep->max_cores;
+  char* header = (char*) malloc(cap);
+  assert(header != NULL);
+  len += snprintf(header, cap, "id,test,fence,stride,cores,mem_size,status,relation,samples");
+  for (r = 0; r < sweep->max_cores; r++)
+    {
+      len += snprintf(header + len, cap - len, ",core_%u,avg_%u,std_dev_%u,ci95_%u,p50_%u,p99_%u,min_%u,max_%u",
+		      r, r, r, r, r, r, r, r);
+    }
+  for (r = 0; r < sweep->max_cores; r++)
+    {
+      len += snprintf(header + len, cap - len, ",store1_avg_%u,store1_std_dev_%u,store1_ci95_%u,store1_p50_%u,"
+		      "store1_p99_%u,store1_min_%u,store1_max_%u", r, r, r, r, r, r, r);
+    }
+  len += snprintf(header + len, cap - len, ",hint");
+
+  if (test_output != NULL)
+    {
+      sweep_out = sweep_open(test_output, signature, header, &sweep_resumed);
+      if (sweep_resumed >= sweep->num_configs)
+	{
+	  /* a rerun of a finished campaign is done, not a failure */
+	  fprintf(stderr, "note: %s already holds the %u rows of this sweep; nothing to run\n", test_output,
+		  sweep->num_configs);
+	  fclose(sweep_out);
+	  exit(0);
+	}
+    }
+  else
+    {
+      sweep_out = stdout;
+      fprintf(sweep_out, "%s\n%s\n", signature, header);
+    }
+  free(header);
+}
+
+/* --sweep, on worker 0 while the others wait: the options, the barriers and the */
+/* lines of config; sets sweep_invalid if they do not fit together */
+static void
+sweep_setup(volatile cache_line_t* cache_line, const sweep_config_t* config)
+{
+  test_test = config->test;
+  set_fence(config->fence);
+  test_stride = config->stride;
+  test_mem_size = config->mem_size;
+  test_hint = config->hint;
+  test_cache_line_num = test_mem_size / sizeof(cache_line_t);
+  test_chase_loads = test_cache_line_num;
+  test_cores = config->num_cores;
+
+  sweep_invalid = NULL;
+  if (test_cache_line_num == 0)
+    {
+      sweep_invalid = "mem below one line";
+    }
+  else if (test_test != LOAD_FROM_MEM_SIZE && test_stride >= test_cache_line_num)
+    {
+      sweep_invalid = "stride beyond mem";
+    }
+  else if (!test_flush && test_is_strided(test_test) && (size_t) test_reps * test_stride > test_cache_line_num)
+    {
+      sweep_invalid = "repetitions x stride beyond mem";
+    }
+  else if (test_store_kind != STORE_WORD && !test_has_store_kind(test_test))
+    {
+      sweep_invalid = "store kind of a non-store event";
+    }
+  else if (test_needs_third_core(test_test) && test_cores < 3)
+    {
+      sweep_invalid = "needs 3 cores";
+    }
+  if (sweep_invalid != NULL)
+    {
+      return;
+    }
+
+  sweep_ranks(config, test_cores_array, matrix_workers, sweep_rank_of);
+  uint32_t bar;
+  for (bar = 0; bar < BARRIER_SET; bar++)
+    {
+      if (bar != MATRIX_BARRIER)
+	{
+	  barrier_init(bar, 0, color_all, test_cores);
+	}
+    }
+
+  /* the lines start invalid in every cache, as with a fresh buffer */
+  size_t cl;
+  for (cl = 0; cl <= test_cache_line_num; cl++)
+    {
+      ao_set(cache_line + cl, 0);
+      _mm_clflush((void*) (cache_line + cl));
+    }
+  chain_head = NULL;
+  if (test_test == LOAD_FROM_MEM_SIZE)
+    {
+      test_chase_loads = create_chain_cl(cache_line, test_mem_size, test_chain_mode, test_page_size, &chain_head);
+    }
+  memset(sweep_results, 0, sweep->max_cores * sizeof(rank_stats_t));
+  _mm_mfence();
+}
+
+static void
+sweep_row(uint32_t c)
+{
+  const sweep_config_t* config = &sweep->configs[c];
+  char cores[SWEEP_MAX_CORES * 6] = "";
+  size_t len = 0;
+  uint32_t r;
+  for (r = 0; r < config->num_cores; r++)
+    {
+      len += snprintf(cores + len, sizeof(cores) - len, "%s%u", r ? " " : "", config->cores[r]);
+    }
+
+  fprintf(sweep_out, "%u,%s,%u,%u,%s,%zu,%s%s,%s,%u", c, moesi_type_des[config->test], config->fence,
+	  config->stride, cores, config->mem_size, sweep_invalid ? "invalid: " : "ok", sweep_invalid ? sweep_invalid : "",
+	  (config->num_cores > 1) ? topo_relation_des[topo_relation(config->cores[0], config->cores[1])] : "",
+	  sweep_invalid ? 0 : sweep_samples);
+  uint32_t st;
+  for (st = 0; st < PFD_NUM_STORES; st++)
+    {
+      for (r = 0; r < sweep->max_cores; r++)
+	{
+	  const int used = (sweep_invalid == NULL && r < config->num_cores);
+	  if (st == 0)
+	    {
+	      if (used)
+		{
+		  fprintf(sweep_out, ",%u", config->cores[r]);
+		}
+	      else
+		{
+		  fprintf(sweep_out, ",");
+		}
+	    }
+	  rank_stats_csv(sweep_out, used ? &sweep_results[r] : NULL, st);
+	}
+    }
+  fprintf(sweep_out, ",%s\n", hint_type_des[config->hint]);
+  fflush(sweep_out);
+
+  sweep_hint_block(c);
+  if (sweep_invalid == NULL)
+    {
+      sweep_block_config[config->hint] = c;
+      for (r = 0; r < config->num_cores; r++)
+	{
+	  sweep_block_avg[config->hint][r] = sweep_results[r].stats[0].avg;
+	}
+    }
+}
+
+/* whether the configurations a and b differ in their hint at most */
+static int
+sweep_same_but_hint(const sweep_config_t* a, const sweep_config_t* b)
+{
+  return a->test == b->test && a->fence == b->fence && a->stride == b->stride && a->mem_size == b->mem_size
+    && a->num_cores == b->num_cores && memcmp(a->cores, b->cores, a->num_cores * sizeof(uint32_t)) == 0;
+}
+
+/* hint is the innermost key: before the row of c, or with c == num_configs */
+/* after the last one, closes the block of the configurations before c if c */
+/* does not belong to it, keeping what every hint saved over none */
+static void
+sweep_hint_block(uint32_t c)
+{
+  uint32_t h, r;
+  if (c > sweep_resumed && c < sweep->num_configs && sweep_same_but_hint(&sweep->configs[c - 1], &sweep->configs[c]))
+    {
+      return;
+    }
+
+  const int32_t base = sweep_block_config[HINT_NONE];
+  for (h = 0; h < HINT_NUM_TYPES && base >= 0 && c > sweep_resumed; h++)
+    {
+      if (h == HINT_NONE || sweep_block_config[h] < 0)
+	{
+	  continue;
+	}
+      sweep_savings = (sweep_hint_saving_t*) realloc(sweep_savings, (sweep_num_savings + 1) * sizeof(sweep_hint_saving_t));
+      assert(sweep_savings != NULL);
+      sweep_hint_saving_t* saving = &sweep_savings[sweep_num_savings++];
+      saving->config = sweep_block_config[h];
+      for (r = 0; r < sweep->configs[base].num_cores; r++)
+	{
+	  saving->saved[r] = sweep_block_avg[HINT_NONE][r] - sweep_block_avg[h][r];
+	}
+    }
+
+  for (h = 0; h < HINT_NUM_TYPES; h++)
+    {
+      sweep_block_config[h] = -1;
+    }
+}
+
+/* --sweep hint=: per state (event) and configuration, the cycles a hint hid */
+static void
+sweep_hint_report()
+{
+  sweep_hint_block(sweep->num_configs);
+  if (sweep_num_savings == 0)
+    {
+      return;
+    }
+
+  PRINT(" ** Hint savings: cycles of the timed access without the hint minus with it, by rank");
+  uint32_t i, r;
+  for (i = 0; i < sweep_num_savings; i++)
+    {
+      const sweep_hint_saving_t* saving = &sweep_savings[i];
+      const sweep_config_t* config = &sweep->configs[saving->config];
+      char line[SWEEP_MAX_CORES * 12] = "";
+      size_t len = 0;
+      for (r = 0; r < config->num_cores && len < sizeof(line); r++)
+	{
+	  len += snprintf(line + len, sizeof(line) - len, " %+8.1f", saving->saved[r]);
+	}
+      PRINT(" %-26s fence %u stride %5u mem %10zu | %-10s :%s", moesi_type_des[config->test], config->fence,
+	    config->stride, config->mem_size, hint_type_des[config->hint], line);
+    }
+  free(sweep_savings);
+  sweep_savings = NULL;
+  sweep_num_savings = 0;
+}
+
+/* --sweep: every worker runs this instead of the repetitions. For every */
+/* configuration, worker 0 sets it up, the workers it uses take its ranks and */
+/* run the repetitions, the others wait; then worker 0 appends its row, so an */
+/* interrupted sweep resumes after the last complete row */
+static uint64_t
+sweep_run(volatile cache_line_t* cache_line)
+{
+  const uint32_t rank = ID;
+  const uint32_t workers = matrix_workers;
+  uint64_t sum = 0;
+  uint32_t c, bar, done = 0;
+
+  BM;				/* worker 0 re-initializes the barriers others may still leave */
+  for (c = sweep_resumed; c < sweep->num_configs; c++)
+    {
+      if (rank == 0)
+	{
+	  sweep_setup(cache_line, &sweep->configs[c]);
+	}
+      BM;
+
+      if (sweep_invalid == NULL)
+	{
+	  done += test_cores;
+	  const int32_t mine = sweep_rank_of[rank];
+	  if (mine >= 0)
+	    {
+	      volatile uint64_t* cl = (chain_head != NULL) ? chain_head : (volatile uint64_t*) cache_line;
+	      ID = mine;
+	      sum += rep_loop(cache_line, cl, test_reps);
+	      rank_stats_collect(&sweep_results[mine], 0);
+	      sweep_samples = test_reps;
+	      if (test_target_ci > 0)
+		{
+		  sum += adapt_run(cache_line, cl, sweep_results, &sweep_samples, &sweep_more,
+				   sweep->num_configs - c);
+		}
+	      ID = rank;
+	      FAI_U32(&matrix_done);
+	    }
+	  else
+	    {
+	      while (matrix_done < done)
+		{
+		  usleep(MATRIX_IDLE_US);
+		}
+	    }
+	}
+      BM;
+
+      if (rank == 0)
+	{
+	  sweep_row(c);
+	}
+    }
+
+  if (rank == 0)
+    {
+      test_cores = workers;
+      for (bar = 0; bar < BARRIER_SET; bar++)
+	{
+	  if (bar != MATRIX_BARRIER)
+	    {
+	      barrier_init(bar, 0, color_all, workers);
+	    }
+	}
+      if (sweep_out != stdout)
+	{
+	  fclose(sweep_out);
+	  PRINT(" ** %u configurations written to %s (%u there already)", sweep->num_configs - sweep_resumed,
+		test_output, sweep_resumed);
+	}
+      sweep_hint_report();
+      adapt_report();
+    }
+  BM;
+
+  return sum;
+}
+
+static int
+test_is_free_running(moesi_type_t test)
+{
+  switch (test)
+    {
+    case CAS_THROUGHPUT:
+    case FAI_THROUGHPUT:
+    case SWAP_THROUGHPUT:
+    case TAS_THROUGHPUT:
+    case LOCK_THROUGHPUT:
+    case PINGPONG:
+    case FALSE_SHARING:
+    case BANDWIDTH:
+    case LOCKFREE:
+      return 1;
+    case MLP:
+    case TLB_SWEEP:
+    case RING:
+    case ATOMIC_MATRIX:
+    case FETCH_OP:
+    case SMT_INTERFERENCE:
+      return 1;
+    case LOAD_FROM_MEM_SIZE:
+      return test_sweep_mem;
+    default:
+      return 0;
+    }
+}
+
+/* the free-running events that report every step themselves: core_summaries */
+/* only holds what their last step left */
+static int
+test_reports_steps(moesi_type_t test)
+{
+  switch (test)
+    {
+    case MLP:
+    case TLB_SWEEP:
+    case ATOMIC_MATRIX:
+    case FETCH_OP:
+    case SMT_INTERFERENCE:
+      return 1;
+    case LOAD_FROM_MEM_SIZE:
+      return test_sweep_mem;
+    default:
+      return 0;
+    }
+}
+
+/* the events that move to the next line (--stride) every repetition without --flush */
+static int
+test_is_strided(moesi_type_t test)
+{
+  switch (test)
+    {
+    case STORE_ON_EXCLUSIVE:
+    case STORE_ON_INVALID:
+    case LOAD_FROM_EXCLUSIVE:
+    case LOAD_FROM_SHARED:
+    case LOAD_FROM_INVALID:
+    case FAI_ON_INVALID:
+      return 1;
+    default:
+      return 0;
+    }
+}
+
+/* the events whose state needs a third role: the core that shares the line */
+static int
+test_needs_third_core(moesi_type_t test)
+{
+  switch (test)
+    {
+    case STORE_ON_SHARED:
+    case LOAD_FROM_SHARED:
+    case LOAD_FROM_OWNED:
+    case CAS_ON_SHARED:
+    case FAI_ON_SHARED:
+    case TAS_ON_SHARED:
+    case SWAP_ON_SHARED:
+      return 1;
+    default:
+      return 0;
+    }
+}
+
+/* the events whose timed store --store-kind selects */
+static int
+test_has_store_kind(moesi_type_t test)
+{
+  switch (test)
+    {
+    case STORE_ON_MODIFIED:
+    case STORE_ON_MODIFIED_NO_SYNC:
+    case STORE_ON_EXCLUSIVE:
+    case STORE_ON_SHARED:
+    case STORE_ON_INVALID:
+      return 1;
+    default:
+      return 0;
+    }
+}
+
+static int
+test_is_lock(moesi_type_t test)
+{
+  return (test == LOCK_UNCONTENDED || test == LOCK_HANDOFF || test == LOCK_THROUGHPUT);
+}
+
+static uint64_t
+run_free_running(volatile cache_line_t* cache_line)
+{
+  switch (test_test)
+    {
+    case CAS_THROUGHPUT:
+    case FAI_THROUGHPUT:
+    case SWAP_THROUGHPUT:
+    case TAS_THROUGHPUT:
+    case LOCK_THROUGHPUT:
+    case FALSE_SHARING:
+    case BANDWIDTH:
+    case LOCKFREE:
+      return throughput_run(cache_line);
+    case PINGPONG:
+      return pingpong_run(cache_line);
+    case LOAD_FROM_MEM_SIZE:
+      return sweep_mem_run(cache_line);
+    case MLP:
+      return mlp_run(cache_line);
+    case TLB_SWEEP:
+      return tlb_sweep_run(cache_line);
+    case RING:
+      return ring_run(cache_line);
+    case ATOMIC_MATRIX:
+      return atomic_matrix_run(cache_line);
+    case FETCH_OP:
+      return fop_run(cache_line);
+    case SMT_INTERFERENCE:
+      return smt_run(cache_line);
+    default:
+      return 0;
+    }
+}
+
+static inline double
+wtime()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* single operations of the *_THROUGHPUT events; return 1 on success */
+static inline uint32_t
+tp_cas(volatile uint32_t* w)
+{
+  uint32_t o = *w;
+  return (CAS_U32(w, o, o + 1) == o);
+}
+
+static inline uint32_t
+tp_fai(volatile uint32_t* w)
+{
+  FAI_U32(w);
+  return 1;
+}
+
+static inline uint32_t
+tp_swap(volatile uint32_t* w)
+{
+  SWAP_U32(w, ID);
+  return 1;
+}
+
+static inline uint32_t
+tp_tas(volatile uint32_t* w)
+{
+#if defined(TILERA)
+  volatile uint32_t* b = (volatile uint32_t*) w;
+#else
+  volatile uint8_t* b = (volatile uint8_t*) w;
+#endif
+  if (TAS_U8(b) == 0)
+    {
+      *b = 0;			/* got it: release, so that someone else can succeed */
+      return 1;
+    }
+  return 0;
+}
+
+static inline uint32_t
+tp_store(volatile uint32_t* w)
+{
+  *w = *w + 1;
+  return 1;
+}
+
+/* the word core `rank` works on in the fixed-duration events */
+static volatile uint32_t*
+throughput_word(volatile cache_line_t* cache_line, uint32_t rank)
+{
+  if (test_test != FALSE_SHARING)
+    {
+      return (cache_line + (rank % test_lines) * TP_LINE_SPACING)->word;
+    }
+
+  const uint32_t words = sizeof(cache_line_t) / sizeof(uint32_t);
+  switch (test_fs_layout)
+    {
+    case FS_SAME_LINE:		/* > 16 cores continue on the next line pair */
+      return &(cache_line + (rank / words) * TP_LINE_SPACING)->word[rank % words];
+    case FS_TWO_LINES:
+      return &(cache_line + (rank / (2 * words)) * TP_LINE_SPACING + (rank % 2))->word[(rank / 2) % words];
+    case FS_PADDED_LINE:
+      return &(cache_line + rank)->word[0];
+    case FS_PADDED_PAIR:
+    default:
+      return &(cache_line + rank * TP_LINE_SPACING)->word[0];
+    }
+}
+
+static inline void
+throughput_loop(volatile uint32_t* w, uint32_t (*op)(volatile uint32_t*), core_summary_t* res)
+{
+  uint64_t ops = 0, succ = 0;
+  uint32_t samples = 0;
+  double start = wtime();
+  double stop = start + test_duration / 1000.0;
+  double now;
+
+  do
+    {
+      uint32_t i, ok = 0;
+      for (i = 0; i < TP_BATCH; i++)
+	{
+	  succ += op(w);
+	}
+
+      uint32_t entry = samples % test_reps;
+      PFDI(0);
+      ok = op(w);
+      PFDO(0, entry);
+      succ += ok;
+      samples++;
+      ops += TP_BATCH + 1;
+      now = wtime();
+    }
+  while (now < stop);
+
+  res->ops = ops;
+  res->successes = succ;
+  res->elapsed = now - start;
+  res->num_samples = (samples < test_reps) ? samples : test_reps;
+}
+
+/* every core acquires the lock, increments the counter in data, spends */
+/* test_cs_length cycles in the critical section, and releases */
+static inline void
+lock_throughput_loop(volatile cache_line_t* data, core_summary_t* res)
+{
+  uint64_t ops = 0;
+  uint32_t samples = 0;
+  double start = wtime();
+  double stop = start + test_duration / 1000.0;
+  double now;
+
+  do
+    {
+      uint32_t i;
+      for (i = 0; i < TP_BATCH; i++)
+	{
+	  lock_acquire(shared_lock, &lock_local);
+	  data->word[0]++;
+	  wait_cycles(test_cs_length);
+	  lock_release(shared_lock, &lock_local);
+	}
+
+      uint32_t entry = samples % test_reps;
+      PFDI(0);
+      lock_acquire(shared_lock, &lock_local);
+      PFDO(0, entry);
+      data->word[0]++;
+      wait_cycles(test_cs_length);
+      lock_release(shared_lock, &lock_local);
+      samples++;
+      ops += TP_BATCH + 1;
+      now = wtime();
+    }
+  while (now < stop);
+
+  res->ops = ops;
+  res->successes = ops;
+  res->elapsed = now - start;
+  res->num_samples = (samples < test_reps) ? samples : test_reps;
+}
+
+/* every core streams over its own chunk of the buffer; store 0 keeps the */
+/* cycles per 64-byte line of every pass, which stay below the limit of */
+/* get_abs_deviation even from DRAM, and cycles the ticks of all the passes */
+static inline void
+bandwidth_loop(volatile cache_line_t* cache_line, core_summary_t* res)
+{
+  const size_t chunk = (test_mem_size / test_cores) & ~((size_t) BW_CHUNK_ALIGN - 1);
+  void* buf = (void*) ((uint8_t*) cache_line + ID * chunk);
+  const char* isa;
+  bw_fn_t kernel = bw_select(test_bw_kernel, &isa);
+  const size_t lines = chunk / sizeof(cache_line_t);
+
+  uint64_t passes = 0, check = 0, cycles = 0;
+  uint32_t samples = 0;
+  double start = wtime();
+  double stop = start + test_duration / 1000.0;
+  double now;
+
+  do
+    {
+      uint32_t entry = samples % test_reps;
+      ticks t = getticks();
+      check += kernel(buf, chunk);
+      t = getticks() - t - pfd_correction;
+      pfd_store[0][entry] = t / lines;
+      cycles += t;
+      samples++;
+      passes++;
+      now = wtime();
+    }
+  while (now < stop);
+
+  res->ops = passes;
+  res->successes = check;
+  res->bytes = passes * bw_bytes_moved(test_bw_kernel, chunk);
+  res->cycles = cycles;
+  res->elapsed = now - start;
+  res->num_samples = (samples < test_reps) ? samples : test_reps;
+}
+
+/* every core hammers its line for test_duration ms without any barriers in between; */
+/* store 0 keeps (the last test_reps) sampled latencies. With --scale, the run is */
+/* repeated with 1, 2, .., test_cores active cores */
+static uint64_t
+throughput_run(volatile cache_line_t* cache_line)
+{
+  volatile uint32_t* w = throughput_word(cache_line, ID);
+  core_summary_t* res = &core_summaries[ID];
+
+  uint32_t active = test_scale ? 1 : test_cores;
+  for (; active <= test_cores; active++)
+    {
+      B1;			/* start together */
+      res->ops = res->successes = res->bytes = res->cycles = res->updates = 0;
+      res->elapsed = 0;
+      res->num_samples = 0;
+      if (ID < active)
+	{
+	  switch (test_test)
+	    {
+	    case CAS_THROUGHPUT:
+	      throughput_loop(w, tp_cas, res);
+	      break;
+	    case FAI_THROUGHPUT:
+	      throughput_loop(w, tp_fai, res);
+	      break;
+	    case SWAP_THROUGHPUT:
+	      throughput_loop(w, tp_swap, res);
+	      break;
+	    case TAS_THROUGHPUT:
+	      throughput_loop(w, tp_tas, res);
+	      break;
+	    case LOCK_THROUGHPUT:
+	      lock_throughput_loop(cache_line, res);
+	      break;
+	    case FALSE_SHARING:
+	      throughput_loop(w, tp_store, res);
+	      break;
+	    case BANDWIDTH:
+	      bandwidth_loop(cache_line, res);
+	      break;
+	    case LOCKFREE:
+	      lf_loop(res);
+	      break;
+	    default:
+	      break;
+	    }
+	}
+      B2;
+
+      if (ID == 0 && test_scale)
+	{
+	  char step[32];
+	  snprintf(step, sizeof(step), "%u threads", active);
+	  report_step_cores(active, step);
+	  if (test_test == LOCKFREE)
+	    {
+	      lf_report(active);
+	    }
+	  else
+	    {
+	      throughput_scale_report(active);
+	    }
+	}
+    }
+
+  return res->successes;
+}
+
+static double
+jain_index(const double* x, uint32_t n)
+{
+  double sum = 0, sum_sq = 0;
+  uint32_t i;
+  for (i = 0; i < n; i++)
+    {
+      sum += x[i];
+      sum_sq += x[i] * x[i];
+    }
+  if (sum_sq == 0)
+    {
+      return 0;
+    }
+  return (sum * sum) / (n * sum_sq);
+}
+
+/* per-core ops and successful ops per second of the first n cores */
+static void
+throughput_rates(uint32_t n, double* ops_rate, double* succ_rate)
+{
+  uint32_t c;
+  for (c = 0; c < n; c++)
+    {
+      const core_summary_t* s = &core_summaries[c];
+      ops_rate[c] = succ_rate[c] = 0;
+      if (s->elapsed > 0)
+	{
+	  ops_rate[c] = s->ops / s->elapsed;
+	  succ_rate[c] = s->successes / s->elapsed;
+	}
+    }
+}
+
+static void
+throughput_scale_report(uint32_t active)
+{
+  double* succ_rate = (double*) calloc(active, sizeof(double));
+  double* ops_rate = (double*) calloc(active, sizeof(double));
+  assert(succ_rate != NULL && ops_rate != NULL);
+  throughput_rates(active, ops_rate, succ_rate);
+
+  double total_ops = 0, total_succ = 0, total_bytes = 0;
+  uint32_t c;
+  for (c = 0; c < active; c++)
+    {
+      total_ops += ops_rate[c];
+      total_succ += succ_rate[c];
+      if (core_summaries[c].elapsed > 0)
+	{
+	  total_bytes += core_summaries[c].bytes / core_summaries[c].elapsed;
+	}
+    }
+
+  if (test_test == BANDWIDTH)
+    {
+      PRINT(" Threads %3u : %8.3f GB/s", active, total_bytes / 1e9);
+    }
+  else
+    {
+      PRINT(" Threads %3u : %8.3f Mops/s | %8.3f M successful ops/s | Jain fairness %5.3f",
+	    active, total_ops / 1e6, total_succ / 1e6, jain_index(succ_rate, active));
+    }
+
+  free(succ_rate);
+  free(ops_rate);
+}
+
+static void
+throughput_report()
+{
+  double* succ_rate = (double*) calloc(test_cores, sizeof(double));
+  double* ops_rate = (double*) calloc(test_cores, sizeof(double));
+  assert(succ_rate != NULL && ops_rate != NULL);
+  throughput_rates(test_cores, ops_rate, succ_rate);
+
+  double total_ops = 0, total_succ = 0;
+  uint32_t c;
+  for (c = 0; c < test_cores; c++)
+    {
+      const core_summary_t* s = &core_summaries[c];
+      total_ops += ops_rate[c];
+      total_succ += succ_rate[c];
+      PRINT(" Core %u : %12llu ops (%8.3f Mops/s) | %12llu successful (%5.1f%%) at byte %6zu",
+	    test_cores_array[c], (LLU) s->ops, ops_rate[c] / 1e6, (LLU) s->successes,
+	    s->ops ? 100.0 * s->successes / s->ops : 0.0,
+	    (size_t) ((volatile uint8_t*) throughput_word(shared_cache_line, c) - (volatile uint8_t*) shared_cache_line));
+    }
+
+  PRINT(" Aggregate : %8.3f Mops/s | %8.3f M successful ops/s | %u core(s) for %u ms",
+	total_ops / 1e6, total_succ / 1e6, test_cores, test_duration);
+  PRINT(" Jain fairness : %5.3f (successful ops) | %5.3f (all ops)",
+	jain_index(succ_rate, test_cores), jain_index(ops_rate, test_cores));
+
+  free(succ_rate);
+  free(ops_rate);
+}
+
+static void
+bandwidth_report()
+{
+  const size_t chunk = (test_mem_size / test_cores) & ~((size_t) BW_CHUNK_ALIGN - 1);
+  double total = 0;
+  uint32_t c;
+  for (c = 0; c < test_cores; c++)
+    {
+      const core_summary_t* s = &core_summaries[c];
+      double rate = (s->elapsed > 0) ? s->bytes / s->elapsed : 0;
+      total += rate;
+      const double per_4k = s->ops ? (double) s->cycles / (s->ops * (chunk / BW_CHUNK_ALIGN)) : 0;
+      PRINT(" Core %u : %8.3f GB/s | %8llu passes over %zu KiB | %8.1f cycles per 4 KiB",
+	    test_cores_array[c], rate / 1e9, (LLU) s->ops, chunk / 1024, per_4k);
+    }
+  PRINT(" Aggregate : %8.3f GB/s | %u core(s) for %u ms", total / 1e9, test_cores, test_duration);
+}
+
+static void
+lock_uncontended(volatile uint64_t reps)
+{
+  PFDI(0);
+  lock_acquire(shared_lock, &lock_local);
+  PFDO(0, reps);
+  PFDI(1);
+  lock_release(shared_lock, &lock_local);
+  PFDO(1, reps);
+}
+
+/* the handoff latency is the time from the release timestamp of core 1 */
+/* until core 0 holds the lock */
+static void
+lock_handoff_acquire(volatile uint64_t reps)
+{
+  lock_acquire(shared_lock, &lock_local);
+  ticks acquired = getticks();
+  pfd_store[0][reps] = acquired - lock_handoff_ts - pfd_correction;
+  lock_release(shared_lock, &lock_local);
+}
+
+static void
+lock_handoff_release(volatile uint64_t reps)
+{
+  wait_cycles(LOCK_HANDOFF_DELAY);
+  lock_handoff_ts = getticks();
+  PFDI(0);
+  lock_release(shared_lock, &lock_local);
+  PFDO(0, reps);
+}
+
+/* the writer publishes its timestamp as the new value of the line; every */
+/* reader spins until the value changes and keeps the delay until it saw it. */
+/* Store 0 of the writer is the store plus the mfence that waits for the */
+/* invalidations of the readers' copies */
+static void
+broadcast_write(volatile uint64_t* w, volatile uint64_t reps)
+{
+  wait_cycles(BROADCAST_DELAY);
+  PFDI(0);
+  *w = getticks();
+  _mm_mfence();
+  PFDO(0, reps);
+}
+
+static void
+broadcast_read(volatile uint64_t* w, uint64_t old, volatile uint64_t reps)
+{
+  uint64_t val;
+  while ((val = *w) == old)
+    {
+      asm volatile ("");
+    }
+  ticks seen = getticks();
+  pfd_store[0][reps] = seen - val - pfd_correction;
+}
+
+static void
+broadcast_report()
+{
+  const uint32_t writer = test_cores_array[0];
+  double rel_sum[TOPO_NUM_RELATIONS] = { 0 };
+  uint32_t rel_num[TOPO_NUM_RELATIONS] = { 0 };
+  double slowest = 0;
+
+  PRINT(" ** Results from Core 0 : store + mfence with %u reader(s) spinning on the line", test_cores - 1);
+  PRINT(" ** Results from the other cores : writer timestamp until the reader sees the new value");
+  PRINT(" Writer core %3u : %8.1f cycles (avg) | %8.1f cycles (avg of the 0-10%% cluster)",
+	writer, core_summaries[0].store[0].avg, core_summaries[0].store[0].avg_10p);
+
+  uint32_t c;
+  for (c = 1; c < test_cores; c++)
+    {
+      const abs_deviation_t* st = &core_summaries[c].store[0];
+      topo_relation_t rel = topo_relation(writer, test_cores_array[c]);
+      PRINT(" Reader core %3u : %8.1f cycles (avg) | %8.1f cycles (avg of the 0-10%% cluster) | %s",
+	    test_cores_array[c], st->avg, st->avg_10p, topo_relation_des[rel]);
+      rel_sum[rel] += st->avg;
+      rel_num[rel]++;
+      if (st->avg > slowest)
+	{
+	  slowest = st->avg;
+	}
+    }
+
+  uint32_t r;
+  for (r = 0; r < TOPO_NUM_RELATIONS; r++)
+    {
+      if (rel_num[r] > 0)
+	{
+	  PRINT(" %-12s : %8.1f cycles (avg of %u reader(s))", topo_relation_des[r], rel_sum[r] / rel_num[r], rel_num[r]);
+	}
+    }
+  PRINT(" Slowest reader : %8.1f cycles", slowest);
+}
+
+static inline volatile uint32_t*
+pingpong_flag(volatile cache_line_t* cache_line, uint32_t rank)
+{
+  if (test_separate)
+    {
+      return &(cache_line + rank * TP_LINE_SPACING)->word[0];
+    }
+  return &cache_line->word[rank];
+}
+
+static inline void
+pingpong_wait(volatile uint32_t* flag, uint32_t seq)
+{
+  if (test_pause)
+    {
+      while (*flag != seq)
+	{
+	  PAUSE();
+	}
+    }
+  else
+    {
+      while (*flag != seq)
+	{
+	  asm volatile ("");
+	}
+    }
+}
+
+/* the cores pass a token around the ring 0 -> 1 -> .. -> (cores - 1) -> 0 */
+/* by spinning on their own flag and writing the flag of the next one. */
+/* Core 0 times every trip around the ring; there are no barriers in between, */
+/* so store 0 keeps the ring time divided by the number of hops */
+static uint64_t
+pingpong_run(volatile cache_line_t* cache_line)
+{
+  if (test_cores < 2)
+    {
+      return 0;
+    }
+
+  volatile uint32_t* mine = pingpong_flag(cache_line, ID);
+  volatile uint32_t* next = pingpong_flag(cache_line, (ID + 1) % test_cores);
+  *mine = 0;
+  B1;
+
+  uint32_t round;
+  for (round = 0; round < PINGPONG_WARMUP + test_reps; round++)
+    {
+      uint32_t seq = round + 1;
+      if (ID == 0)
+	{
+	  if (round < PINGPONG_WARMUP)
+	    {
+	      *next = seq;
+	      pingpong_wait(mine, seq);
+	    }
+	  else
+	    {
+	      PFDI(0);
+	      *next = seq;
+	      pingpong_wait(mine, seq);
+	      PFDOR(0, round - PINGPONG_WARMUP, test_cores);
+	    }
+	}
+      else
+	{
+	  pingpong_wait(mine, seq);
+	  *next = seq;
+	}
+    }
+
+  B2;
+  return *mine;
+}
+
+static void
+pingpong_report()
+{
+  if (test_cores < 2)
+    {
+      PRINT(" ** Need >=2 processes to achieve PINGPONG");
+      return;
+    }
+
+  const abs_deviation_t* hop = &core_summaries[0].store[0];
+  PRINT(" ** Results from Core 0 : token ring over %u cores (%s, %s polling), per hop",
+	test_cores, test_separate ? "flags on separate lines" : "flags in the same line",
+	test_pause ? "pause" : "busy");
+  PRINT(" Ring round trip : %8.1f cycles over %u hops", hop->avg * test_cores, test_cores);
+  PRINT(" Round trip / hop: %8.1f cycles (there and back)", hop->avg * 2);
+  PRINT(" One-way latency : %8.1f cycles (avg) | %8.1f cycles (avg of the 0-10%% cluster)",
+	hop->avg, hop->avg_10p);
+}
+
+static uint32_t
+ring_producers()
+{
+  return (test_ring == RING_MPMC) ? test_cores / 2 : 1;
+}
+
+static uint32_t
+ring_consumers()
+{
+  return (test_ring == RING_MPMC) ? test_cores - test_cores / 2 : 1;
+}
+
+/* avg over all messages, percentiles over the (last test_reps) kept in store 0 */
+static void
+ring_latency_summary(core_summary_t* res, double sum, ticks max, uint64_t msgs)
+{
+  const double qs[] = { 0.50, 0.99 };
+  double pct[2];
+  get_percentiles(pfd_store[0], res->num_samples, qs, pct, 2);
+  res->lat_avg = msgs ? sum / msgs : 0;
+  res->lat_max = max;
+  res->lat_p50 = pct[0];
+  res->lat_p99 = pct[1];
+}
+
+/* the producers stamp every message with getticks() when it enters the ring and */
+/* enqueue for test_duration ms; the consumers drain the ring until all producers */
+/* are done. Store 0 of a consumer keeps (the last test_reps) enqueue-to-dequeue */
+/* latencies. Cores beyond producers + consumers stay idle */
+static uint64_t
+ring_run(volatile cache_line_t* cache_line)
+{
+  core_summary_t* res = &core_summaries[ID];
+  const uint32_t producers = ring_producers();
+  const uint32_t consumers = ring_consumers();
+  uint8_t msg[RING_MAX_PAYLOAD] ALIGNED(64);
+  ring_local_t local;
+  ring_local_init(shared_ring, &local);
+  memset(msg, ID, sizeof(msg));
+
+  uint64_t msgs = 0;
+  double lat_sum = 0;
+  ticks lat_max = 0;
+  res->ops = res->successes = res->bytes = 0;
+  res->num_samples = 0;
+
+  B1;
+  double start = wtime();
+  double now = start;
+  if (ID < producers)
+    {
+      double stop = start + test_duration / 1000.0;
+      do
+	{
+	  uint32_t i;
+	  for (i = 0; i < TP_BATCH; i++)
+	    {
+	      do
+		{
+		  *(ticks*) msg = getticks(); /* waiting for a free slot is not latency */
+		}
+	      while (!ring_enqueue(shared_ring, &local, msg));
+	    }
+	  msgs += TP_BATCH;
+	  now = wtime();
+	}
+      while (now < stop);
+      ring_flush(shared_ring, &local);
+      FAI_U32(&shared_ring->producers_done);
+    }
+  else if (ID < producers + consumers)
+    {
+      while (1)
+	{
+	  uint32_t done = shared_ring->producers_done; /* before the dequeue that may find it empty */
+	  if (ring_dequeue(shared_ring, &local, msg))
+	    {
+	      ticks lat = getticks() - *(ticks*) msg;
+	      pfd_store[0][msgs % test_reps] = lat;
+	      lat_sum += lat;
+	      if (lat > lat_max)
+		{
+		  lat_max = lat;
+		}
+	      msgs++;
+	    }
+	  else if (done == producers)
+	    {
+	      break;
+	    }
+	}
+      now = wtime();
+      res->num_samples = (msgs < test_reps) ? msgs : test_reps;
+      ring_latency_summary(res, lat_sum, lat_max, msgs);
+    }
+
+  res->ops = res->successes = msgs;
+  res->bytes = msgs * test_payload;
+  res->elapsed = now - start;
+  B2;
+  return msgs;
+}
+
+static void
+ring_report()
+{
+  const uint32_t producers = ring_producers();
+  const uint32_t consumers = ring_consumers();
+  PRINT(" ** Results: %s ring of %u slots, %u-byte messages, %u producer(s) -> %u consumer(s) for %u ms",
+	ring_kind_des[test_ring], RING_SLOTS, test_payload, producers, consumers, test_duration);
+
+  double elapsed = 0, lat_sum = 0;
+  uint64_t total = 0;
+  uint32_t c;
+  for (c = 0; c < producers + consumers; c++)
+    {
+      const core_summary_t* s = &core_summaries[c];
+      double rate = (s->elapsed > 0) ? s->ops / s->elapsed : 0;
+      if (c < producers)
+	{
+	  PRINT(" Core %u : producer | %12llu msgs (%8.3f Mmsgs/s)", test_cores_array[c], (LLU) s->ops, rate / 1e6);
+	  continue;
+	}
+      PRINT(" Core %u : consumer | %12llu msgs (%8.3f Mmsgs/s) | enqueue to dequeue avg %8.1f / p50 %8.0f / "
+	    "p99 %8.0f / max %10.0f cycles", test_cores_array[c], (LLU) s->ops, rate / 1e6,
+	    s->lat_avg, s->lat_p50, s->lat_p99, s->lat_max);
+      total += s->ops;
+      lat_sum += s->lat_avg * s->ops;
+      if (s->elapsed > elapsed)
+	{
+	  elapsed = s->elapsed;
+	}
+    }
+
+  double rate = (elapsed > 0) ? total / elapsed : 0;
+  PRINT(" Aggregate : %8.3f Mmsgs/s | %8.3f GB/s | %8.1f ns per message | %8.1f cycles enqueue to dequeue",
+	rate / 1e6, rate * test_payload / 1e9, rate ? 1e9 / rate : 0.0, total ? lat_sum / total : 0.0);
+}
+
+/* ATOMIC_MATRIX: for every ordered pair of cores (a, b) on a line homed on the node of b */
+/*   - the latency of a CAS on core a after b wrote the line and flushed it to its memory */
+/*   - the latency of a CAS on core a while the line is modified in the cache of b */
+/*   - the CAS and the FAI throughput of a and b hammering the line together */
+/* The cells run one after the other; the other cores wait in the barriers */
+static void
+atomic_matrix_tp(volatile uint32_t* w, uint32_t a, uint32_t b, uint32_t (*op)(volatile uint32_t*),
+		 double* cell)
+{
+  core_summary_t* res = &core_summaries[ID];
+  B1;
+  if (ID == a || ID == b)
+    {
+      throughput_loop(w, op, res);
+    }
+  B2;
+  if (ID == a)
+    {
+      const core_summary_t* other = &core_summaries[b];
+      *cell = res->successes / res->elapsed + other->successes / other->elapsed;
+    }
+}
+
+static uint64_t
+atomic_matrix_run(volatile cache_line_t* cache_line)
+{
+  /* the first touch, from the node that topo_prefer_node picked for this core */
+  *(volatile uint32_t*) (matrix_pages + (size_t) ID * PAGE_SIZE_4K) = 0;
+  _mm_mfence();
+
+  uint64_t sum = 0;
+  uint32_t a, b;
+  for (a = 0; a < test_cores; a++)
+    {
+      for (b = 0; b < test_cores; b++)
+	{
+	  if (a == b)
+	    {
+	      continue;
+	    }
+
+	  volatile uint32_t* w = (volatile uint32_t*) (matrix_pages + (size_t) b * PAGE_SIZE_4K);
+
+	  uint32_t owned;
+	  for (owned = 0; owned < 2; owned++)
+	    {
+	      uint32_t rep;
+	      for (rep = 0; rep < test_reps; rep++)
+		{
+		  B1;
+		  if (ID == b)
+		    {
+		      *w = rep;	/* b owns the line in modified state */
+		      if (!owned)
+			{
+			  _mm_mfence();
+			  _mm_clflush((void*) w); /* a's CAS is served from b's node memory */
+			  _mm_mfence();
+			}
+		    }
+		  B2;
+		  if (ID == a)
+		    {
+		      PFDI(0);
+		      sum += CAS_U32(w, rep, rep + 1);
+		      PFDO(0, rep);
+		    }
+		}
+	      if (ID == a)
+		{
+		  abs_deviation_t ad;
+		  get_abs_deviation(pfd_store[0], test_reps, &ad);
+		  (owned ? matrix_owned_lat : matrix_cas_lat)[a * test_cores + b] = ad.avg;
+		}
+	    }
+
+	  atomic_matrix_tp(w, a, b, tp_cas, &matrix_cas_tp[a * test_cores + b]);
+	  atomic_matrix_tp(w, a, b, tp_fai, &matrix_fai_tp[a * test_cores + b]);
+	}
+    }
+  return sum;
+}
+
+static void
+atomic_matrix_print(const char* what, const double* cells, double scale, const char* fmt)
+{
+  char line[4096];
+  int len;
+  uint32_t a, b;
+
+  PRINT(" %s (row: core a, column: core b)", what);
+  len = snprintf(line, sizeof(line), "       ");
+  for (b = 0; b < test_cores && len < (int) sizeof(line) - 16; b++)
+    {
+      len += snprintf(line + len, sizeof(line) - len, " %8u", test_cores_array[b]);
+    }
+  PRINT("%s", line);
+  for (a = 0; a < test_cores; a++)
+    {
+      len = snprintf(line, sizeof(line), " %5u ", test_cores_array[a]);
+      for (b = 0; b < test_cores && len < (int) sizeof(line) - 16; b++)
+	{
+	  if (a == b)
+	    {
+	      len += snprintf(line + len, sizeof(line) - len, " %8s", "-");
+	    }
+	  else
+	    {
+	      len += snprintf(line + len, sizeof(line) - len, fmt, cells[a * test_cores + b] / scale);
+	    }
+	}
+      PRINT("%s", line);
+    }
+}
+
+static void
+atomic_matrix_report()
+{
+  PRINT(" ** Results from %u cores: CAS latency on a line homed on the node of core b, in its memory and"
+	" modified in its cache (%u reps), CAS and FAI throughput of both cores on the line (%u ms per cell)",
+	test_cores, test_reps, test_duration);
+  atomic_matrix_print("CAS latency in cycles, line in b's node memory", matrix_cas_lat, 1, " %8.1f");
+  atomic_matrix_print("CAS latency in cycles, line owned by b", matrix_owned_lat, 1, " %8.1f");
+  atomic_matrix_print("CAS throughput in M successful ops/s", matrix_cas_tp, 1e6, " %8.3f");
+  atomic_matrix_print("FAI throughput in Mops/s", matrix_fai_tp, 1e6, " %8.3f");
+
+  uint32_t a, b, n;
+  for (a = 0; a < test_cores; a++)
+    {
+      for (b = 0; b < test_cores; b++)
+	{
+	  if (a == b)
+	    {
+	      continue;
+	    }
+	  report_row_t row;
+	  report_row_init(&row, a, 0);
+	  snprintf(row.step, sizeof(row.step), "CAS, line of core %u", test_cores_array[b]);
+	  row.samples = test_reps;
+	  row.avg = matrix_cas_lat[a * test_cores + b];
+	  row.mops = matrix_cas_tp[a * test_cores + b] / 1e6;
+	  report_record(&row);
+
+	  report_row_init(&row, a, 0);
+	  snprintf(row.step, sizeof(row.step), "CAS, line owned by core %u", test_cores_array[b]);
+	  row.samples = test_reps;
+	  row.avg = matrix_owned_lat[a * test_cores + b];
+	  report_record(&row);
+
+	  report_row_init(&row, a, 0);
+	  snprintf(row.step, sizeof(row.step), "FAI, line of core %u", test_cores_array[b]);
+	  row.mops = matrix_fai_tp[a * test_cores + b] / 1e6;
+	  report_record(&row);
+	}
+    }
+
+  /* node of every core, folded to 0..nodes-1 in the order of appearance */
+  int32_t* node_ids = (int32_t*) calloc(test_cores, sizeof(int32_t));
+  uint32_t* node_of = (uint32_t*) calloc(test_cores, sizeof(uint32_t));
+  assert(node_ids != NULL && node_of != NULL);
+  uint32_t nodes = 0;
+  for (a = 0; a < test_cores; a++)
+    {
+      int32_t id = topo_cpu(test_cores_array[a])->node;
+      for (n = 0; n < nodes && node_ids[n] != id; n++)
+	;
+      if (n == nodes)
+	{
+	  node_ids[nodes++] = id;
+	}
+      node_of[a] = n;
+    }
+
+  PRINT(" ---- Node summary (average over the core pairs) ----");
+  uint32_t na, nb;
+  for (na = 0; na < nodes; na++)
+    {
+      for (nb = 0; nb < nodes; nb++)
+	{
+	  double lat = 0, owned_lat = 0, cas_tp = 0, fai_tp = 0;
+	  uint32_t pairs = 0;
+	  for (a = 0; a < test_cores; a++)
+	    {
+	      for (b = 0; b < test_cores; b++)
+		{
+		  if (a != b && node_of[a] == na && node_of[b] == nb)
+		    {
+		      lat += matrix_cas_lat[a * test_cores + b];
+		      owned_lat += matrix_owned_lat[a * test_cores + b];
+		      cas_tp += matrix_cas_tp[a * test_cores + b];
+		      fai_tp += matrix_fai_tp[a * test_cores + b];
+		      pairs++;
+		    }
+		}
+	    }
+	  if (pairs > 0)
+	    {
+	      PRINT(" Node %2d -> node %2d : CAS %8.1f cycles from memory, %8.1f owned | CAS %8.3f M successful ops/s | FAI %8.3f Mops/s | %u pair(s)",
+		    node_ids[na], node_ids[nb], lat / pairs, owned_lat / pairs, cas_tp / pairs / 1e6,
+		    fai_tp / pairs / 1e6, pairs);
+	    }
+	}
+    }
+  free(node_ids);
+  free(node_of);
+}
+
+/* keeps the store 0 samples of this core for pooled_percentiles */
+static void
+pool_samples(const core_summary_t* res)
+{
+  uint32_t i;
+  for (i = 0; i < res->num_samples; i++)
+    {
+      pooled_samples[ID * test_reps + i] = pfd_store[0][i];
+    }
+}
+
+/* percentiles over the pooled samples of the first active cores */
+static void
+pooled_percentiles(uint32_t active, const double* qs, double* out, uint32_t num_qs)
+{
+  size_t n = 0;
+  uint32_t c;
+  for (c = 0; c < active; c++)
+    {
+      const core_summary_t* s = &core_summaries[c];
+      memmove(pooled_samples + n, pooled_samples + c * test_reps, s->num_samples * sizeof(ticks));
+      n += s->num_samples;
+    }
+  get_percentiles(pooled_samples, n, qs, out, num_qs);
+}
+
+/* FETCH_OP: one logical update of the 64-bit word w; returns the failed CASes */
+static inline uint32_t
+fop_update(volatile uint64_t* w, fop_kind_t kind)
+{
+  uint32_t fails = 0;
+  switch (kind)
+    {
+    case FOP_FAI:
+      FAI_U64(w);
+      break;
+    case FOP_CAS_FAI:
+      {
+	uint64_t o = *w, cur;
+	while ((cur = CAS_U64(w, o, o + 1)) != o)
 	  {
-	    PRINT(" ** Results from Core 0 : load from modified");
-	    PRINT(" ** Results from Core 1 : FAI on shared");
-	    PRINT(" ** Results from Core 2 : load from exlusive or shared");
-	    if (test_cores < 3)
-	      {
-		PRINT(" ** Need >=3 processes to achieve FAI_ON_SHARED");
-	      }
-	    break;
+	    o = cur;
+	    fails++;
 	  }
-	case TAS_ON_SHARED:
+	break;
+      }
+    case FOP_CAS_MAX:		/* e.g., the latest timestamp: no write if someone is ahead */
+      {
+	uint64_t v = getticks(), o = *w, cur;
+	while (o < v && (cur = CAS_U64(w, o, v)) != o)
 	  {
-	    PRINT(" ** Results from Core 0 : load from L1");
-	    uint32_t succ = test_ao_success * 100;
-	    PRINT(" ** Results from Core 1 : TAS on shared (%d%% successfull)", succ);
-	    PRINT(" ** Results from Core 2 : load from exlusive or shared");
-	    if (test_cores < 3)
-	      {
-		PRINT(" ** Need >=3 processes to achieve TAS_ON_SHARED");
-	      }
-	    break;
+	    o = cur;
+	    fails++;
 	  }
-	case SWAP_ON_SHARED:
+	break;
+      }
+    case FOP_CAS_BACKOFF:	/* load-linked / store-conditional style: reload and back off */
+    default:
+      {
+	uint32_t window = LOCK_BACKOFF_MIN;
+	while (1)
 	  {
-	    PRINT(" ** Results from Core 0 : load from modified");
-	    PRINT(" ** Results from Core 1 : SWAP on shared");
-	    PRINT(" ** Results from Core 2 : load from exlusive or shared");
-	    if (test_cores < 3)
+	    uint64_t o = *w;
+	    if (CAS_U64(w, o, o + 1) == o)
 	      {
-		PRINT(" ** Need >=3 processes to achieve SWAP_ON_SHARED");
+		break;
 	      }
-	    break;
-	  }
-        case CAS_CONCURRENT:
-          {
-            PRINT(" ** Results from %u cores: CAS concurrent", test_cores);
-            break;
-          }
-	case FAI_ON_INVALID:
-	  {
-	    PRINT(" ** Results from Core 0 : FAI on invalid");
-	    PRINT(" ** Results from Core 1 : cache line flush");
-	    break;
-	  }
-	case LOAD_FROM_L1:
-	  {
-	    PRINT(" ** Results from Core 0: load from L1");
-	    break;
-	  }
-	case LOAD_FROM_MEM_SIZE:
-	  {
-	    PRINT(" ** Results from Corees 0 & 1 & 2: load from random %zu KiB", test_mem_size / 1024);
-	    break;
-	  }
-	case LFENCE:
-	  {
-	    PRINT(" ** Results from Cores 0 & 1: load fence");
-	    break;
-	  }
-	case SFENCE:
-	  {
-	    PRINT(" ** Results from Cores 0 & 1: store fence");
-	    break;
-	  }
-	case MFENCE:
-	  {
-	    PRINT(" ** Results from Cores 0 & 1: full fence");
-	    break;
-	  }
-	case PROFILER:
-	  {
-	    PRINT(" ** Results from Cores 0 & 1: empty profiler region (start_prof - empty - stop_prof");
-	    break;
+	    fails++;
+	    lock_backoff(&window);
 	  }
+	break;
+      }
+    }
+  return fails;
+}
+
+static inline void
+fop_loop(volatile uint64_t* w, fop_kind_t kind, core_summary_t* res)
+{
+  uint64_t ops = 0, fails = 0;
+  uint32_t samples = 0;
+  double start = wtime();
+  double stop = start + test_duration / 1000.0;
+  double now;
+
+  do
+    {
+      uint32_t i;
+      for (i = 0; i < TP_BATCH; i++)
+	{
+	  fails += fop_update(w, kind);
+	}
+
+      uint32_t entry = samples % test_reps;
+      PFDI(0);
+      fails += fop_update(w, kind);
+      PFDO(0, entry);
+      samples++;
+      ops += TP_BATCH + 1;
+      now = wtime();
+    }
+  while (now < stop);
+
+  res->ops = res->successes = ops;
+  res->retries = fails;
+  res->elapsed = now - start;
+  res->num_samples = (samples < test_reps) ? samples : test_reps;
+}
+
+static void
+fop_step_report(uint32_t kind, uint32_t active)
+{
+  const double qs[] = { 0.50, 0.99, 0.999, 1.0 };
+  double pct[4];
+  double rate = 0;
+  uint64_t ops = 0, retries = 0;
+  uint32_t c;
+  for (c = 0; c < active; c++)
+    {
+      const core_summary_t* s = &core_summaries[c];
+      if (s->elapsed > 0)
+	{
+	  rate += s->ops / s->elapsed;
+	}
+      ops += s->ops;
+      retries += s->retries;
+    }
+  char step[64];
+  snprintf(step, sizeof(step), "%s, %u threads", fop_kind_des[kind], active);
+  report_step_cores(active, step);
+  pooled_percentiles(active, qs, pct, 4);
+
+  PRINT(" Threads %3u : %8.3f Mops/s | %7.3f retries per update | update p50 %6.0f / p99 %7.0f / p99.9 %7.0f / max %8.0f cycles",
+	active, rate / 1e6, ops ? (double) retries / ops : 0.0, pct[0], pct[1], pct[2], pct[3]);
+}
+
+/* every variant runs with 1, 2, .., test_cores cores updating the same word for */
+/* test_duration ms; the latency of every TP_BATCH-th update, retries included, */
+/* is sampled */
+static uint64_t
+fop_run(volatile cache_line_t* cache_line)
+{
+  volatile uint64_t* w = (volatile uint64_t*) cache_line->word;
+  core_summary_t* res = &core_summaries[ID];
+  uint32_t kind, active;
+
+  for (kind = 0; kind < FOP_NUM_KINDS; kind++)
+    {
+      if (ID == 0)
+	{
+	  PRINT(" ** %s", fop_kind_des[kind]);
+	}
+      for (active = 1; active <= test_cores; active++)
+	{
+	  B1;
+	  res->ops = res->successes = res->retries = 0;
+	  res->elapsed = 0;
+	  res->num_samples = 0;
+	  if (ID < active)
+	    {
+	      fop_loop(w, kind, res);
+	      pool_samples(res);
+	    }
+	  B2;
+	  if (ID == 0)
+	    {
+	      fop_step_report(kind, active);
+	    }
+	}
+    }
+
+  return *w;
+}
+
+/* SMT_INTERFERENCE: the latency-critical probes of core 0 */
+static inline uint64_t
+smt_probe(uint32_t probe, volatile uint64_t** pos)
+{
+  uint32_t i;
+  if (probe == 0)
+    {
+      volatile uint64_t* p = *pos;
+      for (i = 0; i < SMT_PROBE_OPS; i++)
+	{
+	  p = (volatile uint64_t*) *p;
+	}
+      *pos = p;
+      return (uint64_t) p;
+    }
+
+  uint64_t x = (uint64_t) *pos;
+  for (i = 0; i < SMT_PROBE_OPS; i++)
+    {
+      x = x * 0x9E3779B97F4A7C15UL + i;
+      asm volatile ("" : "+r" (x));
+    }
+  return x;
+}
+
+/* the load core 1 puts on the shared physical core until smt_stop */
+static uint64_t
+smt_background(smt_load_t load)
+{
+  volatile uint64_t* p = smt_heads[1];
+  uint64_t x = ID;
+  uint32_t i;
+  switch (load)
+    {
+    case SMT_IDLE:
+      while (!smt_stop)
+	{
+	  usleep(100);		/* the hardware thread halts */
+	}
+      break;
+    case SMT_PAUSE:
+      while (!smt_stop)
+	{
+	  PAUSE();
+	}
+      break;
+    case SMT_SPIN:
+      while (!smt_stop)
+	{
+	  asm volatile ("");
+	}
+      break;
+    case SMT_MEMORY:
+      while (!smt_stop)
+	{
+	  for (i = 0; i < SMT_PROBE_OPS; i++)
+	    {
+	      p = (volatile uint64_t*) *p;
+	    }
+	}
+      x = (uint64_t) p;
+      break;
+    case SMT_ALU:
+    default:
+      while (!smt_stop)
+	{
+	  for (i = 0; i < SMT_PROBE_OPS; i++)
+	    {
+	      x = x * 0x9E3779B97F4A7C15UL + i;
+	      asm volatile ("" : "+r" (x));
+	    }
+	}
+      break;
+    }
+  return x;
+}
+
+/* core 0 times an L1-resident pointer chase and a dependent multiply chain */
+/* while core 1 (its SMT sibling, see --smt-pair) idles, spins with and */
+/* without PAUSE, chases a random chain over --mem-size, or multiplies */
+static uint64_t
+smt_run(volatile cache_line_t* cache_line)
+{
+  const size_t probe_lines = SMT_PROBE_BYTES / sizeof(cache_line_t);
+  volatile uint64_t* pos;
+  uint64_t sum = 0;
+
+  if (ID == 0)
+    {
+      create_chain_cl(cache_line, SMT_PROBE_BYTES, CHAIN_RANDOM, PAGE_SIZE_4K, &smt_heads[0]);
+      create_chain_cl(cache_line + probe_lines, test_mem_size - SMT_PROBE_BYTES, CHAIN_RANDOM,
+		      PAGE_SIZE_4K, &smt_heads[1]);
+    }
+
+  uint32_t load;
+  for (load = 0; load < SMT_NUM_LOADS; load++)
+    {
+      if (ID == 0)
+	{
+	  smt_stop = 0;
+	}
+      B1;
+      if (ID == 0)
+	{
+	  wait_cycles(SMT_WARMUP);
+	  uint32_t probe;
+	  for (probe = 0; probe < 2; probe++)
+	    {
+	      pos = smt_heads[0];
+	      sum += smt_probe(probe, &pos); /* warm up */
+	      uint32_t r;
+	      double total = 0;
+	      for (r = 0; r < test_reps; r++)
+		{
+		  PFDI(0);
+		  sum += smt_probe(probe, &pos);
+		  PFDO(0, r);
+		  total += pfd_store[0][r];
+		}
+	      const double qs[] = { 0.50, 0.99 };
+	      double* out = smt_results[load][probe];
+	      get_percentiles(pfd_store[0], test_reps, qs, out + 1, 2);
+	      out[0] = total / test_reps;
+	    }
+	  smt_stop = 1;
+	}
+      else if (ID == 1)
+	{
+	  sum += smt_background(load);
+	}
+      B2;
+    }
+
+  return sum;
+}
+
+static void
+smt_report()
+{
+  PRINT(" ** Results from Core %u (%s of core %u): cycles per %u dependent L1 loads / %u dependent multiplies",
+	test_cores_array[0], topo_relation_des[topo_relation(test_cores_array[1], test_cores_array[0])],
+	test_cores_array[1], SMT_PROBE_OPS, SMT_PROBE_OPS);
+  uint32_t load;
+  for (load = 0; load < SMT_NUM_LOADS; load++)
+    {
+      const double* l1 = smt_results[load][0];
+      const double* alu = smt_results[load][1];
+      PRINT(" Sibling %-12s : loads %8.1f (p50 %7.0f, p99 %7.0f) %5.2fx | multiplies %8.1f (p50 %7.0f, p99 %7.0f) %5.2fx",
+	    smt_load_des[load], l1[0], l1[1], l1[2], l1[0] / smt_results[SMT_IDLE][0][0],
+	    alu[0], alu[1], alu[2], alu[0] / smt_results[SMT_IDLE][1][0]);
+
+      uint32_t probe;
+      for (probe = 0; probe < 2; probe++)
+	{
+	  const double* res = smt_results[load][probe];
+	  report_row_t row;
+	  report_row_init(&row, 0, 0);
+	  snprintf(row.step, sizeof(row.step), "%s sibling, %s", smt_load_des[load],
+		   probe ? "multiplies" : "loads");
+	  row.samples = test_reps;
+	  row.avg = res[0];
+	  row.quantiles[0] = res[1];
+	  row.quantiles[2] = res[2];
+	  report_record(&row);
+	}
+    }
+}
+
+/* LOCKFREE: every core runs the --update-ratio mix of updates (push, enqueue, */
+/* increment) and other ops (pop, dequeue, read) on the shared structure, in a */
+/* fixed interleaving; the latency of every TP_BATCH-th op is sampled */
+static inline int
+lf_op(uint32_t* mix, uint64_t* updates)
+{
+  uint64_t v;
+  *mix += test_update_ratio;
+  if (*mix >= 100)
+    {
+      *mix -= 100;
+      int ok = lf_update(shared_lf, &lf_local, ID);
+      *updates += ok;
+      return ok;
+    }
+  return lf_other(shared_lf, &lf_local, &v);
+}
+
+static inline void
+lf_loop(core_summary_t* res)
+{
+  uint64_t ops = 0, succ = 0, updates = 0;
+  uint32_t samples = 0, mix = 0;
+  lf_local.cas = lf_local.cas_failed = 0;
+  double start = wtime();
+  double stop = start + test_duration / 1000.0;
+  double now;
+
+  do
+    {
+      uint32_t i;
+      for (i = 0; i < TP_BATCH; i++)
+	{
+	  succ += lf_op(&mix, &updates);
+	}
+
+      uint32_t entry = samples % test_reps;
+      int ok;
+      PFDI(0);
+      ok = lf_op(&mix, &updates);
+      PFDO(0, entry);
+      succ += ok;
+      samples++;
+      ops += TP_BATCH + 1;
+      now = wtime();
+    }
+  while (now < stop);
+
+  res->ops = ops;
+  res->successes = succ;
+  res->updates = updates;
+  res->cas = lf_local.cas;
+  res->retries = lf_local.cas_failed;
+  res->elapsed = now - start;
+  res->num_samples = (samples < test_reps) ? samples : test_reps;
+  pool_samples(res);
+}
+
+/* the size of the stack or queue (or the counter value) after the first active */
+/* cores ran, compared with what their successful ops imply */
+static void
+lf_check(uint32_t active)
+{
+  uint32_t c;
+  for (c = 0; c < active; c++)
+    {
+      const core_summary_t* s = &core_summaries[c];
+      if (test_lf_struct == LF_COUNTER || test_lf_struct == LF_SHARDED_COUNTER)
+	{
+	  lf_expected += s->updates;
+	}
+      else
+	{
+	  lf_expected += (int64_t) s->updates - (int64_t) (s->successes - s->updates);
+	}
+    }
+
+  uint64_t actual = 0;
+  uint64_t limit = (uint64_t) test_cores * LF_NODES_PER_THREAD + 1;
+  switch (test_lf_struct)
+    {
+    case LF_COUNTER:
+      actual = shared_lf->counter;
+      break;
+    case LF_SHARDED_COUNTER:
+      lf_other(shared_lf, &lf_local, &actual);
+      break;
+    default:
+      actual = lf_size(shared_lf, limit);
+      break;
+    }
+
+  if ((int64_t) actual != lf_expected)
+    {
+      PRINT(" Check : INCONSISTENT, %llu%s elements instead of %lld%s", (LLU) actual,
+	    (actual == limit) ? "+" : "", (long long) lf_expected,
+	    (test_lf_struct == LF_TREIBER) ? " (ABA on the untagged top)" : "");
+      lf_expected = actual;	/* so that the next step is checked on its own */
+    }
+  else
+    {
+      PRINT(" Check : consistent, %llu elements", (LLU) actual);
+    }
+}
+
+static void
+lf_report(uint32_t active)
+{
+  const double qs[] = { 0.50, 0.99, 0.999 };
+  double pct[3];
+  double rate = 0;
+  uint64_t ops = 0, succ = 0, cas = 0, failed = 0;
+  uint32_t c;
+  for (c = 0; c < active; c++)
+    {
+      const core_summary_t* s = &core_summaries[c];
+      double r = (s->elapsed > 0) ? s->ops / s->elapsed : 0;
+      if (!test_scale)
+	{
+	  PRINT(" Core %u : %12llu ops (%8.3f Mops/s) | %5.1f%% done (not empty / not out of nodes) | %6.2f%% of %llu CASes failed",
+		test_cores_array[c], (LLU) s->ops, r / 1e6, s->ops ? 100.0 * s->successes / s->ops : 0.0,
+		s->cas ? 100.0 * s->retries / s->cas : 0.0, (LLU) s->cas);
+	}
+      rate += r;
+      ops += s->ops;
+      succ += s->successes;
+      cas += s->cas;
+      failed += s->retries;
+    }
+  pooled_percentiles(active, qs, pct, 3);
+
+  PRINT(" Threads %3u : %8.3f Mops/s | %5.1f%% done | %6.2f%% CASes failed (%5.3f per op) | op p50 %6.0f / p99 %7.0f / p99.9 %7.0f cycles",
+	active, rate / 1e6, ops ? 100.0 * succ / ops : 0.0, cas ? 100.0 * failed / cas : 0.0,
+	ops ? (double) failed / ops : 0.0, pct[0], pct[1], pct[2]);
+  lf_check(active);
+}
+
+static size_t
+sweep_mem_size(uint32_t step)
+{
+  /* 4 KiB, 6 KiB, 8 KiB, 12 KiB, .. up to test_mem_size */
+  size_t size = SWEEP_MIN_SIZE;
+  uint32_t s = 0;
+  while (1)
+    {
+      if (s++ == step)
+	{
+	  return size;
+	}
+      if ((size + size / 2) <= test_mem_size && (size << 1) > size + size / 2)
+	{
+	  if (s++ == step)
+	    {
+	      return size + size / 2;
+	    }
+	}
+      size <<= 1;
+    }
+}
+
+/* cache sizes from sysfs, index = level (1-3); 0 if unknown */
+static void
+sweep_cache_sizes(size_t* sizes)
+{
+  uint32_t idx;
+  for (idx = 0; idx < 8; idx++)
+    {
+      char path[128], type[32];
+      uint32_t level = 0;
+      size_t kib = 0;
+
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/type", idx);
+      FILE* f = fopen(path, "r");
+      if (f == NULL)
+	{
+	  break;
+	}
+      int ok = (fscanf(f, "%31s", type) == 1);
+      fclose(f);
+      if (!ok || strcmp(type, "Instruction") == 0)
+	{
+	  continue;
+	}
+
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/level", idx);
+      if ((f = fopen(path, "r")) != NULL)
+	{
+	  ok = (fscanf(f, "%u", &level) == 1);
+	  fclose(f);
+	}
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/size", idx);
+      if ((f = fopen(path, "r")) != NULL)
+	{
+	  ok = ok && (fscanf(f, "%zuK", &kib) == 1);
+	  fclose(f);
+	}
+      if (ok && level >= 1 && level <= 3)
+	{
+	  sizes[level] = kib * 1024;
+	}
+    }
+}
+
+/* --sweep-mem: for every working-set size, core 0 rebuilds the chain in place, */
+/* every core warms up and then takes test_reps samples of SWEEP_LOADS dependent loads */
+static uint64_t
+sweep_mem_run(volatile cache_line_t* cache_line)
+{
+  uint64_t sum = 0;
+  uint32_t step;
+
+  for (step = 0; step < sweep_steps; step++)
+    {
+      size_t size = sweep_mem_size(step);
+
+      if (ID == 0)
+	{
+	  sweep_lines = create_chain_cl(cache_line, size, test_chain_mode, test_page_size, &chain_head);
+	}
+      B1;
+
+      volatile uint64_t* cl = chain_head;
+      test_chase_loads = (sweep_lines < SWEEP_WARMUP_LOADS) ? sweep_lines : SWEEP_WARMUP_LOADS;
+      cl = (volatile uint64_t*) load_next(cl, 0);
+      B2;
+
+      test_chase_loads = SWEEP_LOADS;
+      uint32_t r;
+      for (r = 0; r < test_reps; r++)
+	{
+	  cl = (volatile uint64_t*) load_next(cl, r);
+	}
+      sum += (uint64_t) cl;
+
+      abs_deviation_t stats;
+      get_abs_deviation(pfd_store[0], test_reps, &stats);
+      sweep_latency[step * test_cores + ID] = stats.avg;
+      B3;
+
+      if (ID == 0)
+	{
+	  PRINT(" Size %10zu KiB : %8.1f cycles per load (core 0)", size / 1024, stats.avg);
+	}
+    }
+
+  return sum;
+}
+
+/* average cycles per load of test_reps samples of SWEEP_LOADS loads, after a warm-up */
+/* pass over the lines of the cycle at head */
+static double
+tlb_chase(volatile uint64_t* head, size_t lines)
+{
+  volatile uint64_t* cl = head;
+  test_chase_loads = (lines < SWEEP_WARMUP_LOADS) ? 2 * lines : SWEEP_WARMUP_LOADS;
+  cl = (volatile uint64_t*) load_next(cl, 0);
+
+  test_chase_loads = SWEEP_LOADS;
+  uint32_t r;
+  for (r = 0; r < test_reps; r++)
+    {
+      cl = (volatile uint64_t*) load_next(cl, r);
+    }
+
+  abs_deviation_t stats;
+  get_abs_deviation(pfd_store[0], test_reps, &stats);
+  return stats.avg;
+}
+
+/* TLB_SWEEP: core 0 chases one random line per 4 KiB page, pages at random, over */
+/* 1, 2, 3, 4, 6, .. pages, once on the 4K buffer and once, in the same order, on */
+/* a 2M-backed copy. The lines and the cache behavior are the same; the difference */
+/* is what the TLB misses and page walks cost */
+static uint64_t
+tlb_sweep_run(volatile cache_line_t* cache_line)
+{
+  if (ID != 0)
+    {
+      return 0;
+    }
+
+  const char* how;
+  volatile cache_line_t* huge = (volatile cache_line_t*) huge_alloc(test_mem_size, PAGE_SIZE_2M, &how);
+  if (huge == NULL)
+    {
+      PRINT(" ** TLB_SWEEP: cannot back the buffer with 2 MiB pages (hugetlbfs or transparent huge pages)");
+      return 0;
+    }
+  memset((void*) huge, 0, test_mem_size);
+  PRINT(" ** Comparing 4 KiB pages with 2 MiB pages (%s)", how);
+
+  uint64_t sum = 0;
+  uint32_t step;
+  for (step = 0; step < sweep_steps; step++)
+    {
+      size_t size = sweep_mem_size(step);
+      volatile uint64_t* head;
+      size_t pages = create_chain_cl(cache_line, size, CHAIN_PAGE_RANDOM, PAGE_SIZE_4K, &head);
+      sweep_latency[2 * step] = tlb_chase(head, pages);
+      sum += (uint64_t) head;
+
+      create_chain_cl(huge, size, CHAIN_PAGE_RANDOM, PAGE_SIZE_4K, &head);
+      sweep_latency[2 * step + 1] = tlb_chase(head, pages);
+      sum += (uint64_t) head;
+    }
+
+  return sum;
+}
+
+static void
+tlb_sweep_report()
+{
+  PRINT(" ** Results from Core 0 : cycles per load, one line per 4 KiB page, pages at random (%u reps of %d loads)",
+	test_reps, SWEEP_LOADS);
+
+  uint32_t step, first_miss = sweep_steps;
+  for (step = 0; step < sweep_steps; step++)
+    {
+      double small = sweep_latency[2 * step], huge = sweep_latency[2 * step + 1];
+      PRINT(" Pages %8zu : 4K %8.1f | 2M %8.1f | TLB + walk %8.1f", sweep_mem_size(step) / PAGE_SIZE_4K,
+	    small, huge, small - huge);
+      uint32_t page;
+      for (page = 0; page < 2; page++)
+	{
+	  report_row_t row;
+	  report_row_init(&row, 0, 0);
+	  snprintf(row.step, sizeof(row.step), "%zu pages, %s", sweep_mem_size(step) / PAGE_SIZE_4K,
+		   page ? "2M" : "4K");
+	  row.samples = test_reps;
+	  row.avg = sweep_latency[2 * step + page];
+	  report_record(&row);
+	}
+      if (first_miss == sweep_steps && small - huge > TLB_DELTA_MIN)
+	{
+	  first_miss = step;
+	}
+    }
+
+  if (first_miss == sweep_steps)
+    {
+      PRINT(" No TLB cost above %.0f cycles: the 4K TLB covers %zu pages", TLB_DELTA_MIN,
+	    test_mem_size / PAGE_SIZE_4K);
+      return;
+    }
+  const uint32_t last = sweep_steps - 1;
+  PRINT(" First-level TLB reach exceeded at %zu pages : %8.1f cycles per load",
+	sweep_mem_size(first_miss) / PAGE_SIZE_4K, sweep_latency[2 * first_miss] - sweep_latency[2 * first_miss + 1]);
+  PRINT(" TLB miss and page walk at %zu pages    : %8.1f cycles per load",
+	sweep_mem_size(last) / PAGE_SIZE_4K, sweep_latency[2 * last] - sweep_latency[2 * last + 1]);
+}
+
+static void
+sweep_mem_report()
+{
+  size_t cache_sizes[4] = { 0 };
+  sweep_cache_sizes(cache_sizes);
+
+  double* lat = (double*) calloc(sweep_steps, sizeof(double));
+  assert(lat != NULL);
+
+  PRINT(" ** Results from %u cores: latency per dependent load vs working-set size (%u reps of %d loads)",
+	test_cores, test_reps, SWEEP_LOADS);
+  uint32_t step, c;
+  for (step = 0; step < sweep_steps; step++)
+    {
+      for (c = 0; c < test_cores; c++)
+	{
+	  lat[step] += sweep_latency[step * test_cores + c];
+
+	  report_row_t row;
+	  report_row_init(&row, c, 0);
+	  snprintf(row.step, sizeof(row.step), "%zu KiB", sweep_mem_size(step) / 1024);
+	  row.samples = test_reps;
+	  row.avg = sweep_latency[step * test_cores + c];
+	  report_record(&row);
+	}
+      lat[step] /= test_cores;
+    }
+
+  /* a plateau ends at the first point SWEEP_PLATEAU_JUMP above its first point; */
+  /* the next one starts once two consecutive points are within SWEEP_PLATEAU_FLAT */
+  uint32_t start = 0, plateau = 0;
+  while (start < sweep_steps)
+    {
+      uint32_t end = start;
+      while (end + 1 < sweep_steps && lat[end + 1] <= lat[start] * SWEEP_PLATEAU_JUMP)
+	{
+	  end++;
+	}
+
+      size_t last = sweep_mem_size(end);
+      const char* level = "DRAM";
+      uint32_t l;
+      for (l = 3; l >= 1; l--)
+	{
+	  if (cache_sizes[l] != 0 && last <= cache_sizes[l])
+	    {
+	      level = (l == 1) ? "L1" : ((l == 2) ? "L2" : "L3");
+	    }
+	}
+
+      double avg = 0;
+      for (l = start; l <= end; l++)
+	{
+	  avg += lat[l];
+	}
+      avg /= (end - start + 1);
+      PRINT(" Plateau %u : %10zu - %10zu KiB : %8.1f cycles (%s)",
+	    ++plateau, sweep_mem_size(start) / 1024, last / 1024, avg, level);
+
+      uint32_t next = end + 1;
+      while (next + 1 < sweep_steps && lat[next + 1] > lat[next] * SWEEP_PLATEAU_FLAT)
+	{
+	  next++;
+	}
+      if (next < sweep_steps)
+	{
+	  PRINT(" Inflection: %10zu -> %10zu KiB : %8.1f -> %8.1f cycles",
+		last / 1024, sweep_mem_size(next) / 1024, lat[end], lat[next]);
+	}
+      start = next;
+    }
+
+  for (step = 1; step <= 3; step++)
+    {
+      if (cache_sizes[step] != 0)
+	{
+	  PRINT(" sysfs L%u : %zu KiB", step, cache_sizes[step] / 1024);
+	}
+    }
+  free(lat);
+}
+
+static uint32_t
+litmus_threads(moesi_type_t test)
+{
+  switch (test)
+    {
+    case LITMUS_SB:
+    case LITMUS_MP:
+    case LITMUS_LB:
+      return 2;
+    case LITMUS_IRIW:
+      return 4;
+    default:
+      return 0;
+    }
+}
+
+/* the fence between the two accesses of a litmus thread: --fence selects it */
+/* after a store (sfence / mfence) and after a load (lfence / mfence) */
+static inline void
+litmus_store_fence()
+{
+  if (test_sfence == 1)
+    {
+      _mm_sfence();
+    }
+  else if (test_sfence == 2)
+    {
+      _mm_mfence();
+    }
+}
+
+static inline void
+litmus_load_fence()
+{
+  if (test_lfence == 1)
+    {
+      _mm_lfence();
+    }
+  else if (test_lfence == 2)
+    {
+      _mm_mfence();
+    }
+}
+
+/* one iteration of a litmus test on x (line 0) and y (line TP_LINE_SPACING); */
+/* store 0 keeps the time of the thread's instructions including the fence. */
+/* After barrier 1, core 0 records the outcome and resets x and y */
+static void
+litmus_run(volatile cache_line_t* cache_line, volatile uint64_t reps)
+{
+  volatile uint32_t* x = &cache_line->word[0];
+  volatile uint32_t* y = &(cache_line + TP_LINE_SPACING)->word[0];
+  volatile uint32_t* r = (ID < 4) ? litmus_regs[ID] : NULL;
+
+  /* the threads leave barrier 0 far more skewed than the window of a reordering. */
+  /* As in litmus7, they rendezvous on a go flag and then wait a random number of */
+  /* PAUSEs, so that the accesses of the threads overlap in some iterations */
+  litmus_iter++;
+  if (ID == 0)
+    {
+      litmus_go = litmus_iter;
+    }
+  else
+    {
+      while (litmus_go != litmus_iter)
+	{
+	  PAUSE();
+	}
+    }
+  uint32_t delay = my_random(seeds, seeds + 1, seeds + 2) % LITMUS_MAX_DELAY;
+  while (delay-- > 0)
+    {
+      PAUSE();
+    }
+
+  switch (test_test)
+    {
+    case LITMUS_SB:		/* x = 1; r0 = y || y = 1; r0 = x */
+      if (ID < 2)
+	{
+	  volatile uint32_t* mine = ID ? y : x;
+	  volatile uint32_t* other = ID ? x : y;
+	  PFDI(0);
+	  *mine = 1;
+	  litmus_store_fence();
+	  r[0] = *other;
+	  PFDO(0, reps);
+	}
+      break;
+    case LITMUS_MP:		/* x = 1; y = 1 || r0 = y; r1 = x */
+      if (ID == 0)
+	{
+	  PFDI(0);
+	  *x = 1;
+	  litmus_store_fence();
+	  *y = 1;
+	  PFDO(0, reps);
+	}
+      else if (ID == 1)
+	{
+	  PFDI(0);
+	  r[0] = *y;
+	  litmus_load_fence();
+	  r[1] = *x;
+	  PFDO(0, reps);
+	}
+      break;
+    case LITMUS_LB:		/* r0 = x; y = 1 || r0 = y; x = 1 */
+      if (ID < 2)
+	{
+	  volatile uint32_t* mine = ID ? x : y;
+	  volatile uint32_t* other = ID ? y : x;
+	  PFDI(0);
+	  r[0] = *other;
+	  litmus_load_fence();
+	  *mine = 1;
+	  PFDO(0, reps);
+	}
+      break;
+    case LITMUS_IRIW:		/* x = 1 || y = 1 || r0 = x; r1 = y || r0 = y; r1 = x */
+      if (ID < 2)
+	{
+	  PFDI(0);
+	  *(ID ? y : x) = 1;
+	  PFDO(0, reps);
+	}
+      else if (ID < 4)
+	{
+	  volatile uint32_t* first = (ID == 2) ? x : y;
+	  volatile uint32_t* second = (ID == 2) ? y : x;
+	  PFDI(0);
+	  r[0] = *first;
+	  litmus_load_fence();
+	  r[1] = *second;
+	  PFDO(0, reps);
+	}
+      break;
+    default:
+      break;
+    }
+
+  B1;				/* BARRIER 1 */
+
+  if (ID == 0)
+    {
+      uint32_t outcome;
+      switch (test_test)
+	{
+	case LITMUS_SB:
+	case LITMUS_LB:
+	  outcome = litmus_regs[0][0] | (litmus_regs[1][0] << 1);
+	  break;
+	case LITMUS_MP:
+	  outcome = litmus_regs[1][0] | (litmus_regs[1][1] << 1);
+	  break;
+	default:
+	  outcome = litmus_regs[2][0] | (litmus_regs[2][1] << 1)
+	    | (litmus_regs[3][0] << 2) | (litmus_regs[3][1] << 3);
+	  break;
+	}
+      litmus_counts[outcome & 0xF]++;
+      *x = 0;
+      *y = 0;
+      _mm_mfence();
+    }
+}
+
+static void
+litmus_report()
+{
+  const char* regs;
+  uint32_t forbidden, num_outcomes = 4;
+  switch (test_test)
+    {
+    case LITMUS_SB:
+      regs = "core 0 r0 = y, core 1 r0 = x";
+      forbidden = 0;		/* both 0 */
+      break;
+    case LITMUS_MP:
+      regs = "core 1 r0 = y, core 1 r1 = x";
+      forbidden = 1;		/* y = 1, x = 0 */
+      break;
+    case LITMUS_LB:
+      regs = "core 0 r0 = x, core 1 r0 = y";
+      forbidden = 3;		/* both 1 */
+      break;
+    default:
+      regs = "core 2 r0 = x, core 2 r1 = y, core 3 r0 = y, core 3 r1 = x";
+      forbidden = 5;		/* 1 0 1 0: the readers disagree on the order of the writes */
+      num_outcomes = 16;
+      break;
+    }
+
+  const char* fence_des[] = { "none", "sfence", "mfence" };
+  const char* lfence_des[] = { "none", "lfence", "mfence" };
+  PRINT(" ** Results from %u cores: %s, %u iterations, fence after store: %s / after load: %s",
+	litmus_threads(test_test), moesi_type_des[test_test], test_reps,
+	fence_des[test_sfence <= 2 ? test_sfence : 0], lfence_des[test_lfence <= 2 ? test_lfence : 0]);
+  PRINT(" Outcome (%s) :", regs);
+
+  uint32_t o;
+  for (o = 0; o < num_outcomes; o++)
+    {
+      if (litmus_counts[o] == 0 && o != forbidden)
+	{
+	  continue;
+	}
+      if (num_outcomes == 4)
+	{
+	  PRINT("   %u %u : %12llu (%7.3f%%)%s", o & 1, (o >> 1) & 1, (LLU) litmus_counts[o],
+		100.0 * litmus_counts[o] / test_reps, (o == forbidden) ? " <- forbidden under SC" : "");
+	}
+      else
+	{
+	  PRINT("   %u %u %u %u : %12llu (%7.3f%%)%s", o & 1, (o >> 1) & 1, (o >> 2) & 1, (o >> 3) & 1,
+		(LLU) litmus_counts[o], 100.0 * litmus_counts[o] / test_reps,
+		(o == forbidden) ? " <- forbidden under SC" : "");
+	}
+    }
+  PRINT(" Forbidden outcome observed %llu times; per-core stores above are the cost of the sequence with the fence",
+	(LLU) litmus_counts[forbidden]);
+  if (test_test == LITMUS_SB)
+    {
+      /* x86-TSO keeps MP, LB and IRIW forbidden without fences; SB needs an mfence, i.e. one of
+	 the set_fence levels that set test_sfence = 2 */
+      PRINT(" x86-TSO %s SB with this fence: only mfence (--fence 2, 6 or 8) orders a store before a later load%s",
+	    (test_sfence == 2) ? "forbids" : "allows",
+	    (test_sfence == 1) ? "; sfence orders stores only" : "");
+    }
+}
+
+/* --width / --offset: the operand of the CAS, FAI, TAS and SWAP events. The */
+/* width is dispatched outside of the timed region of every operation */
+static inline uint32_t
+ao_native_width()
+{
+  return (test_test == TAS || test_test == TAS_ON_MODIFIED || test_test == TAS_ON_SHARED) ? 8 : 32;
+}
+
+static inline uint32_t
+ao_width(uint32_t native)
+{
+  return (test_width == DEFAULT_WIDTH) ? native : test_width;
+}
+
+static inline volatile uint8_t*
+ao_target(volatile cache_line_t* cl)
+{
+  return (volatile uint8_t*) cl + test_offset;
+}
+
+static inline void
+ao_set(volatile cache_line_t* cl, uint32_t ones)
+{
+  if (test_width == DEFAULT_WIDTH && test_offset == DEFAULT_OFFSET)
+    {
+      cl->word[0] = ones ? 0xFFFFFFFF : 0;
+      return;
+    }
+
+  volatile uint8_t* b = ao_target(cl);
+  uint32_t i;
+  for (i = 0; i < ao_width(ao_native_width()) / 8; i++)
+    {
+      b[i] = ones ? 0xFF : 0;
+    }
+}
+
+static inline uint64_t
+ao_cas(volatile uint8_t* a, uint64_t o, uint64_t n, volatile uint64_t reps, uint32_t timed)
+{
+  uint64_t r;
+  if (!timed)
+    {
+      switch (ao_width(32))
+	{
+	case 8:
+	  return CAS_U8(a, (uint8_t) o, (uint8_t) n);
+	case 16:
+	  return CAS_U16((volatile uint16_t*) a, (uint16_t) o, (uint16_t) n);
+	case 64:
+	  return CAS_U64((volatile uint64_t*) a, o, n);
+#if defined(CAS_U128)
+	case 128:
+	  return (uint64_t) CAS_U128((volatile unsigned __int128*) a, o, n);
+#endif
+	default:
+	  return CAS_U32((volatile uint32_t*) a, (uint32_t) o, (uint32_t) n);
+	}
+    }
+
+  switch (ao_width(32))
+    {
+    case 8:
+      PFDI(0);
+      r = CAS_U8(a, (uint8_t) o, (uint8_t) n);
+      PFDO(0, reps);
+      break;
+    case 16:
+      PFDI(0);
+      r = CAS_U16((volatile uint16_t*) a, (uint16_t) o, (uint16_t) n);
+      PFDO(0, reps);
+      break;
+    case 64:
+      PFDI(0);
+      r = CAS_U64((volatile uint64_t*) a, o, n);
+      PFDO(0, reps);
+      break;
+#if defined(CAS_U128)
+    case 128:
+      PFDI(0);
+      r = (uint64_t) CAS_U128((volatile unsigned __int128*) a, o, n);
+      PFDO(0, reps);
+      break;
+#endif
+    default:
+      PFDI(0);
+      r = CAS_U32((volatile uint32_t*) a, (uint32_t) o, (uint32_t) n);
+      PFDO(0, reps);
+      break;
+    }
+  return r;
+}
+
+#if defined(CAS_U128)
+/* FAI, SWAP and TAS of 128 bits: load, then cmpxchg16b until it succeeds */
+static inline unsigned __int128
+ao_rmw_u128(volatile uint8_t* a, unsigned __int128 add, unsigned __int128 set, uint32_t is_set)
+{
+  volatile unsigned __int128* w = (volatile unsigned __int128*) a;
+  unsigned __int128 o = *w, cur;
+  while ((cur = CAS_U128(w, o, is_set ? set : o + add)) != o)
+    {
+      o = cur;
+    }
+  return o;
+}
+#endif
+
+static inline uint64_t
+ao_fai(volatile uint8_t* a, volatile uint64_t reps)
+{
+  uint64_t r;
+  switch (ao_width(32))
+    {
+    case 8:
+      PFDI(0);
+      r = FAI_U8(a);
+      PFDO(0, reps);
+      break;
+    case 16:
+      PFDI(0);
+      r = FAI_U16((volatile uint16_t*) a);
+      PFDO(0, reps);
+      break;
+    case 64:
+      PFDI(0);
+      r = FAI_U64((volatile uint64_t*) a);
+      PFDO(0, reps);
+      break;
+#if defined(CAS_U128)
+    case 128:
+      PFDI(0);
+      r = (uint64_t) ao_rmw_u128(a, 1, 0, 0);
+      PFDO(0, reps);
+      break;
+#endif
+    default:
+      PFDI(0);
+      r = FAI_U32((volatile uint32_t*) a);
+      PFDO(0, reps);
+      break;
+    }
+  return r;
+}
+
+static inline uint64_t
+ao_swap(volatile uint8_t* a, uint64_t v, volatile uint64_t reps)
+{
+  uint64_t r;
+  switch (ao_width(32))
+    {
+    case 8:
+      PFDI(0);
+      r = SWAP_U8(a, (uint8_t) v);
+      PFDO(0, reps);
+      break;
+    case 16:
+      PFDI(0);
+      r = SWAP_U16((volatile uint16_t*) a, (uint16_t) v);
+      PFDO(0, reps);
+      break;
+    case 64:
+      PFDI(0);
+      r = SWAP_U64((volatile uint64_t*) a, v);
+      PFDO(0, reps);
+      break;
+#if defined(CAS_U128)
+    case 128:
+      PFDI(0);
+      r = (uint64_t) ao_rmw_u128(a, 0, v, 1);
+      PFDO(0, reps);
+      break;
+#endif
+    default:
+      PFDI(0);
+      r = SWAP_U32((volatile uint32_t*) a, (uint32_t) v);
+      PFDO(0, reps);
+      break;
+    }
+  return r;
+}
+
+/* test-and-set: TAS_U8 on the default width, otherwise a swap of all ones; */
+/* returns 1 if the operand was not set before */
+static inline uint8_t
+ao_tas(volatile uint8_t* a, volatile uint64_t reps)
+{
+  uint64_t r;
+  switch (ao_width(8))
+    {
+    case 16:
+      PFDI(0);
+      r = SWAP_U16((volatile uint16_t*) a, 0xFFFF);
+      PFDO(0, reps);
+      return (r != 0xFFFF);
+    case 32:
+      PFDI(0);
+      r = SWAP_U32((volatile uint32_t*) a, 0xFFFFFFFF);
+      PFDO(0, reps);
+      return (r != 0xFFFFFFFF);
+    case 64:
+      PFDI(0);
+      r = SWAP_U64((volatile uint64_t*) a, ~0ULL);
+      PFDO(0, reps);
+      return (r != ~0ULL);
+#if defined(CAS_U128)
+    case 128:
+      {
+	unsigned __int128 ones = ~(unsigned __int128) 0, r128;
+	PFDI(0);
+	r128 = ao_rmw_u128(a, 0, ones, 1);
+	PFDO(0, reps);
+	return (r128 != ones);
+      }
+#endif
+    default:
+      {
+#if defined(TILERA)
+	volatile uint32_t* b = (volatile uint32_t*) a;
+#else
+	volatile uint8_t* b = a;
+#endif
+	PFDI(0);
+	r = TAS_U8(b);
+	PFDO(0, reps);
+	return (r != 255);
+      }
+    }
+}
+
+/* links the n lines at lines into test_chains disjoint random cycles of n / test_chains */
+/* lines each (a random permutation cut into pieces); heads gets one line of every cycle */
+static void
+mlp_create_chains(volatile cache_line_t* lines, size_t n, volatile uint64_t** heads)
+{
+  size_t* perm = (size_t*) malloc(n * sizeof(size_t));
+  assert(perm != NULL);
+
+  unsigned long* s = seed_rand();
+  s[0] ^= ID;
+
+  size_t i;
+  for (i = 0; i < n; i++)
+    {
+      perm[i] = i;
+    }
+  for (i = n - 1; i > 0; i--)
+    {
+      size_t j = my_random(s, s+1, s+2) % (i + 1);
+      size_t tmp = perm[i];
+      perm[i] = perm[j];
+      perm[j] = tmp;
+    }
+
+  const size_t len = n / test_chains;
+  uint32_t c;
+  for (c = 0; c < test_chains; c++)
+    {
+      size_t* piece = perm + c * len;
+      for (i = 0; i < len; i++)
+	{
+	  *(volatile uint64_t*) &lines[piece[i]] = (uint64_t) &lines[piece[(i + 1) % len]];
+	}
+      heads[c] = (volatile uint64_t*) &lines[piece[0]];
+    }
+
+  free(s);
+  free(perm);
+}
+
+/* steps dependent loads on each of the first m chains, interleaved so that */
+/* the m loads of a step are independent of each other */
+static inline void
+mlp_chase(volatile uint64_t** p, const uint32_t m, const size_t steps)
+{
+  size_t i;
+  uint32_t c;
+  for (i = 0; i < steps; i++)
+    {
+      for (c = 0; c < m; c++)
+	{
+	  p[c] = (volatile uint64_t*) *p[c];
+	}
+    }
+}
+
+/* every core chases its own slice; all cores run the same number of chains at */
+/* the same time, so several cores show how the memory-level parallelism degrades */
+static uint64_t
+mlp_run(volatile cache_line_t* cache_line)
+{
+  const size_t n = (test_mem_size / test_cores) / sizeof(cache_line_t);
+  volatile cache_line_t* slice = cache_line + ID * n;
+  volatile uint64_t* p[MLP_MAX_CHAINS];
 
-	default:
-	  break;
+  mlp_create_chains(slice, n, p);
+  const size_t len = n / test_chains;
+  mlp_chase(p, test_chains, (len < SWEEP_WARMUP_LOADS) ? len : SWEEP_WARMUP_LOADS);
+
+  uint32_t m;
+  for (m = 1; m <= test_chains; m++)
+    {
+      B1;
+      uint64_t total = 0;
+      uint32_t r;
+      for (r = 0; r < test_reps; r++)
+	{
+	  ticks start = getticks();
+	  mlp_chase(p, m, MLP_STEPS);
+	  total += getticks() - start - pfd_correction;
 	}
+      mlp_latency[(m - 1) * test_cores + ID] = (double) total / ((double) test_reps * MLP_STEPS * m);
+      B2;
     }
 
-  B0;
-
+  uint64_t sum = 0;
+  for (m = 0; m < test_chains; m++)
+    {
+      sum += (uint64_t) p[m];
+    }
+  return sum;
+}
 
-  if (ID < test_cores)
+static void
+mlp_report()
+{
+  const size_t slice = test_mem_size / test_cores;
+  double* lat = (double*) calloc(test_chains, sizeof(double));
+  assert(lat != NULL);
+
+  PRINT(" ** Results from %u cores: effective cycles per access with m interleaved chains over %zu KiB per core",
+	test_cores, slice / 1024);
+  double best = 0;
+  uint32_t m, c;
+  for (m = 1; m <= test_chains; m++)
     {
-      PRINT(" value of cl is %-10u / sum is %llu", cache_line->word[0], (LLU) sum);
+      double lo = 0, hi = 0;
+      for (c = 0; c < test_cores; c++)
+	{
+	  double v = mlp_latency[(m - 1) * test_cores + c];
+	  lat[m - 1] += v;
+	  lo = (c == 0 || v < lo) ? v : lo;
+	  hi = (c == 0 || v > hi) ? v : hi;
+	}
+      lat[m - 1] /= test_cores;
+      best = (m == 1 || lat[m - 1] < best) ? lat[m - 1] : best;
+      for (c = 0; c < test_cores; c++)
+	{
+	  report_row_t row;
+	  report_row_init(&row, c, 0);
+	  snprintf(row.step, sizeof(row.step), "%u chains", m);
+	  row.samples = test_reps;
+	  row.avg = mlp_latency[(m - 1) * test_cores + c];
+	  report_record(&row);
+	}
+      if (test_cores > 1)
+	{
+	  PRINT(" Chains %2u : %8.2f cycles per access | speedup %5.2fx | cores min %8.2f max %8.2f",
+		m, lat[m - 1], lat[0] / lat[m - 1], lo, hi);
+	}
+      else
+	{
+	  PRINT(" Chains %2u : %8.2f cycles per access | speedup %5.2fx", m, lat[m - 1], lat[0] / lat[m - 1]);
+	}
     }
-  cache_line_close(ID, "cache_line");
-  barriers_term(ID);
 
+  uint32_t knee = test_chains;
+  for (m = 1; m <= test_chains; m++)
+    {
+      if (lat[m - 1] <= best * MLP_KNEE)
+	{
+	  knee = m;
+	  break;
+	}
+    }
+  PRINT(" Knee : %u chains (%8.2f cycles per access, %5.2fx of one chain)",
+	knee, lat[knee - 1], lat[0] / lat[knee - 1]);
+  if (knee == test_chains && test_chains < MLP_MAX_CHAINS)
+    {
+      PRINT(" Knee is the last point: run with a larger --chains");
+    }
+  else if (knee < test_chains)
+    {
+      PRINT(" More than %u chains do not help (fill-buffer limit)", knee);
+    }
+  free(lat);
 }
 
-
 uint32_t
 cas(volatile cache_line_t* cl, volatile uint64_t reps)
 {
   uint8_t o = reps & 0x1;
   uint8_t no = !o; 
-  volatile uint32_t r;
+  volatile uint64_t r;
 
-  PFDI(0);
-  r = CAS_U32(cl->word, o, no);
-  PFDO(0, reps);
+  r = ao_cas(ao_target(cl), o, no, reps, 1);
 
   return (r == o);
 }
@@ -1773,8 +6796,8 @@ cas_no_pf(volatile cache_line_t* cl, volatile uint64_t reps)
 {
   uint8_t o = reps & 0x1;
   uint8_t no = !o; 
-  volatile uint32_t r;
-  r = CAS_U32(cl->word, o, no);
+  volatile uint64_t r;
+  r = ao_cas(ao_target(cl), o, no, reps, 0);
 
   return (r == o);
 }
@@ -1784,16 +6807,14 @@ cas_0_eventually(volatile cache_line_t* cl, volatile uint64_t reps)
 {
   uint8_t o = reps & 0x1;
   uint8_t no = !o; 
-  volatile uint32_t r;
+  volatile uint64_t r;
 
   uint32_t cln = 0;
   do
     {
       cln = clrand();
       volatile cache_line_t* cl1 = cl + cln;
-      PFDI(0);
-      r = CAS_U32(cl1->word, o, no);
-      PFDO(0, reps);
+      r = ao_cas(ao_target(cl1), o, no, reps, 1);
     }
   while (cln > 0);
 
@@ -1810,9 +6831,7 @@ fai(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile cache_line_t* cl1 = cl + cln;
-      PFDI(0);
-      t = FAI_U32(cl1->word);
-      PFDO(0, reps);
+      t = ao_fai(ao_target(cl1), reps);
     }
   while (cln > 0);
 
@@ -1829,19 +6848,11 @@ tas(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile cache_line_t* cl1 = cl + cln;
-#if defined(TILERA)
-      volatile uint32_t* b = (volatile uint32_t*) cl1->word;
-#else
-      volatile uint8_t* b = (volatile uint8_t*) cl1->word;
-#endif
-
-      PFDI(0);
-      r = TAS_U8(b);
-      PFDO(0, reps);
+      r = ao_tas(ao_target(cl1), reps);
     }
   while (cln > 0);
 
-  return (r != 255);
+  return r;
 }
 
 uint32_t
@@ -1854,9 +6865,7 @@ swap(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile cache_line_t* cl1 = cl + cln;
-      PFDI(0);
-      res = SWAP_U32(cl1->word, ID);
-      PFDO(0, reps);
+      res = ao_swap(ao_target(cl1), ID, reps);
     }
   while (cln > 0);
 
@@ -1864,6 +6873,140 @@ swap(volatile cache_line_t* cl, volatile uint64_t reps)
   return res;
 }
 
+/* --hint: issued on the line of the next timed access, outside of the timed region */
+static inline void
+hint_before(volatile uint32_t* w)
+{
+  if (test_hint == HINT_PREFETCHT0)
+    {
+      PREFETCHT0(w);
+      wait_cycles(test_hint_distance);
+    }
+  else if (test_hint == HINT_PREFETCHW)
+    {
+      PREFETCHW(w);
+      wait_cycles(test_hint_distance);
+    }
+}
+
+static inline void
+hint_after_store(volatile uint32_t* w)
+{
+  if (test_hint == HINT_CLDEMOTE)
+    {
+      CLDEMOTE(w);
+    }
+}
+
+static inline void
+flush_line(volatile void* p)
+{
+  switch (test_flush_insn)
+    {
+    case FLUSH_CLFLUSHOPT:
+      CLFLUSHOPT(p);
+      break;
+    case FLUSH_CLWB:		/* clwb can leave the line cached: --flush must reach I */
+    default:
+      _mm_clflush((void*) p);
+      break;
+    }
+}
+
+#if defined(__x86_64__)
+/* --store-kind: full-line stores of v; store 0 times the stores and store 1 the */
+/* sfence that drains them (the write-combining buffers for the streaming ones) */
+__attribute__((target("avx"))) static void
+store_line_avx(volatile cache_line_t* cl, uint32_t v, volatile uint64_t reps)
+{
+  __m256i x = _mm256_set1_epi32(v);
+  __m256i* p = (__m256i*) cl;
+  PFDI(0);
+  _mm256_store_si256(p, x);
+  _mm256_store_si256(p + 1, x);
+  PFDO(0, reps);
+}
+
+__attribute__((target("avx512f"))) static void
+store_line_avx512(volatile cache_line_t* cl, uint32_t v, volatile uint64_t reps)
+{
+  __m512i x = _mm512_set1_epi32(v);
+  PFDI(0);
+  _mm512_store_si512((void*) cl, x);
+  PFDO(0, reps);
+}
+
+static void
+store_line_movnti(volatile cache_line_t* cl, uint32_t v, volatile uint64_t reps)
+{
+  long long* p = (long long*) cl;
+  PFDI(0);
+  _mm_stream_si64(p + 0, v);
+  _mm_stream_si64(p + 1, v);
+  _mm_stream_si64(p + 2, v);
+  _mm_stream_si64(p + 3, v);
+  _mm_stream_si64(p + 4, v);
+  _mm_stream_si64(p + 5, v);
+  _mm_stream_si64(p + 6, v);
+  _mm_stream_si64(p + 7, v);
+  PFDO(0, reps);
+}
+
+static void
+store_line_movntdq(volatile cache_line_t* cl, uint32_t v, volatile uint64_t reps)
+{
+  __m128i x = _mm_set1_epi32(v);
+  __m128i* p = (__m128i*) cl;
+  PFDI(0);
+  _mm_stream_si128(p + 0, x);
+  _mm_stream_si128(p + 1, x);
+  _mm_stream_si128(p + 2, x);
+  _mm_stream_si128(p + 3, x);
+  PFDO(0, reps);
+}
+#endif	/* __x86_64__ */
+
+static void
+store_line(volatile cache_line_t* cl, uint32_t v, volatile uint64_t reps)
+{
+#if defined(__x86_64__)
+  switch (test_store_kind)
+    {
+    case STORE_AVX:
+      store_line_avx(cl, v, reps);
+      break;
+    case STORE_AVX512:
+      store_line_avx512(cl, v, reps);
+      break;
+    case STORE_MOVNTI:
+      store_line_movnti(cl, v, reps);
+      break;
+    default:
+      store_line_movntdq(cl, v, reps);
+      break;
+    }
+#endif
+  PFDI(1);
+  _mm_sfence();
+  PFDO(1, reps);
+  store_line_used = 1;
+}
+
+static void
+store_0_eventually_line(volatile cache_line_t* cl, volatile uint64_t reps)
+{
+  volatile uint32_t cln = 0;
+  do
+    {
+      cln = clrand();
+      volatile uint32_t *w = &cl[cln].word[0];
+      hint_before(w);
+      store_line(cl + cln, cln, reps);
+      hint_after_store(w);
+    }
+  while (cln > 0);
+}
+
 void
 store_0(volatile cache_line_t* cl, volatile uint64_t reps)
 {
@@ -1911,10 +7054,12 @@ store_0_eventually_sf(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile uint32_t *w = &cl[cln].word[0];
+      hint_before(w);
       PFDI(0);
       w[0] = cln;
       _mm_sfence();
       PFDO(0, reps);
+      hint_after_store(w);
     }
   while (cln > 0);
 }
@@ -1927,10 +7072,12 @@ store_0_eventually_mf(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile uint32_t *w = &cl[cln].word[0];
+      hint_before(w);
       PFDI(0);
       w[0] = cln;
       _mm_mfence();
       PFDO(0, reps);
+      hint_after_store(w);
     }
   while (cln > 0);
 }
@@ -1943,9 +7090,11 @@ store_0_eventually_nf(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile uint32_t *w = &cl[cln].word[0];
+      hint_before(w);
       PFDI(0);
       w[0] = cln;
       PFDO(0, reps);
+      hint_after_store(w);
     }
   while (cln > 0);
 }
@@ -1958,10 +7107,12 @@ store_0_eventually_dw(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile uint32_t *w = &cl[cln].word[0];
+      hint_before(w);
       PFDI(0);
       w[0] = cln;
       w[16] = cln;
       PFDO(0, reps);
+      hint_after_store(w);
     }
   while (cln > 0);
 }
@@ -1988,6 +7139,34 @@ store_0_eventually(volatile cache_line_t* cl, volatile uint64_t reps)
   /* _mm_mfence(); */
 }
 
+/* --store-kind: only the timed store of the STORE_ON_* events writes the full line; */
+/* the stores that prepare a state stay word stores (a streaming store evicts the line) */
+static void
+store_0_kind(volatile cache_line_t* cl, volatile uint64_t reps)
+{
+  if (test_store_kind != STORE_WORD)
+    {
+      store_line(cl, reps, reps);
+    }
+  else
+    {
+      store_0(cl, reps);
+    }
+}
+
+static void
+store_0_eventually_kind(volatile cache_line_t* cl, volatile uint64_t reps)
+{
+  if (test_store_kind != STORE_WORD)
+    {
+      store_0_eventually_line(cl, reps);
+    }
+  else
+    {
+      store_0_eventually(cl, reps);
+    }
+}
+
 
 static void
 store_0_eventually_pfd1_sf(volatile cache_line_t* cl, volatile uint64_t reps)
@@ -2064,6 +7243,7 @@ load_0_eventually_lf(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile uint32_t* w = &cl[cln].word[0];
+      hint_before(w);
       PFDI(0);
       val = w[0];
       _mm_lfence();
@@ -2083,6 +7263,7 @@ load_0_eventually_mf(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile uint32_t* w = &cl[cln].word[0];
+      hint_before(w);
       PFDI(0);
       val = w[0];
       _mm_mfence();
@@ -2102,6 +7283,7 @@ load_0_eventually_nf(volatile cache_line_t* cl, volatile uint64_t reps)
     {
       cln = clrand();
       volatile uint32_t* w = &cl[cln].word[0];
+      hint_before(w);
       PFDI(0);
       val = w[0];
       PFDO(0, reps);
@@ -2207,7 +7389,7 @@ load_0(volatile cache_line_t* cl, volatile uint64_t reps)
 static uint64_t
 load_next_lf(volatile uint64_t* cl, volatile uint64_t reps)
 {
-  const size_t do_reps = test_cache_line_num;
+  const size_t do_reps = test_chase_loads;
   PFDI(0);
   int i;
   for (i = 0; i < do_reps; i++)
@@ -2223,7 +7405,7 @@ load_next_lf(volatile uint64_t* cl, volatile uint64_t reps)
 static uint64_t
 load_next_mf(volatile uint64_t* cl, volatile uint64_t reps)
 {
-  const size_t do_reps = test_cache_line_num;
+  const size_t do_reps = test_chase_loads;
   PFDI(0);
   int i;
   for (i = 0; i < do_reps; i++)
@@ -2239,7 +7421,7 @@ load_next_mf(volatile uint64_t* cl, volatile uint64_t reps)
 static uint64_t
 load_next_nf(volatile uint64_t* cl, volatile uint64_t reps)
 {
-  const size_t do_reps = test_cache_line_num;
+  const size_t do_reps = test_chase_loads;
   PFDI(0);
   int i;
   for (i = 0; i < do_reps; i++)
@@ -2272,9 +7454,28 @@ load_next(volatile uint64_t* cl, volatile uint64_t reps)
 void
 invalidate(volatile cache_line_t* cl, uint64_t index, volatile uint64_t reps)
 {
-  PFDI(0);
-  _mm_clflush((void*) (cl + index));
-  PFDO(0, reps);
+  volatile cache_line_t* line = cl + index;
+  switch (test_flush_insn)
+    {
+    case FLUSH_CLFLUSHOPT:
+      PFDI(0);
+      CLFLUSHOPT(line);
+      PFDO(0, reps);
+      break;
+    case FLUSH_CLWB:
+      /* time the write-back; the untimed clflush then takes the line to I */
+      PFDI(0);
+      CLWB(line);
+      PFDO(0, reps);
+      _mm_mfence();
+      _mm_clflush((void*) line);
+      break;
+    default:
+      PFDI(0);
+      _mm_clflush((void*) line);
+      PFDO(0, reps);
+      break;
+    }
   _mm_mfence();
 }
 
@@ -2344,18 +7545,53 @@ parse_test_option(const char* arg)
   exit(EXIT_FAILURE);
 }
 
+/* a --hint, by name or index */
+static int
+parse_hint_option(const char* arg)
+{
+  errno = 0;
+  char* endptr = NULL;
+  long numeric = strtol(arg, &endptr, 10);
+  if (endptr != arg && *endptr == '\0' && errno == 0)
+    {
+      if (numeric < 0 || numeric >= HINT_NUM_TYPES)
+        {
+          fprintf(stderr, "error: hint %ld out of range (0-%d)\n", numeric, HINT_NUM_TYPES - 1);
+          exit(EXIT_FAILURE);
+        }
+      return (int) numeric;
+    }
+
+  int idx;
+  for (idx = 0; idx < HINT_NUM_TYPES; idx++)
+    {
+      if (strcasecmp(arg, hint_type_des[idx]) == 0)
+        {
+          return idx;
+        }
+    }
+
+  fprintf(stderr, "error: unknown hint '%s' (none, prefetcht0, prefetchw or cldemote)\n", arg);
+  exit(EXIT_FAILURE);
+}
+
 static void
 collect_core_stats(uint32_t store, uint32_t num_vals, uint32_t num_print)
 {
   abs_deviation_t stats;
-  pfd_collect_abs_deviation(store, num_vals, num_print, &stats);
-
-  if (core_summaries == NULL || (void*) core_summaries == MAP_FAILED)
+  const int keep = core_summaries != NULL && (void*) core_summaries != MAP_FAILED
+    && ID < test_cores && store < PFD_NUM_STORES;
+  if (keep)
     {
-      return;
+      /* before get_abs_deviation drops the values above its limit */
+      get_percentiles(pfd_store[store], num_vals, report_qs, core_summaries[ID].quantiles[store], REPORT_NUM_QS);
+      get_abs_deviation_all(pfd_store[store], num_vals, &core_summaries[ID].record[store]);
+      core_summaries[ID].correction = pfd_correction;
     }
 
-  if (ID < test_cores && store < PFD_NUM_STORES)
+  pfd_collect_abs_deviation(store, num_vals, num_print, &stats);
+
+  if (keep)
     {
       core_summaries[ID].store[store] = stats;
       core_summaries[ID].store_valid[store] = 1;
@@ -2365,7 +7601,8 @@ collect_core_stats(uint32_t store, uint32_t num_vals, uint32_t num_print)
 volatile cache_line_t*
 cache_line_open()
 {
-  uint64_t size = test_cache_line_num * sizeof(cache_line_t);
+  /* one spare line for the operands of --offset that cross the last line */
+  uint64_t size = (test_cache_line_num + 1) * sizeof(cache_line_t);
 
 #if defined(__tile__)
   tmc_alloc_t alloc = TMC_ALLOC_INIT;
@@ -2387,6 +7624,20 @@ cache_line_open()
   cache_line->word[0] = 0;
 
 #else	 /* !__tile__ ****************************************************************************************/
+  if (test_page_size != PAGE_SIZE_4K)
+    {
+      const char* how;
+      volatile cache_line_t* cache_line = (volatile cache_line_t*) huge_alloc(size, test_page_size, &how);
+      if (cache_line == NULL)
+	{
+	  fprintf(stderr, "error: cannot map %zu KiB pages (reserve them in /proc/sys/vm/nr_hugepages "
+		  "or /sys/kernel/mm/hugepages)\n", test_page_size / 1024);
+	  exit(1);
+	}
+      printf("* backing the buffer with %zu KiB pages (%s)\n", test_page_size / 1024, how);
+      return cache_line_init(cache_line, size);
+    }
+
   char keyF[100];
   sprintf(keyF, CACHE_LINE_MEM_FILE);
 
@@ -2424,6 +7675,12 @@ cache_line_open()
     }
 
 #endif  /* __tile ********************************************************************************************/
+  return cache_line_init(cache_line, size);
+}
+
+static volatile cache_line_t*
+cache_line_init(volatile cache_line_t* cache_line, uint64_t size)
+{
   memset((void*) cache_line, '1', size);
 
   if (ID == 0)
@@ -2431,13 +7688,14 @@ cache_line_open()
       uint32_t cl;
       for (cl = 0; cl < test_cache_line_num; cl++)
 	{
-	  cache_line[cl].word[0] = 0;
+	  ao_set(cache_line + cl, 0);
 	  _mm_clflush((void*) (cache_line + cl));
 	}
 
-      if (test_test == LOAD_FROM_MEM_SIZE)
+      if (test_test == LOAD_FROM_MEM_SIZE && !test_sweep_mem)
 	{
-	  create_rand_list_cl((volatile uint64_t*) cache_line, test_mem_size / sizeof(uint64_t));
+	  test_chase_loads = create_chain_cl(cache_line, test_mem_size, test_chain_mode, test_page_size,
+					     &chain_head);
 	}
 
 
@@ -2447,6 +7705,166 @@ cache_line_open()
   return cache_line;
 }
 
+/* maps size bytes (rounded up to page) of page-sized pages: hugetlbfs pages if */
+/* reserved, otherwise (2M only) transparent huge pages through madvise */
+static void*
+huge_alloc(size_t size, size_t page, const char** how)
+{
+  size = (size + page - 1) & ~(page - 1);
+  int huge = (page == PAGE_SIZE_1G) ? (30 << MAP_HUGE_SHIFT) : (21 << MAP_HUGE_SHIFT);
+  void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | huge, -1, 0);
+  if (mem != MAP_FAILED)
+    {
+      *how = "hugetlbfs";
+      return mem;
+    }
+  if (page != PAGE_SIZE_2M)
+    {
+      return NULL;
+    }
+
+  mem = mmap(NULL, size + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED)
+    {
+      return NULL;
+    }
+  void* aligned = (void*) (((uintptr_t) mem + page - 1) & ~(page - 1));
+  if (madvise(aligned, size, MADV_HUGEPAGE) != 0)
+    {
+      munmap(mem, size + page);
+      return NULL;
+    }
+  /* madvise is only a hint: fault the buffer in and check what the kernel backed it with */
+  memset(aligned, 0, size);
+  size_t backed = thp_backed_bytes(aligned, size);
+  if (backed < size)
+    {
+      fprintf(stderr, "warning: transparent huge pages back %zu of %zu KiB of the buffer "
+	      "(see /sys/kernel/mm/transparent_hugepage/enabled and defrag)\n", backed / 1024, size / 1024);
+      munmap(mem, size + page);
+      return NULL;
+    }
+  *how = "transparent huge pages";
+  return aligned;
+}
+
+/* bytes of [addr, addr + size) that /proc/self/smaps reports as AnonHugePages */
+static size_t
+thp_backed_bytes(void* addr, size_t size)
+{
+  FILE* f = fopen("/proc/self/smaps", "r");
+  if (f == NULL)
+    {
+      return 0;
+    }
+
+  const uintptr_t lo = (uintptr_t) addr, hi = lo + size;
+  uintptr_t start, end;
+  int inside = 0;
+  size_t backed = 0, kib;
+  char line[256];
+  while (fgets(line, sizeof(line), f) != NULL)
+    {
+      if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &start, &end) == 2)
+	{
+	  inside = (start < hi && end > lo);
+	}
+      else if (inside && sscanf(line, "AnonHugePages: %zu kB", &kib) == 1)
+	{
+	  backed += kib * 1024;
+	}
+    }
+  fclose(f);
+  return (backed < size) ? backed : size;
+}
+
+#define CHAIN_ORDER(base, i) (((volatile uint64_t*) &(base)[i])[1])
+
+/* links lines of the bytes at base into one cycle following mode over pages of */
+/* page bytes; returns the number of lines in the cycle and its first line in */
+/* *head. The visiting order is built in word 2-3 of the lines, then word 0-1 */
+/* of every line in the cycle get the pointer to the next one */
+static size_t
+create_chain_cl(volatile cache_line_t* base, size_t bytes, chain_mode_t mode, size_t page,
+		volatile uint64_t** head)
+{
+  if (mode == CHAIN_RANDOM)
+    {
+      create_rand_list_cl((volatile uint64_t*) base, bytes / sizeof(uint64_t));
+      *head = (volatile uint64_t*) base;
+      return bytes / sizeof(cache_line_t);
+    }
+
+  size_t lpp = page / sizeof(cache_line_t);
+  size_t pages = bytes / page;
+  if (pages == 0)
+    {
+      pages = 1;
+      lpp = bytes / sizeof(cache_line_t);
+    }
+
+  unsigned long* s = seed_rand();
+  s[0] = 0xB9E4E2F1F1E2E3D5L;
+  s[1] = 0xF1E2E3D5B9E4E2F1L;
+  s[2] = 0x9B3A0FA212342345L;
+
+  size_t n, i, j;
+  if (mode == CHAIN_IN_PAGE)
+    {
+      n = pages * lpp;
+      size_t p;
+      for (p = 0; p < pages; p++)
+	{
+	  volatile cache_line_t* pg = base + p * lpp;
+	  for (j = 0; j < lpp; j++)
+	    {
+	      CHAIN_ORDER(pg, j) = p * lpp + j;
+	    }
+	  for (j = lpp - 1; j > 0; j--)
+	    {
+	      size_t k = my_random(s, s+1, s+2) % (j + 1);
+	      uint64_t tmp = CHAIN_ORDER(pg, j);
+	      CHAIN_ORDER(pg, j) = CHAIN_ORDER(pg, k);
+	      CHAIN_ORDER(pg, k) = tmp;
+	    }
+	}
+    }
+  else
+    {
+      n = pages;
+      for (i = 0; i < pages; i++)
+	{
+	  CHAIN_ORDER(base, i) = i;
+	}
+      if (mode == CHAIN_PAGE_RANDOM)
+	{
+	  for (i = pages - 1; i > 0; i--)
+	    {
+	      size_t k = my_random(s, s+1, s+2) % (i + 1);
+	      uint64_t tmp = CHAIN_ORDER(base, i);
+	      CHAIN_ORDER(base, i) = CHAIN_ORDER(base, k);
+	      CHAIN_ORDER(base, k) = tmp;
+	    }
+	}
+      /* a random line of every page, so that the lines do not share cache sets */
+      for (i = 0; i < pages; i++)
+	{
+	  CHAIN_ORDER(base, i) = CHAIN_ORDER(base, i) * lpp + my_random(s, s+1, s+2) % lpp;
+	}
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      *(volatile uint64_t*) &base[CHAIN_ORDER(base, i)] = (uint64_t) &base[CHAIN_ORDER(base, (i + 1) % n)];
+    }
+  *head = (volatile uint64_t*) &base[CHAIN_ORDER(base, 0)];
+
+  free(s);
+  return n;
+}
+
+/* links the first n / 8 cache lines of list into one random cycle (Sattolo's */
+/* shuffle); word 0 of every line points to the next line */
 static void
 create_rand_list_cl(volatile uint64_t* list, size_t n)
 {
@@ -2458,30 +7876,27 @@ create_rand_list_cl(volatile uint64_t* list, size_t n)
   s[1] = 0xF1E2E3D5B9E4E2F1L;
   s[2] = 0x9B3A0FA212342345L;
 
-  uint8_t* used = calloc(n * per_cl, sizeof(uint8_t));
-  assert (used != NULL);
+  /* first the line indices, in place, then the pointers */
+  size_t i;
+  for (i = 0; i < n; i++)
+    {
+      list[i * per_cl] = i;
+    }
 
-  size_t idx = 0;
-  size_t used_num = 0;
-  while (used_num < n - 1)
+  for (i = n - 1; i > 0; i--)
     {
-      used[idx] = 1;
-      used_num++;
-      
-      size_t nxt;
-      do 
-	{
-	  nxt = (my_random(s, s+1, s+2) % n) * per_cl;
-	}
-      while (used[nxt]);
+      size_t j = my_random(s, s+1, s+2) % i;
+      uint64_t tmp = list[i * per_cl];
+      list[i * per_cl] = list[j * per_cl];
+      list[j * per_cl] = tmp;
+    }
 
-      list[idx] = (uint64_t) (list + nxt);
-      idx = nxt;
+  for (i = 0; i < n; i++)
+    {
+      list[i * per_cl] = (uint64_t) (list + list[i * per_cl] * per_cl);
     }
-  list[idx] = (uint64_t) (list); /* close the loop! */
 
   free(s);
-  free(used);
 } 
 
 void
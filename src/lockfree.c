@@ -0,0 +1,154 @@
+/*
+ *   File: lockfree.c
+ *   Description: allocation and initialization of the LOCKFREE event structures
+ *   lockfree.c is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "lockfree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+
+const char* lf_struct_des[] =
+  {
+    "TREIBER",
+    "TREIBER_TAGGED",
+    "MS_QUEUE",
+    "COUNTER",
+    "SHARDED_COUNTER",
+  };
+
+static void*
+lf_alloc(size_t size)
+{
+  void* mem = NULL;
+  if (posix_memalign(&mem, 64, size) != 0)
+    {
+      perror("posix_memalign");
+      exit(1);
+    }
+  memset(mem, 0, size);
+  return mem;
+}
+
+lf_t*
+lf_new(const lf_struct_t kind, const uint32_t num_threads)
+{
+  lf_t* lf = (lf_t*) lf_alloc(sizeof(lf_t));
+  lf->kind = kind;
+  lf->num_shards = num_threads;
+  lf->shards = (volatile uint64_t*) lf_alloc(num_threads * LF_SHARD_SPACING * sizeof(uint64_t));
+
+  /* one more node: the initial dummy of the queue */
+  size_t num_nodes = (size_t) num_threads * LF_NODES_PER_THREAD + 1;
+  lf->nodes = (lf_node_t*) lf_alloc(num_nodes * sizeof(lf_node_t));
+  lf_node_t* dummy = &lf->nodes[num_nodes - 1];
+  lf->head[0] = lf->tail[0] = (uint64_t) (uintptr_t) dummy;
+
+  return lf;
+}
+
+/* hands the thread its share of the nodes and pushes half of them, so that */
+/* the structure does not start empty */
+void
+lf_local_init(lf_t* lf, lf_local_t* local, const uint32_t id)
+{
+  memset(local, 0, sizeof(lf_local_t));
+  local->id = id;
+  if (lf->kind == LF_COUNTER || lf->kind == LF_SHARDED_COUNTER)
+    {
+      return;
+    }
+
+  uint32_t i;
+  for (i = 0; i < LF_NODES_PER_THREAD; i++)
+    {
+      lf_node_t* n = &lf->nodes[(size_t) id * LF_NODES_PER_THREAD + i];
+      n->free = local->free;
+      local->free = n;
+    }
+  for (i = 0; i < LF_NODES_PER_THREAD / 2; i++)
+    {
+      lf_update(lf, local, i);
+    }
+  local->cas = local->cas_failed = 0;
+}
+
+uint64_t
+lf_size(lf_t* lf, const uint64_t limit)
+{
+  lf_node_t* n;
+  switch (lf->kind)
+    {
+    case LF_TREIBER:
+    case LF_TREIBER_TAGGED:
+      n = (lf_node_t*) (uintptr_t) lf->top[0];
+      break;
+    case LF_MS_QUEUE:
+      n = ((lf_node_t*) (uintptr_t) lf->head[0])->next;
+      break;
+    default:
+      return 0;
+    }
+
+  uint64_t size = 0;
+  while (n != NULL && size < limit)
+    {
+      size++;
+      n = n->next;
+    }
+  return size;
+}
+
+int
+lf_parse_struct(const char* arg)
+{
+  char* endptr = NULL;
+  errno = 0;
+  long numeric = strtol(arg, &endptr, 10);
+  if (endptr != arg && *endptr == '\0' && errno == 0)
+    {
+      if (numeric < 0 || numeric >= LF_NUM_STRUCTS)
+	{
+	  fprintf(stderr, "error: structure index %ld out of range (0-%d)\n", numeric, LF_NUM_STRUCTS - 1);
+	  exit(EXIT_FAILURE);
+	}
+      return (int) numeric;
+    }
+
+  int idx;
+  for (idx = 0; idx < LF_NUM_STRUCTS; idx++)
+    {
+      if (strcasecmp(arg, lf_struct_des[idx]) == 0)
+	{
+	  return idx;
+	}
+    }
+
+  fprintf(stderr, "error: unknown structure '%s'\n", arg);
+  exit(EXIT_FAILURE);
+}
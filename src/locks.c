@@ -0,0 +1,133 @@
+/*
+ *   File: locks.c
+ *   Description: allocation and initialization of the LOCK_* event locks
+ *   locks.c is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "locks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+
+const char* lock_type_des[] =
+  {
+    "TAS",
+    "TTAS",
+    "TICKET",
+    "ARRAY",
+    "MCS",
+    "CLH",
+    "MUTEX",
+  };
+
+static void*
+lock_alloc(size_t size)
+{
+  void* mem = NULL;
+  if (posix_memalign(&mem, 64, size) != 0)
+    {
+      perror("posix_memalign");
+      exit(1);
+    }
+  memset(mem, 0, size);
+  return mem;
+}
+
+lock_t*
+lock_new(const lock_type_t type, const uint32_t num_threads)
+{
+  lock_t* lock = (lock_t*) lock_alloc(sizeof(lock_t));
+  lock->type = type;
+
+  switch (type)
+    {
+    case LOCK_ARRAY:
+      /* a power of two, so the slot sequence stays contiguous when the
+	 32-bit tail wraps around */
+      lock->num_slots = 1;
+      while (lock->num_slots < num_threads)
+	{
+	  lock->num_slots <<= 1;
+	}
+      lock->slots = (lock_qnode_t*) lock_alloc(lock->num_slots * sizeof(lock_qnode_t));
+      lock->slots[0].locked = 1;
+      break;
+    case LOCK_CLH:
+      lock->clh_tail = (lock_qnode_t*) lock_alloc(sizeof(lock_qnode_t)); /* unlocked dummy */
+      break;
+    case LOCK_MUTEX:
+      pthread_mutex_init(&lock->mutex, NULL);
+      break;
+    default:
+      break;
+    }
+
+  return lock;
+}
+
+void
+lock_local_init(lock_t* lock, lock_local_t* local)
+{
+  memset(local, 0, sizeof(lock_local_t));
+  if (lock->type == LOCK_MCS)
+    {
+      local->mcs = (mcs_qnode_t*) lock_alloc(sizeof(mcs_qnode_t));
+    }
+  else if (lock->type == LOCK_CLH)
+    {
+      local->clh = (lock_qnode_t*) lock_alloc(sizeof(lock_qnode_t));
+    }
+}
+
+int
+lock_parse_type(const char* arg)
+{
+  char* endptr = NULL;
+  errno = 0;
+  long numeric = strtol(arg, &endptr, 10);
+  if (endptr != arg && *endptr == '\0' && errno == 0)
+    {
+      if (numeric < 0 || numeric >= LOCK_NUM_TYPES)
+	{
+	  fprintf(stderr, "error: lock index %ld out of range (0-%d)\n", numeric, LOCK_NUM_TYPES - 1);
+	  exit(EXIT_FAILURE);
+	}
+      return (int) numeric;
+    }
+
+  int idx;
+  for (idx = 0; idx < LOCK_NUM_TYPES; idx++)
+    {
+      if (strcasecmp(arg, lock_type_des[idx]) == 0)
+	{
+	  return idx;
+	}
+    }
+
+  fprintf(stderr, "error: unknown lock '%s'\n", arg);
+  exit(EXIT_FAILURE);
+}
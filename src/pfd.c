@@ -243,7 +243,7 @@ pfd_store_init(uint32_t num_entries)
 
   if (global_pfd_correction == 0 || global_pfd_num_entries != num_entries)
     {
-      ticks correction = estimate_median_rdtsc_delta(num_entries);
+      ticks correction = estimate_median_rdtsc_delta(num_entries, NULL);
       if (correction == 0)
         {
           ticks measured = measure_minimum_tick_delta(512);
@@ -366,15 +366,15 @@ pfd_collect_abs_deviation(uint32_t store, uint32_t num_vals, uint32_t num_print,
 
 #define PFD_VAL_UP_LIMIT 1500	/* do not consider values higher than this value */
 
-void
-get_abs_deviation(volatile ticks* vals, const size_t num_vals, abs_deviation_t* abs_dev)
+static void
+abs_deviation(volatile ticks* vals, const size_t num_vals, const ticks limit, abs_deviation_t* abs_dev)
 {
   abs_dev->num_vals = num_vals;
   ticks sum_vals = 0;
   uint32_t i;
   for (i = 0; i < num_vals; i++)
     {
-      if ((int64_t) vals[i] < 0 || vals[i] > PFD_VAL_UP_LIMIT)
+      if ((int64_t) vals[i] < 0 || vals[i] > limit)
 	{
 	  vals[i] = 0;
 	}
@@ -516,3 +516,123 @@ get_abs_deviation(volatile ticks* vals, const size_t num_vals, abs_deviation_t*
   double stdev = sqrt(sum_stdev / num_vals);
   abs_dev->std_dev = stdev;
 }
+
+void
+get_abs_deviation(volatile ticks* vals, const size_t num_vals, abs_deviation_t* abs_dev)
+{
+  abs_deviation(vals, num_vals, PFD_VAL_UP_LIMIT, abs_dev);
+}
+
+/* get_abs_deviation over the values get_percentiles keeps: the negative ones */
+/* are left out instead of counted as 0, the ones above PFD_VAL_UP_LIMIT stay; */
+/* vals is left as it is */
+void
+get_abs_deviation_all(volatile ticks* vals, const size_t num_vals, abs_deviation_t* abs_dev)
+{
+  ticks* kept = (ticks*) malloc((num_vals ? num_vals : 1) * sizeof(ticks));
+  assert(kept != NULL);
+  size_t v, num_kept = 0;
+  for (v = 0; v < num_vals; v++)
+    {
+      if ((int64_t) vals[v] >= 0)
+	{
+	  kept[num_kept++] = vals[v];
+	}
+    }
+  abs_deviation(kept, num_kept, (ticks) INT64_MAX, abs_dev);
+  free(kept);
+}
+
+#define MERGE_BAND(p)							\
+  {									\
+    uint32_t n = acc->num_dev_##p + batch->num_dev_##p;		\
+    if (n > 0)								\
+      {									\
+	double wa = acc->num_dev_##p / (double) n, wb = batch->num_dev_##p / (double) n; \
+	acc->avg_##p = (acc->num_dev_##p ? wa * acc->avg_##p : 0) + (batch->num_dev_##p ? wb * batch->avg_##p : 0); \
+	acc->abs_dev_##p = (acc->num_dev_##p ? wa * acc->abs_dev_##p : 0) + (batch->num_dev_##p ? wb * batch->abs_dev_##p : 0); \
+	acc->std_dev_##p = (acc->num_dev_##p ? wa * acc->std_dev_##p : 0) + (batch->num_dev_##p ? wb * batch->std_dev_##p : 0); \
+      }									\
+    acc->num_dev_##p = n;						\
+  }
+
+/* adds the stats of a further batch of values to acc: exact for the count, the */
+/* average, the standard deviation and the extremes; the bands and the absolute */
+/* deviation are weighted by their counts */
+void
+merge_abs_deviation(abs_deviation_t* acc, const abs_deviation_t* batch)
+{
+  const uint64_t n = acc->num_vals + batch->num_vals;
+  if (batch->num_vals == 0)
+    {
+      return;
+    }
+  if (acc->num_vals == 0)
+    {
+      *acc = *batch;
+      return;
+    }
+
+  const double wa = acc->num_vals / (double) n, wb = batch->num_vals / (double) n;
+  const double avg = wa * acc->avg + wb * batch->avg;
+  const double sq = wa * (acc->std_dev * acc->std_dev + acc->avg * acc->avg)
+    + wb * (batch->std_dev * batch->std_dev + batch->avg * batch->avg);
+  acc->std_dev = (sq > avg * avg) ? sqrt(sq - avg * avg) : 0;
+  acc->abs_dev = wa * acc->abs_dev + wb * batch->abs_dev;
+  acc->avg = avg;
+
+  if (batch->min_val < acc->min_val)
+    {
+      acc->min_val = batch->min_val;
+      acc->min_val_idx = acc->num_vals + batch->min_val_idx;
+    }
+  if (batch->max_val > acc->max_val)
+    {
+      acc->max_val = batch->max_val;
+      acc->max_val_idx = acc->num_vals + batch->max_val_idx;
+    }
+
+  MERGE_BAND(10p);
+  MERGE_BAND(25p);
+  MERGE_BAND(50p);
+  MERGE_BAND(75p);
+  MERGE_BAND(rst);
+  acc->num_vals = n;
+}
+
+/* the q-quantiles (0 <= q <= 1) of vals; unlike get_abs_deviation, the values */
+/* above PFD_VAL_UP_LIMIT are kept, since they are the tail. The negative ones, */
+/* samples shorter than pfd_correction that wrapped around, are left out */
+void
+get_percentiles(volatile ticks* vals, const size_t num_vals, const double* qs, double* out, const uint32_t num_qs)
+{
+  uint32_t i;
+  ticks* sorted = (ticks*) malloc((num_vals ? num_vals : 1) * sizeof(ticks));
+  assert(sorted != NULL);
+  size_t v, num_kept = 0;
+  for (v = 0; v < num_vals; v++)
+    {
+      if ((int64_t) vals[v] >= 0)
+	{
+	  sorted[num_kept++] = vals[v];
+	}
+    }
+
+  if (num_kept == 0)
+    {
+      for (i = 0; i < num_qs; i++)
+	{
+	  out[i] = 0;
+	}
+      free(sorted);
+      return;
+    }
+  qsort(sorted, num_kept, sizeof(ticks), ticks_compare);
+
+  for (i = 0; i < num_qs; i++)
+    {
+      size_t idx = (size_t) (qs[i] * num_kept);
+      out[i] = sorted[(idx < num_kept) ? idx : num_kept - 1];
+    }
+  free(sorted);
+}
@@ -0,0 +1,292 @@
+/*
+ *   File: report.c
+ *   Description: records of the results as csv or json (--format)
+ *   report.c is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "report.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+const char* report_format_des[] =
+  {
+    "text",
+    "csv",
+    "json",
+  };
+
+struct report
+{
+  report_format_t format;
+  FILE* out;
+  uint32_t records;
+  uint32_t fields;		/* of the current record */
+  uint32_t num_fields;		/* of the first record */
+  char* header;			/* csv: the keys of the first record */
+  size_t header_len;
+  size_t header_cap;
+  char* first;			/* csv: the values of the first record, printed after the header */
+  size_t first_len;
+  size_t first_cap;
+};
+
+static void*
+report_alloc(size_t size)
+{
+  void* mem = calloc(1, size);
+  if (mem == NULL)
+    {
+      perror("calloc");
+      exit(1);
+    }
+  return mem;
+}
+
+report_t*
+report_open(const report_format_t format, FILE* out)
+{
+  report_t* r = (report_t*) report_alloc(sizeof(report_t));
+  r->format = format;
+  r->out = out;
+  if (format == REPORT_JSON)
+    {
+      fprintf(out, "[");
+    }
+  return r;
+}
+
+void
+report_begin(report_t* r)
+{
+  r->fields = 0;
+  if (r->format == REPORT_JSON)
+    {
+      fprintf(r->out, "%s\n  {", r->records ? "," : "");
+    }
+}
+
+/* appends s to the list in *buf, after a ',' if sep */
+static void
+report_append(char** buf, size_t* len, size_t* cap, const char* s, const int sep)
+{
+  size_t need = *len + strlen(s) + 2;
+  if (need > *cap)
+    {
+      *cap = 2 * need;
+      *buf = (char*) realloc(*buf, *cap);
+      if (*buf == NULL)
+	{
+	  perror("realloc");
+	  exit(1);
+	}
+    }
+  *len += sprintf(*buf + *len, "%s%s", sep ? "," : "", s);
+}
+
+/* the separator and, for json, the key; the csv header collects the keys */
+static void
+report_key(report_t* r, const char* key)
+{
+  if (r->records == 0)
+    {
+      report_append(&r->header, &r->header_len, &r->header_cap, key, r->fields > 0);
+    }
+  else if (r->fields >= r->num_fields)
+    {
+      fprintf(stderr, "error: report record %u has more fields than the first one (%s)\n", r->records, key);
+      exit(1);
+    }
+
+  switch (r->format)
+    {
+    case REPORT_CSV:
+      if (r->records > 0 && r->fields > 0)
+	{
+	  fputc(',', r->out);
+	}
+      break;
+    case REPORT_JSON:
+      fprintf(r->out, "%s\"%s\": ", r->fields ? ", " : " ", key);
+      break;
+    default:
+      break;
+    }
+}
+
+static void
+report_value(report_t* r, const char* value)
+{
+  if (r->format == REPORT_CSV && r->records == 0)
+    {
+      /* the header goes first */
+      report_append(&r->first, &r->first_len, &r->first_cap, value, r->fields > 0);
+    }
+  else
+    {
+      fputs(value, r->out);
+    }
+  r->fields++;
+}
+
+void
+report_str(report_t* r, const char* key, const char* value)
+{
+  if (r->format == REPORT_TEXT)
+    {
+      return;
+    }
+  report_key(r, key);
+
+  char buf[1024];
+  size_t n = 0;
+  const char quote = (r->format == REPORT_JSON || strpbrk(value, ",\"\n") != NULL) ? '"' : 0;
+  if (quote)
+    {
+      buf[n++] = quote;
+    }
+  for (; *value != '\0' && n < sizeof(buf) - 4; value++)
+    {
+      if (*value == '"')
+	{
+	  buf[n++] = (r->format == REPORT_JSON) ? '\\' : '"';
+	}
+      else if (*value == '\\' && r->format == REPORT_JSON)
+	{
+	  buf[n++] = '\\';
+	}
+      buf[n++] = (*value == '\n') ? ' ' : *value;
+    }
+  if (quote)
+    {
+      buf[n++] = quote;
+    }
+  buf[n] = '\0';
+  report_value(r, buf);
+}
+
+void
+report_uint(report_t* r, const char* key, const uint64_t value)
+{
+  if (r->format == REPORT_TEXT)
+    {
+      return;
+    }
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%" PRIu64, value);
+  report_key(r, key);
+  report_value(r, buf);
+}
+
+void
+report_real(report_t* r, const char* key, const double value)
+{
+  if (r->format == REPORT_TEXT)
+    {
+      return;
+    }
+  char buf[32];
+  if (isfinite(value))
+    {
+      snprintf(buf, sizeof(buf), "%.10g", value);
+    }
+  else
+    {
+      snprintf(buf, sizeof(buf), "%s", (r->format == REPORT_JSON) ? "null" : "");
+    }
+  report_key(r, key);
+  report_value(r, buf);
+}
+
+void
+report_end(report_t* r)
+{
+  switch (r->format)
+    {
+    case REPORT_CSV:
+      if (r->records == 0)
+	{
+	  fprintf(r->out, "%s\n%s", r->header, r->first ? r->first : "");
+	}
+      fputc('\n', r->out);
+      break;
+    case REPORT_JSON:
+      fprintf(r->out, " }");
+      break;
+    default:
+      return;
+    }
+
+  if (r->records == 0)
+    {
+      r->num_fields = r->fields;
+    }
+  else if (r->fields != r->num_fields)
+    {
+      fprintf(stderr, "error: report record %u has %u fields, the first one %u\n", r->records, r->fields,
+	      r->num_fields);
+      exit(1);
+    }
+  r->records++;
+  fflush(r->out);
+}
+
+void
+report_close(report_t* r)
+{
+  if (r->format == REPORT_JSON)
+    {
+      fprintf(r->out, "%s]\n", r->records ? "\n" : "");
+    }
+  if (r->out != stdout)
+    {
+      fclose(r->out);
+    }
+  else
+    {
+      fflush(r->out);
+    }
+  free(r->header);
+  free(r->first);
+  free(r);
+}
+
+int
+report_parse_format(const char* arg)
+{
+  int f;
+  for (f = 0; f < REPORT_NUM_FORMATS; f++)
+    {
+      if (strcasecmp(arg, report_format_des[f]) == 0)
+	{
+	  return f;
+	}
+    }
+
+  fprintf(stderr, "error: --format must be text, csv or json, not '%s'\n", arg);
+  exit(EXIT_FAILURE);
+}
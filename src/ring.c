@@ -0,0 +1,110 @@
+/*
+ *   File: ring.c
+ *   Description: allocation and initialization of the RING event rings
+ *   ring.c is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "ring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+
+const char* ring_kind_des[] =
+  {
+    "SPSC",
+    "SPSC_CACHED",
+    "SPSC_BATCH",
+    "MPMC",
+  };
+
+static void*
+ring_alloc(size_t size)
+{
+  void* mem = NULL;
+  if (posix_memalign(&mem, 64, size) != 0)
+    {
+      perror("posix_memalign");
+      exit(1);
+    }
+  memset(mem, 0, size);
+  return mem;
+}
+
+ring_t*
+ring_new(const ring_kind_t kind, const uint32_t payload, const uint32_t batch)
+{
+  ring_t* ring = (ring_t*) ring_alloc(sizeof(ring_t));
+  ring->kind = kind;
+  ring->mask = RING_SLOTS - 1;
+  ring->payload = payload;
+  ring->slot_size = sizeof(uint64_t) + ((payload + 7) & ~7U);
+  ring->batch = (batch > 0) ? batch : 1;
+  ring->slots = (uint8_t*) ring_alloc((size_t) RING_SLOTS * ring->slot_size);
+
+  uint64_t pos;
+  for (pos = 0; pos < RING_SLOTS; pos++)
+    {
+      *ring_seq(ring, pos) = pos;
+    }
+
+  return ring;
+}
+
+void
+ring_local_init(ring_t* ring, ring_local_t* local)
+{
+  memset(local, 0, sizeof(ring_local_t));
+}
+
+int
+ring_parse_kind(const char* arg)
+{
+  char* endptr = NULL;
+  errno = 0;
+  long numeric = strtol(arg, &endptr, 10);
+  if (endptr != arg && *endptr == '\0' && errno == 0)
+    {
+      if (numeric < 0 || numeric >= RING_NUM_KINDS)
+	{
+	  fprintf(stderr, "error: ring index %ld out of range (0-%d)\n", numeric, RING_NUM_KINDS - 1);
+	  exit(EXIT_FAILURE);
+	}
+      return (int) numeric;
+    }
+
+  int idx;
+  for (idx = 0; idx < RING_NUM_KINDS; idx++)
+    {
+      if (strcasecmp(arg, ring_kind_des[idx]) == 0)
+	{
+	  return idx;
+	}
+    }
+
+  fprintf(stderr, "error: unknown ring '%s'\n", arg);
+  exit(EXIT_FAILURE);
+}
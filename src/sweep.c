@@ -0,0 +1,615 @@
+/*
+ *   File: sweep.c
+ *   Description: expansion of the --sweep specifications and their resumable output
+ *   sweep.c is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "sweep.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+
+typedef enum
+  {
+    SWEEP_TEST,
+    SWEEP_FENCE,
+    SWEEP_STRIDE,
+    SWEEP_CORES,
+    SWEEP_MEM,
+    SWEEP_HINT,
+    SWEEP_NUM_KEYS,
+  } sweep_key_t;
+
+/* in the order of the expansion, the last one innermost */
+static const char* sweep_key_des[] =
+  {
+    "test",
+    "fence",
+    "stride",
+    "cores",
+    "mem",
+    "hint",
+  };
+
+typedef struct
+{
+  uint64_t values[SWEEP_MAX_VALUES];
+  uint32_t num;
+  uint32_t lists[SWEEP_MAX_VALUES][SWEEP_MAX_CORES]; /* cores */
+  uint32_t list_len[SWEEP_MAX_VALUES];
+} sweep_values_t;
+
+static void
+sweep_error(const char* key, const char* what, const char* item)
+{
+  fprintf(stderr, "error: --sweep %s: %s '%s'\n", key, what, item);
+  exit(EXIT_FAILURE);
+}
+
+static char*
+sweep_trim(char* s)
+{
+  while (isspace((unsigned char) *s))
+    {
+      s++;
+    }
+  size_t len = strlen(s);
+  while (len > 0 && isspace((unsigned char) s[len - 1]))
+    {
+      s[--len] = '\0';
+    }
+  return s;
+}
+
+/* a number, with a K, M or G suffix if size */
+static uint64_t
+sweep_number(const char* key, const char* item, int size)
+{
+  char* endptr = NULL;
+  errno = 0;
+  uint64_t v = strtoull(item, &endptr, 10);
+  if (endptr == item || errno != 0)
+    {
+      sweep_error(key, "not a number", item);
+    }
+  if (size && *endptr != '\0')
+    {
+      switch (*endptr++)
+	{
+	case 'k': case 'K': v <<= 10; break;
+	case 'm': case 'M': v <<= 20; break;
+	case 'g': case 'G': v <<= 30; break;
+	default: sweep_error(key, "unknown size suffix in", item);
+	}
+      if (*endptr == 'b' || *endptr == 'B')
+	{
+	  endptr++;
+	}
+    }
+  if (*endptr != '\0')
+    {
+      sweep_error(key, "not a number", item);
+    }
+  return v;
+}
+
+static void
+sweep_add(sweep_values_t* vals, const char* key, const char* item, uint64_t v)
+{
+  if (vals->num == SWEEP_MAX_VALUES)
+    {
+      fprintf(stderr, "error: --sweep %s: more than %d values\n", key, SWEEP_MAX_VALUES);
+      exit(EXIT_FAILURE);
+    }
+  vals->values[vals->num++] = v;
+}
+
+/* [x,y,...] */
+static void
+sweep_core_list(sweep_values_t* vals, const char* key, char* item)
+{
+  size_t len = strlen(item);
+  if (len < 2 || item[len - 1] != ']')
+    {
+      sweep_error(key, "unterminated list", item);
+    }
+  char copy[SWEEP_SPEC_LEN];
+  snprintf(copy, sizeof(copy), "%.*s", (int) (len - 2), item + 1);
+
+  uint32_t* list = vals->lists[vals->num];
+  uint32_t n = 0;
+  char* save = NULL;
+  char* tok;
+  for (tok = strtok_r(copy, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save))
+    {
+      if (n == SWEEP_MAX_CORES)
+	{
+	  fprintf(stderr, "error: --sweep %s: more than %d cores in '%s'\n", key, SWEEP_MAX_CORES, item);
+	  exit(EXIT_FAILURE);
+	}
+      list[n++] = (uint32_t) sweep_number(key, sweep_trim(tok), 0);
+    }
+  if (n == 0)
+    {
+      sweep_error(key, "empty list", item);
+    }
+  vals->list_len[vals->num] = n;
+  sweep_add(vals, key, item, n);
+}
+
+static void
+sweep_parse_item(sweep_values_t* vals, sweep_key_t key, char* item, const sweep_config_t* defaults,
+		 int (*parse_test)(const char*), int (*parse_hint)(const char*))
+{
+  const char* name = sweep_key_des[key];
+  if (key == SWEEP_CORES && item[0] == '[')
+    {
+      sweep_core_list(vals, name, item);
+      return;
+    }
+
+  char* dash = (key == SWEEP_TEST || key == SWEEP_HINT) ? strchr(item, '-') : strchr(item + 1, '-');
+  char* last = item;
+  if (dash != NULL)
+    {
+      *dash = '\0';
+      last = sweep_trim(dash + 1);
+      item = sweep_trim(item);
+    }
+
+  uint64_t from, to, v;
+  switch (key)
+    {
+    case SWEEP_TEST:
+      from = parse_test(item);
+      to = parse_test(last);
+      break;
+    case SWEEP_HINT:
+      from = parse_hint(item);
+      to = parse_hint(last);
+      break;
+    case SWEEP_MEM:
+      from = sweep_number(name, item, 1);
+      to = sweep_number(name, last, 1);
+      break;
+    default:
+      from = sweep_number(name, item, 0);
+      to = sweep_number(name, last, 0);
+      break;
+    }
+  if (to < from)
+    {
+      sweep_error(name, "empty range at", item);
+    }
+
+  for (v = from; v <= to; v = (key == SWEEP_STRIDE || key == SWEEP_MEM) ? v << 1 : v + 1)
+    {
+      switch (key)
+	{
+	case SWEEP_FENCE:
+	  if (v > SWEEP_MAX_FENCE)
+	    {
+	      sweep_error(name, "levels are 0-9, not", item);
+	    }
+	  break;
+	case SWEEP_STRIDE:
+	case SWEEP_MEM:
+	  if (v == 0)
+	    {
+	      sweep_error(name, "must be positive:", item);
+	    }
+	  break;
+	case SWEEP_CORES:
+	  if (v == 0 || v > defaults->num_cores)
+	    {
+	      fprintf(stderr, "error: --sweep cores: %" PRIu64 " is not in 1-%u, the cores of -x / -c\n",
+		      v, defaults->num_cores);
+	      exit(EXIT_FAILURE);
+	    }
+	  memcpy(vals->lists[vals->num], defaults->cores, v * sizeof(uint32_t));
+	  vals->list_len[vals->num] = v;
+	  break;
+	default:
+	  break;
+	}
+      sweep_add(vals, name, item, v);
+    }
+}
+
+/* splits the values at the ',' outside of [] */
+static void
+sweep_parse_values(sweep_values_t* vals, sweep_key_t key, char* values, const sweep_config_t* defaults,
+		   int (*parse_test)(const char*), int (*parse_hint)(const char*))
+{
+  char* item = values;
+  uint32_t depth = 0;
+  for (;; values++)
+    {
+      if (*values == '[')
+	{
+	  depth++;
+	}
+      else if (*values == ']' && depth > 0)
+	{
+	  depth--;
+	}
+      else if ((*values == ',' && depth == 0) || *values == '\0')
+	{
+	  const int end = (*values == '\0');
+	  *values = '\0';
+	  item = sweep_trim(item);
+	  if (*item == '\0')
+	    {
+	      sweep_error(sweep_key_des[key], "empty value in", sweep_key_des[key]);
+	    }
+	  sweep_parse_item(vals, key, item, defaults, parse_test, parse_hint);
+	  if (end)
+	    {
+	      return;
+	    }
+	  item = values + 1;
+	}
+    }
+}
+
+/* the spec, from the file arg or arg itself, with the comments dropped and the */
+/* entries separated by ';' */
+static char*
+sweep_read(const char* arg)
+{
+  FILE* f = fopen(arg, "r");
+  if (f == NULL)
+    {
+      if (strchr(arg, '=') == NULL)
+	{
+	  perror(arg);
+	  exit(EXIT_FAILURE);
+	}
+      return strdup(arg);
+    }
+
+  size_t cap = SWEEP_SPEC_LEN, len = 0;
+  char* text = (char*) malloc(cap);
+  char line[SWEEP_SPEC_LEN];
+  while (fgets(line, sizeof(line), f) != NULL)
+    {
+      char* hash = strchr(line, '#');
+      if (hash != NULL)
+	{
+	  *hash = '\0';
+	}
+      size_t n = strlen(line);
+      while (len + n + 2 > cap)
+	{
+	  cap <<= 1;
+	  text = (char*) realloc(text, cap);
+	}
+      memcpy(text + len, line, n);
+      len += n;
+      text[len++] = ';';
+    }
+  fclose(f);
+  text[len] = '\0';
+  return text;
+}
+
+sweep_t*
+sweep_parse(const char* arg, const sweep_config_t* defaults, int (*parse_test)(const char*),
+	    int (*parse_hint)(const char*))
+{
+  sweep_values_t* vals = (sweep_values_t*) calloc(SWEEP_NUM_KEYS, sizeof(sweep_values_t));
+  sweep_t* sweep = (sweep_t*) calloc(1, sizeof(sweep_t));
+  char given[SWEEP_NUM_KEYS][SWEEP_SPEC_LEN] = { { 0 } };
+  if (vals == NULL || sweep == NULL)
+    {
+      perror("calloc");
+      exit(EXIT_FAILURE);
+    }
+
+  char* text = sweep_read(arg);
+  char* save = NULL;
+  char* entry;
+  uint32_t k;
+  for (entry = strtok_r(text, ";\n", &save); entry != NULL; entry = strtok_r(NULL, ";\n", &save))
+    {
+      entry = sweep_trim(entry);
+      if (*entry == '\0')
+	{
+	  continue;
+	}
+      char* eq = strchr(entry, '=');
+      if (eq == NULL)
+	{
+	  sweep_error("spec", "no key=values in", entry);
+	}
+      *eq = '\0';
+      char* key = sweep_trim(entry);
+      char* values = sweep_trim(eq + 1);
+      for (k = 0; k < SWEEP_NUM_KEYS && strcasecmp(key, sweep_key_des[k]) != 0; k++)
+	;
+      if (k == SWEEP_NUM_KEYS)
+	{
+	  sweep_error("spec", "unknown key (test, fence, stride, cores, mem or hint)", key);
+	}
+      if (vals[k].num > 0)
+	{
+	  sweep_error("spec", "key given twice:", key);
+	}
+      snprintf(given[k], SWEEP_SPEC_LEN, "%s", values);
+      sweep_parse_values(&vals[k], k, values, defaults, parse_test, parse_hint);
+    }
+  free(text);
+
+  /* the keys left out */
+  size_t len = 0;
+  uint64_t total = 1;
+  for (k = 0; k < SWEEP_NUM_KEYS; k++)
+    {
+      if (vals[k].num == 0)
+	{
+	  switch (k)
+	    {
+	    case SWEEP_TEST: vals[k].values[0] = defaults->test; break;
+	    case SWEEP_FENCE: vals[k].values[0] = defaults->fence; break;
+	    case SWEEP_STRIDE: vals[k].values[0] = defaults->stride; break;
+	    case SWEEP_MEM: vals[k].values[0] = defaults->mem_size; break;
+	    case SWEEP_HINT: vals[k].values[0] = defaults->hint; break;
+	    case SWEEP_CORES:
+	      memcpy(vals[k].lists[0], defaults->cores, defaults->num_cores * sizeof(uint32_t));
+	      vals[k].list_len[0] = defaults->num_cores;
+	      break;
+	    }
+	  vals[k].num = 1;
+	}
+      else
+	{
+	  len += snprintf(sweep->spec + len, (len < SWEEP_SPEC_LEN) ? SWEEP_SPEC_LEN - len : 0, "%s%s=%s",
+			  len ? ";" : "", sweep_key_des[k], given[k]);
+	}
+      total *= vals[k].num;
+      if (total > SWEEP_MAX_CONFIGS)
+	{
+	  fprintf(stderr, "error: --sweep expands to more than %d configurations\n", SWEEP_MAX_CONFIGS);
+	  exit(EXIT_FAILURE);
+	}
+    }
+  if (len == 0)
+    {
+      sweep_error("spec", "no key=values in", arg);
+    }
+
+  sweep->num_configs = (uint32_t) total;
+  sweep->configs = (sweep_config_t*) calloc(total, sizeof(sweep_config_t));
+  if (sweep->configs == NULL)
+    {
+      perror("calloc");
+      exit(EXIT_FAILURE);
+    }
+
+  uint32_t c;
+  for (c = 0; c < total; c++)
+    {
+      sweep_config_t* config = &sweep->configs[c];
+      uint32_t idx[SWEEP_NUM_KEYS], rest = c;
+      for (k = SWEEP_NUM_KEYS; k-- > 0;)
+	{
+	  idx[k] = rest % vals[k].num;
+	  rest /= vals[k].num;
+	}
+      config->test = (uint32_t) vals[SWEEP_TEST].values[idx[SWEEP_TEST]];
+      config->fence = (uint32_t) vals[SWEEP_FENCE].values[idx[SWEEP_FENCE]];
+      config->stride = (uint32_t) vals[SWEEP_STRIDE].values[idx[SWEEP_STRIDE]];
+      config->mem_size = (size_t) vals[SWEEP_MEM].values[idx[SWEEP_MEM]];
+      config->hint = (uint32_t) vals[SWEEP_HINT].values[idx[SWEEP_HINT]];
+      config->num_cores = vals[SWEEP_CORES].list_len[idx[SWEEP_CORES]];
+      memcpy(config->cores, vals[SWEEP_CORES].lists[idx[SWEEP_CORES]], config->num_cores * sizeof(uint32_t));
+
+      if (config->mem_size > sweep->max_mem_size)
+	{
+	  sweep->max_mem_size = config->mem_size;
+	}
+      if (config->num_cores > sweep->max_cores)
+	{
+	  sweep->max_cores = config->num_cores;
+	}
+    }
+
+  free(vals);
+  return sweep;
+}
+
+uint32_t
+sweep_workers(const sweep_t* sweep, uint32_t* workers, uint32_t max)
+{
+  uint32_t num = 0, c, i, w;
+  for (c = 0; c < sweep->num_configs; c++)
+    {
+      const sweep_config_t* config = &sweep->configs[c];
+      for (i = 0; i < config->num_cores; i++)
+	{
+	  /* the occurrences of the cpu so far in config, and among the workers */
+	  uint32_t in_config = 0, in_workers = 0, j;
+	  for (j = 0; j <= i; j++)
+	    {
+	      in_config += (config->cores[j] == config->cores[i]);
+	    }
+	  for (w = 0; w < num; w++)
+	    {
+	      in_workers += (workers[w] == config->cores[i]);
+	    }
+	  if (in_config > in_workers)
+	    {
+	      if (num == max)
+		{
+		  fprintf(stderr, "error: --sweep needs more than %u workers\n", max);
+		  exit(EXIT_FAILURE);
+		}
+	      workers[num++] = config->cores[i];
+	    }
+	}
+    }
+  return num;
+}
+
+void
+sweep_ranks(const sweep_config_t* config, const uint32_t* workers, uint32_t num_workers, int32_t* rank_of)
+{
+  uint32_t r, w;
+  for (w = 0; w < num_workers; w++)
+    {
+      rank_of[w] = -1;
+    }
+  for (r = 0; r < config->num_cores; r++)
+    {
+      for (w = 0; w < num_workers; w++)
+	{
+	  if (workers[w] == config->cores[r] && rank_of[w] < 0)
+	    {
+	      rank_of[w] = r;
+	      break;
+	    }
+	}
+    }
+}
+
+/* the line in buf (at most len bytes) without its new line; 0 if there is none */
+static int
+sweep_line(FILE* f, char* buf, size_t len)
+{
+  if (fgets(buf, len, f) == NULL)
+    {
+      return 0;
+    }
+  size_t n = strlen(buf);
+  if (n == 0 || buf[n - 1] != '\n')
+    {
+      return 0;
+    }
+  buf[n - 1] = '\0';
+  return 1;
+}
+
+/* 64-bit FNV-1a */
+static uint64_t
+sweep_hash(uint64_t h, const void* data, size_t len)
+{
+  const uint8_t* p = (const uint8_t*) data;
+  size_t i;
+  for (i = 0; i < len; i++)
+    {
+      h ^= p[i];
+      h *= 0x100000001b3ULL;
+    }
+  return h;
+}
+
+uint64_t
+sweep_digest(const sweep_t* sweep)
+{
+  uint64_t h = 0xcbf29ce484222325ULL;
+  uint32_t c;
+  for (c = 0; c < sweep->num_configs; c++)
+    {
+      const sweep_config_t* config = &sweep->configs[c];
+      const uint64_t mem = config->mem_size;
+      h = sweep_hash(h, &config->test, sizeof(config->test));
+      h = sweep_hash(h, &config->fence, sizeof(config->fence));
+      h = sweep_hash(h, &config->stride, sizeof(config->stride));
+      h = sweep_hash(h, &mem, sizeof(mem));
+      h = sweep_hash(h, &config->hint, sizeof(config->hint));
+      h = sweep_hash(h, &config->num_cores, sizeof(config->num_cores));
+      h = sweep_hash(h, config->cores, config->num_cores * sizeof(uint32_t));
+    }
+  return h;
+}
+
+FILE*
+sweep_open(const char* path, const char* signature, const char* header, uint32_t* done)
+{
+  *done = 0;
+  FILE* f = fopen(path, "r+");
+  char* line = (char*) malloc(SWEEP_SPEC_LEN * 4);
+  if (line == NULL)
+    {
+      perror("malloc");
+      exit(EXIT_FAILURE);
+    }
+
+  if (f != NULL && sweep_line(f, line, SWEEP_SPEC_LEN * 4))
+    {
+      if (strcmp(line, signature) != 0)
+	{
+	  fprintf(stderr, "error: %s holds the rows of another sweep; remove it or pick another --output\n"
+		  "  %s: %s\n  this run: %s\n", path, path, line, signature);
+	  exit(EXIT_FAILURE);
+	}
+      if (!sweep_line(f, line, SWEEP_SPEC_LEN * 4) || strcmp(line, header) != 0)
+	{
+	  fprintf(stderr, "error: %s holds the rows of another sweep; remove it or pick another --output\n", path);
+	  exit(EXIT_FAILURE);
+	}
+
+      /* the complete rows; a row cut off by an interruption is written again */
+      long good = ftell(f);
+      int c, cut = 0;
+      while ((c = fgetc(f)) != EOF)
+	{
+	  cut = 1;
+	  if (c == '\n')
+	    {
+	      (*done)++;
+	      good = ftell(f);
+	      cut = 0;
+	    }
+	}
+      if (cut && ftruncate(fileno(f), good) != 0)
+	{
+	  perror(path);
+	  exit(EXIT_FAILURE);
+	}
+      fseek(f, good, SEEK_SET);
+      free(line);
+      return f;
+    }
+
+  if (f != NULL)
+    {
+      fclose(f);
+    }
+  f = fopen(path, "w");
+  if (f == NULL)
+    {
+      perror(path);
+      exit(EXIT_FAILURE);
+    }
+  fprintf(f, "%s\n%s\n", signature, header);
+  fflush(f);
+  free(line);
+  return f;
+}
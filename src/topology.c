@@ -0,0 +1,595 @@
+/*
+ *   File: topology.c
+ *   Description: cpu and NUMA topology discovery, for placement and for grouping results by the
+ *   relation of two cores
+ *   topology.c is part of ccbench
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (C) 2013  Vasileios Trigonakis
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <strings.h>
+#if defined(__linux__)
+#  include <sys/syscall.h>
+#endif
+#if defined(PLATFORM_NUMA)
+#  include <numa.h>
+#endif
+
+#define TOPO_MPOL_PREFERRED 1	/* MPOL_PREFERRED of set_mempolicy(2) */
+
+const char* topo_relation_des[] =
+  {
+    "same cpu",
+    "smt sibling",
+    "same L2",
+    "same L3",
+    "same package",
+    "remote",
+  };
+
+const char* topo_level_des[] =
+  {
+    "socket",
+    "node",
+    "l3",
+  };
+
+static topo_cpu_t* topo_cpus;
+static uint32_t topo_num_cpus;
+static uint32_t topo_nodes;
+static int32_t topo_dist[TOPO_MAX_NODES][TOPO_MAX_NODES];
+
+/* the first integer of a sysfs file; for cpu lists ("0-3,8-11") that is the first cpu */
+static int32_t
+topo_read_int(const char* path)
+{
+  int32_t val = -1;
+  FILE* f = fopen(path, "r");
+  if (f != NULL)
+    {
+      if (fscanf(f, "%d", &val) != 1)
+	{
+	  val = -1;
+	}
+      fclose(f);
+    }
+  return val;
+}
+
+static int32_t
+topo_read_node(uint32_t cpu)
+{
+  char path[128];
+  int32_t node;
+  for (node = 0; node < TOPO_MAX_CPUS; node++)
+    {
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/node%d", cpu, node);
+      if (access(path, F_OK) == 0)
+	{
+	  return node;
+	}
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+      if (access(path, F_OK) != 0)
+	{
+	  break;
+	}
+    }
+#if defined(PLATFORM_NUMA)
+  if (numa_available() >= 0)
+    {
+      return numa_node_of_cpu(cpu);
+    }
+#endif
+  return -1;
+}
+
+/* one row of the SLIT table: "10 21 21 ..." */
+static void
+topo_read_distances(uint32_t node)
+{
+  char path[128];
+  uint32_t to;
+  for (to = 0; to < TOPO_MAX_NODES; to++)
+    {
+      topo_dist[node][to] = -1;
+    }
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/distance", node);
+  FILE* f = fopen(path, "r");
+  if (f != NULL)
+    {
+      for (to = 0; to < TOPO_MAX_NODES && fscanf(f, "%d", &topo_dist[node][to]) == 1; to++)
+	;
+      fclose(f);
+      return;
+    }
+#if defined(PLATFORM_NUMA)
+  if (numa_available() >= 0)
+    {
+      for (to = 0; to < topo_nodes; to++)
+	{
+	  topo_dist[node][to] = numa_distance(node, to);
+	}
+    }
+#endif
+}
+
+/* the first cpu sharing the unified or data cache of level with cpu */
+static int32_t
+topo_read_cache(uint32_t cpu, int32_t level)
+{
+  char path[128];
+  uint32_t idx;
+  for (idx = 0; idx < 8; idx++)
+    {
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/level", cpu, idx);
+      int32_t lvl = topo_read_int(path);
+      if (lvl < 0)
+	{
+	  break;
+	}
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/type", cpu, idx);
+      char type[16] = "";
+      FILE* f = fopen(path, "r");
+      if (f != NULL)
+	{
+	  if (fscanf(f, "%15s", type) != 1)
+	    {
+	      type[0] = '\0';
+	    }
+	  fclose(f);
+	}
+      if (lvl == level && strcmp(type, "Instruction") != 0)
+	{
+	  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpu, idx);
+	  return topo_read_int(path);
+	}
+    }
+  return -1;
+}
+
+void
+topo_init()
+{
+  if (topo_cpus != NULL)
+    {
+      return;
+    }
+
+  long n = sysconf(_SC_NPROCESSORS_CONF);
+  topo_num_cpus = (n > 0 && n < TOPO_MAX_CPUS) ? n : TOPO_MAX_CPUS;
+  topo_cpus = (topo_cpu_t*) calloc(topo_num_cpus, sizeof(topo_cpu_t));
+  if (topo_cpus == NULL)
+    {
+      perror("calloc");
+      exit(1);
+    }
+
+  uint32_t cpu;
+  for (cpu = 0; cpu < topo_num_cpus; cpu++)
+    {
+      char path[128];
+      topo_cpu_t* t = &topo_cpus[cpu];
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+      t->package = topo_read_int(path);
+      t->online = (t->package >= 0);	/* offline cpus have no topology directory */
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/die_id", cpu);
+      t->die = topo_read_int(path);
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu);
+      t->core = topo_read_int(path);
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list", cpu);
+      t->smt_set = topo_read_int(path);
+      t->l2_set = topo_read_cache(cpu, 2);
+      t->l3_set = topo_read_cache(cpu, 3);
+      t->node = topo_read_node(cpu);
+      if (t->node >= 0 && t->node < TOPO_MAX_NODES && (uint32_t) t->node >= topo_nodes)
+	{
+	  topo_nodes = t->node + 1;
+	}
+    }
+
+  uint32_t node;
+  for (node = 0; node < topo_nodes; node++)
+    {
+      topo_read_distances(node);
+    }
+
+  /* without sysfs, the affinity mask alone says which cpus exist */
+  uint32_t online = 0;
+  for (cpu = 0; cpu < topo_num_cpus; cpu++)
+    {
+      online += topo_cpus[cpu].online;
+    }
+#if defined(__linux__)
+  cpu_set_t* mask = CPU_ALLOC(topo_num_cpus);
+  size_t mask_size = CPU_ALLOC_SIZE(topo_num_cpus);
+  int have_mask = (mask != NULL && sched_getaffinity(0, mask_size, mask) == 0);
+  for (cpu = 0; cpu < topo_num_cpus; cpu++)
+    {
+      topo_cpu_t* t = &topo_cpus[cpu];
+      t->allowed = !have_mask || CPU_ISSET_S(cpu, mask_size, mask);
+      t->allowed = t->allowed && (t->online || online == 0);
+    }
+  if (mask != NULL)
+    {
+      CPU_FREE(mask);
+    }
+#else
+  for (cpu = 0; cpu < topo_num_cpus; cpu++)
+    {
+      topo_cpus[cpu].allowed = (topo_cpus[cpu].online || online == 0);
+    }
+#endif
+}
+
+const topo_cpu_t*
+topo_cpu(uint32_t cpu)
+{
+  static const topo_cpu_t unknown = { 0, 0, -1, -1, -1, -1, -1, -1, -1 };
+  topo_init();
+  return (cpu < topo_num_cpus) ? &topo_cpus[cpu] : &unknown;
+}
+
+static int
+topo_same(int32_t x, int32_t y)
+{
+  return (x >= 0 && x == y);
+}
+
+topo_relation_t
+topo_relation(uint32_t a, uint32_t b)
+{
+  if (a == b)
+    {
+      return TOPO_SAME_CPU;
+    }
+
+  const topo_cpu_t* ta = topo_cpu(a);
+  const topo_cpu_t* tb = topo_cpu(b);
+  if (topo_same(ta->smt_set, tb->smt_set))
+    {
+      return TOPO_SMT;
+    }
+  if (topo_same(ta->l2_set, tb->l2_set))
+    {
+      return TOPO_SAME_L2;
+    }
+  if (topo_same(ta->l3_set, tb->l3_set))
+    {
+      return TOPO_SAME_L3;
+    }
+  if (topo_same(ta->package, tb->package) && (ta->node == tb->node))
+    {
+      return TOPO_SAME_PACKAGE;
+    }
+  return TOPO_REMOTE;
+}
+
+int32_t
+topo_find(uint32_t cpu, topo_relation_t rel)
+{
+  uint32_t c;
+  topo_init();
+  for (c = 0; c < topo_num_cpus; c++)
+    {
+      if (topo_cpus[c].allowed && topo_relation(cpu, c) == rel)
+	{
+	  return c;
+	}
+    }
+  return -1;
+}
+
+uint32_t
+topo_allowed(uint32_t* cpus, uint32_t max)
+{
+  uint32_t cpu, n = 0;
+  topo_init();
+  for (cpu = 0; cpu < topo_num_cpus && n < max; cpu++)
+    {
+      if (topo_cpus[cpu].allowed)
+	{
+	  cpus[n++] = cpu;
+	}
+    }
+  return n;
+}
+
+int
+topo_pair(topo_relation_t rel, uint32_t* a, uint32_t* b)
+{
+  uint32_t cpu, c;
+  topo_init();
+  for (cpu = 0; cpu < topo_num_cpus; cpu++)
+    {
+      if (!topo_cpus[cpu].allowed)
+	{
+	  continue;
+	}
+      for (c = 0; c < topo_num_cpus; c++)
+	{
+	  /* TOPO_REMOTE also covers two nodes of one package: cross-socket is another package */
+	  if (topo_cpus[c].allowed && topo_relation(cpu, c) == rel
+	      && (rel != TOPO_REMOTE || (topo_cpus[cpu].package >= 0 && topo_cpus[c].package >= 0
+					 && topo_cpus[cpu].package != topo_cpus[c].package)))
+	    {
+	      *a = cpu;
+	      *b = c;
+	      return 1;
+	    }
+	}
+    }
+  return 0;
+}
+
+static int32_t
+topo_domain(uint32_t cpu, topo_level_t level)
+{
+  const topo_cpu_t* t = &topo_cpus[cpu];
+  switch (level)
+    {
+    case TOPO_LEVEL_NODE:
+      return t->node;
+    case TOPO_LEVEL_L3:
+      return t->l3_set;
+    default:
+      return t->package;
+    }
+}
+
+/* the allowed cpus, only the first allowed hyperthread of every core */
+static uint32_t
+topo_physical(uint32_t* cpus)
+{
+  uint32_t cpu, n = 0, k;
+  for (cpu = 0; cpu < topo_num_cpus; cpu++)
+    {
+      const topo_cpu_t* t = &topo_cpus[cpu];
+      if (!t->allowed)
+	{
+	  continue;
+	}
+      for (k = 0; k < n && !(t->smt_set >= 0 && topo_cpus[cpus[k]].smt_set == t->smt_set); k++)
+	;
+      if (k == n)
+	{
+	  cpus[n++] = cpu;
+	}
+    }
+  return n;
+}
+
+uint32_t
+topo_spread(topo_level_t level, uint32_t* cpus, uint32_t num)
+{
+  topo_init();
+  uint32_t* phys = (uint32_t*) calloc(topo_num_cpus, sizeof(uint32_t));
+  int32_t* domains = (int32_t*) calloc(topo_num_cpus, sizeof(int32_t));
+  uint8_t* used = (uint8_t*) calloc(topo_num_cpus, sizeof(uint8_t));
+  if (phys == NULL || domains == NULL || used == NULL)
+    {
+      perror("calloc");
+      exit(1);
+    }
+
+  uint32_t num_phys = topo_physical(phys);
+  uint32_t num_domains = 0, i, d;
+  for (i = 0; i < num_phys; i++)
+    {
+      int32_t dom = topo_domain(phys[i], level);
+      for (d = 0; d < num_domains && domains[d] != dom; d++)
+	;
+      if (d == num_domains)
+	{
+	  domains[num_domains++] = dom;
+	}
+    }
+  if (num == 0)
+    {
+      num = num_domains;
+    }
+
+  /* one pass takes the next unused core of every domain; once all are */
+  /* used, the cores are handed out again */
+  uint32_t n = 0;
+  while (n < num && num_phys > 0)
+    {
+      uint32_t picked = 0;
+      for (d = 0; d < num_domains && n < num; d++)
+	{
+	  for (i = 0; i < num_phys && (used[i] || topo_domain(phys[i], level) != domains[d]); i++)
+	    ;
+	  if (i < num_phys)
+	    {
+	      used[i] = 1;
+	      cpus[n++] = phys[i];
+	      picked++;
+	    }
+	}
+      if (picked == 0)
+	{
+	  memset(used, 0, topo_num_cpus);
+	}
+    }
+
+  free(phys);
+  free(domains);
+  free(used);
+  return n;
+}
+
+static int
+topo_compact_compare(const void* lhs, const void* rhs)
+{
+  const topo_cpu_t* a = &topo_cpus[*(const uint32_t*) lhs];
+  const topo_cpu_t* b = &topo_cpus[*(const uint32_t*) rhs];
+  const int32_t ka[] = { a->package, a->node, a->l3_set, a->l2_set, a->smt_set, *(const int32_t*) lhs };
+  const int32_t kb[] = { b->package, b->node, b->l3_set, b->l2_set, b->smt_set, *(const int32_t*) rhs };
+  uint32_t k;
+  for (k = 0; k < sizeof(ka) / sizeof(ka[0]); k++)
+    {
+      if (ka[k] != kb[k])
+	{
+	  return (ka[k] < kb[k]) ? -1 : 1;
+	}
+    }
+  return 0;
+}
+
+uint32_t
+topo_compact(uint32_t* cpus, uint32_t num)
+{
+  topo_init();
+  uint32_t* allowed = (uint32_t*) calloc(topo_num_cpus, sizeof(uint32_t));
+  if (allowed == NULL)
+    {
+      perror("calloc");
+      exit(1);
+    }
+  uint32_t num_allowed = topo_allowed(allowed, topo_num_cpus);
+  qsort(allowed, num_allowed, sizeof(uint32_t), topo_compact_compare);
+
+  uint32_t n;
+  for (n = 0; n < num && num_allowed > 0; n++)
+    {
+      cpus[n] = allowed[n % num_allowed];
+    }
+  free(allowed);
+  return n;
+}
+
+int
+topo_parse_level(const char* arg)
+{
+  int level;
+  for (level = 0; level < TOPO_NUM_LEVELS; level++)
+    {
+      if (strcasecmp(arg, topo_level_des[level]) == 0)
+	{
+	  return level;
+	}
+    }
+  fprintf(stderr, "error: unknown level '%s' (socket, node or l3)\n", arg);
+  exit(EXIT_FAILURE);
+}
+
+uint32_t
+topo_num_nodes()
+{
+  topo_init();
+  return topo_nodes;
+}
+
+int32_t
+topo_distance(int32_t a, int32_t b)
+{
+  topo_init();
+  if (a < 0 || b < 0 || (uint32_t) a >= topo_nodes || (uint32_t) b >= topo_nodes)
+    {
+      return -1;
+    }
+  return topo_dist[a][b];
+}
+
+void
+topo_prefer_node(uint32_t cpu)
+{
+  int32_t node = topo_cpu(cpu)->node;
+  if (node < 0 || topo_nodes < 2)
+    {
+      return;
+    }
+#if defined(PLATFORM_NUMA)
+  numa_set_preferred(node);
+#elif defined(__linux__) && defined(SYS_set_mempolicy)
+  const uint32_t bits = 8 * sizeof(unsigned long);
+  unsigned long mask[TOPO_MAX_NODES / (8 * sizeof(unsigned long))] = { 0 };
+  mask[node / bits] |= 1UL << (node % bits);
+  if (syscall(SYS_set_mempolicy, TOPO_MPOL_PREFERRED, mask, TOPO_MAX_NODES + 1) != 0)
+    {
+      perror("set_mempolicy");
+    }
+#endif
+}
+
+void
+topo_print(const uint32_t* cpus, uint32_t num, int verbose)
+{
+  topo_init();
+  uint32_t cpu, online = 0, allowed = 0, packages = 0, l3s = 0, smt = 1;
+  for (cpu = 0; cpu < topo_num_cpus; cpu++)
+    {
+      const topo_cpu_t* t = &topo_cpus[cpu];
+      if (!t->online)
+	{
+	  continue;
+	}
+      online++;
+      allowed += t->allowed;
+      packages = ((uint32_t) t->package + 1 > packages) ? (uint32_t) t->package + 1 : packages;
+      l3s += (t->l3_set == (int32_t) cpu);
+      if (t->smt_set >= 0 && t->smt_set != (int32_t) cpu)
+	{
+	  uint32_t ways = 1, c;
+	  for (c = 0; c < topo_num_cpus; c++)
+	    {
+	      ways += (c != cpu && topo_cpus[c].smt_set == t->smt_set);
+	    }
+	  smt = (ways > smt) ? ways : smt;
+	}
+    }
+  printf("* topology: %u cpus online (%u allowed) / %u package(s) / %u node(s) / %u L3 domain(s) / %u-way SMT\n",
+	 online, allowed, packages, topo_nodes, l3s, smt);
+
+  if (!verbose)
+    {
+      return;
+    }
+  uint32_t i;
+  for (i = 0; i < num; i++)
+    {
+      const topo_cpu_t* t = topo_cpu(cpus[i]);
+      printf("*   cpu %-4u: package %d / die %d / core %d / node %d / smt set %d / L2 set %d / L3 set %d",
+	     cpus[i], t->package, t->die, t->core, t->node, t->smt_set, t->l2_set, t->l3_set);
+      if (i > 0)
+	{
+	  printf(" / %s of cpu %u", topo_relation_des[topo_relation(cpus[0], cpus[i])], cpus[0]);
+	}
+      printf("\n");
+    }
+  uint32_t a, b;
+  for (a = 0; a < topo_nodes && topo_nodes > 1; a++)
+    {
+      printf("*   node %-3u distances:", a);
+      for (b = 0; b < topo_nodes; b++)
+	{
+	  printf(" %3d", topo_dist[a][b]);
+	}
+      printf("\n");
+    }
+}